@@ -22,8 +22,10 @@
 #include <glm/gtc/constants.hpp>
 
 //std
+#include <algorithm>
 #include <chrono>
 #include <iostream>
+#include <limits>
 
 #define MAX_NUM_LIGHTS 4
 #define MIN_NUM_LIGHTS 1
@@ -50,60 +52,37 @@ namespace nekographics {
 		**************/
 		NKDescriptorSetLayout::Builder tmpBuilder = NKDescriptorSetLayout::Builder(m_vkDevice);//temporary builder 
 		tmpBuilder.addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS);//for the UBO 
-
-		//adding in the textures to the descriptor sets 
-		for (int i = 1; i < m_vktexture.textureImageVec.size() + 1; ++i) {
-			tmpBuilder.addBinding(i, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS);
-		}
+		m_materials.addBindings(tmpBuilder);//the material buffer & the texture array, sized up front for any number of textures 
 		globalSetLayout = tmpBuilder.build();//building the set layout 
 
 		/**************
 		Creating Descriptor Sets
 		**************/
+		//every texture is sampled by every draw, so they must be owned by the graphics queue before the first frame 
+		m_vkDevice.getUploadManager().waitIdle();
+
 		globalDescriptorSets.resize(nekographics::NKSwapChain::MAX_FRAMES_IN_FLIGHT);
 		for (int i = 0; i < globalDescriptorSets.size(); i++) {
-
-			std::vector<VkDescriptorImageInfo> imageInfoVec;
-			for (int j = 0; j < m_vktexture.textureImageViewVec.size(); ++j) {
-				//setting the image info 
-				VkDescriptorImageInfo imageInfo{};
-				imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				imageInfo.imageView = m_vktexture.textureImageViewVec[j];
-				imageInfo.sampler = m_vktexture.textureSamplerVec[j];
-				imageInfoVec.emplace_back(imageInfo);
-			}
-
 			//setting the buffer info 
 			auto bufferInfo = uboBuffers[i]->descriptorInfo();
 			nekographics::NkDescriptorWriter tmpWriter = nekographics::NkDescriptorWriter(*globalSetLayout, *globalPool);//creating the temporary writer 
 			tmpWriter.writeBuffer(0, &bufferInfo);//writing buffer into the writer 
-			//adding write image into the writer 
-			for (int k = 1, m = 0; k < m_vktexture.textureImageVec.size() + 1; ++k, ++m) {
-				tmpWriter.writeImage(k, &imageInfoVec[m]);
-			}
 			tmpWriter.build(globalDescriptorSets[i]);//building the descriptor sets 
+			m_materials.attach(globalDescriptorSets[i]);//every texture so far, later ones are written in as they are added 
 		}
 	}
 
-	gameApp::gameApp() {
+	gameApp::gameApp(bool headless) : m_window{ headless ? nullptr : std::make_unique<VkWindow>(WIDTH, HEIGHT) } {
 		/**************
 		Creating Descriptor Pool
 		**************/
-		globalPool =
+		NKDescriptorPool::Builder poolBuilder =
 			NKDescriptorPool::Builder(m_vkDevice)
 			.setMaxSets(NKSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, NKSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, NKSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, NKSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, NKSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, NKSwapChain::MAX_FRAMES_IN_FLIGHT)			
-			
-			//for the vintage textures 
-			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, NKSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, NKSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, NKSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, NKSwapChain::MAX_FRAMES_IN_FLIGHT)
-			.build();
+			.setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT)//the texture array is written while frames are in flight 
+			.addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, NKSwapChain::MAX_FRAMES_IN_FLIGHT);
+		m_materials.addPoolSizes(poolBuilder, NKSwapChain::MAX_FRAMES_IN_FLIGHT);//the material buffer & texture array of every set 
+		globalPool = poolBuilder.build();
 
 	}
 
@@ -115,8 +94,36 @@ namespace nekographics {
 	/***********
 	loading the dds textures 
 	************/
-	void gameApp::loadTextures(const std::string& textures) {
+	uint32_t gameApp::loadTextures(const std::string& textures) {
+		if (STREAM_TEXTURES) {
+			return m_textureStreamer.loadTexture(textures);//mip tail only 
+		}
 		m_vktexture.createTextureImageDDSMIPMAPS(textures);//creating the texture image 
+		return m_materials.addTexture(m_vktexture.textureImageViewVec.back(), m_vktexture.textureSamplerVec.back());
+	}
+
+	/***********
+	Requesting the texture mips for the frame 
+	************/
+	void gameApp::requestTextureMips(NKCamera& camera, NKScene& scene) {
+		//a sphere of radius r at depth d covers r * projection[1][1] * height / d pixels 
+		const float pixelsPerRadius = camera.getProjection()[1][1] * static_cast<float>(m_vkRenderer.getSwapChainExtent().height);
+
+		for (size_t slot = 0; slot < scene.models.size(); ++slot) {
+			const ModelComponent& modelComponent = scene.models.componentAt(slot);
+			if (!modelComponent.model) continue;//still loading 
+
+			const glm::mat4& world = scene.transforms.get(scene.models.entityAt(slot)).worldMatrix();
+			const glm::vec4& sphere = modelComponent.model->getBoundingSphere();
+			float scale = std::max({ glm::length(glm::vec3(world[0])), glm::length(glm::vec3(world[1])), glm::length(glm::vec3(world[2])) });
+			float radius = sphere.w * scale;
+			float depth = (camera.getView() * world * glm::vec4(glm::vec3(sphere), 1.f)).z;
+			if (depth + radius <= 0.f) continue;//behind the camera 
+
+			//inside the sphere it may cover the whole screen, ask for the finest mip 
+			float screenPixels = depth > radius ? radius * pixelsPerRadius / depth : std::numeric_limits<float>::max();
+			m_textureStreamer.requestMaterial(modelComponent.material, screenPixels);
+		}
 	}
 
 	/***********
@@ -149,14 +156,12 @@ namespace nekographics {
 		Setting the lights initial translation 
 		**************/
 		for (int i = 0; i < lightColors.size(); i++) {
-			auto pointLight = NkGameObject::makePointLight(1.f);
-			pointLight.color = lightColors[i];
+			NkEntity pointLight = scene.createPointLight(1.f, 0.1f, lightColors[i]);
 			auto rotateLight = glm::rotate(
 				glm::mat4(1.f),
 				(i * glm::two_pi<float>()) / lightColors.size(),
 				{ 0.f, -1.f, 0.f });
-			pointLight.transform.translation = glm::vec3(rotateLight * glm::vec4(-1.f, -2.f, -1.f, 1.f));
-			gameObjects.emplace(pointLight.getId(), std::move(pointLight));
+			scene.transforms.get(pointLight).translation = glm::vec3(rotateLight * glm::vec4(-1.f, -2.f, -1.f, 1.f));
 		}
 	}
 
@@ -164,9 +169,18 @@ namespace nekographics {
 	Application draw call 
 	************/
 	void gameApp::draw(NKCamera& camera, SimpleRenderSystem& renderer , PointLightSystem& pointLightRenderer,FrameInfo& frameInfo, VkCommandBuffer& commandBuffer) {
-		UNREFERENCED_PARAMETER(camera);
+		frameInfo.jobSystem = &m_jobSystem;//systems split their work over the workers 
+		frameInfo.scene.updateTransforms(frameInfo.jobSystem);//cached world matrices of whatever moved since the last frame 
+
+		if (STREAM_TEXTURES) {
+			requestTextureMips(camera, frameInfo.scene);
+			m_textureStreamer.update(frameInfo.globalDescriptorSet);//swaps in finished mips & starts the next ones 
+		}
+
+		renderer.prepareGameObjects(frameInfo);//gpu driven draw building, has to be recorded outside the render pass 
 
 		//check for begin frame 
+		frameInfo.secondaryPools = m_vkRenderer.getSecondaryCommandPools();//systems record into secondaries when set 
 		m_vkRenderer.beginSwapChainRenderPass(commandBuffer);//begin renderpass
 		renderer.renderGameObjects(frameInfo);
 		pointLightRenderer.render(frameInfo);
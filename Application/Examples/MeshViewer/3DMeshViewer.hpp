@@ -22,6 +22,9 @@
 #include "pointLightSystem.hpp"
 #include "vk_descriptors.hpp"
 #include "vk_texture.hpp"
+#include "vk_material.hpp"
+#include "vk_texturestreamer.hpp"
+#include "vk_jobsystem.hpp"
 
 //std
 #include <memory>
@@ -33,27 +36,33 @@ namespace nekographics {
 	public:
 		static constexpr int WIDTH = 800;
 		static constexpr int HEIGHT = 600;
+		static constexpr bool STREAM_TEXTURES = true;//only the mip tails at load, finer mips stream in as the objects need them 
 
-		gameApp();
+		gameApp(bool headless = false);//headless renders offscreen without creating a window 
 		~gameApp();
 
 		gameApp(const gameApp&) = delete;
 		gameApp& operator=(const gameApp&) = delete;
 
 		void pipelineLayout();//setting the pipeline instance 
-		void loadTextures(const std::string& textures);//loading the texture 
+		uint32_t loadTextures(const std::string& textures);//loading the texture, returns its index in the material table 
+		void requestTextureMips(NKCamera& camera, NKScene& scene);//mips every model's textures need at its size on screen 
 		void loadPointLights(const int& numberOfLights = 1);//loads the game objects
 		void draw(NKCamera& camera, SimpleRenderSystem& renderer, PointLightSystem& pointLightRenderer, FrameInfo& frameInfo,VkCommandBuffer& commandBuffer);//draw call
 
-		VkWindow m_window{ WIDTH,HEIGHT };
-		NKDevice  m_vkDevice{ m_window };
-		NKRenderer m_vkRenderer{ m_window, m_vkDevice };
+		std::unique_ptr<VkWindow> m_window;//null when headless 
+		NKDevice  m_vkDevice{ m_window.get() };
+		NKRenderer m_vkRenderer{ m_window.get(), m_vkDevice, { WIDTH,HEIGHT } };
 		NKTexture m_vktexture{ m_vkDevice };
+		NKMaterialTable m_materials{ m_vkDevice };//every texture & material the shaders index into, bound through the global set 
+		NKTextureStreamer m_textureStreamer{ m_vkDevice, m_materials };//textures loaded with STREAM_TEXTURES 
+		NKModelLoader m_modelLoader{ m_vkDevice };//background model parsing 
+		NKJobSystem m_jobSystem;//worker threads shared by the systems, one less than the hardware threads 
 
 		// note: order of declarations matters
 		std::unique_ptr<NKDescriptorPool> globalPool{};
 		std::unique_ptr<NKDescriptorPool> imagePool{};
-		NkGameObject::Map gameObjects;//stores the map of gameobjects
+		NKScene scene;//entities & their packed components
 
 		std::vector<std::unique_ptr<nekographics::NKBuffer>> uboBuffers;//vector of ubo buffers
 		std::vector<VkDescriptorSet> globalDescriptorSets;//vector of descriptor sets 
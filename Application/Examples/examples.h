@@ -13,4 +13,6 @@
 
 #pragma once
 int meshViewer();
+int headlessBenchmark();
+int jobSystemBenchmark();
 
@@ -0,0 +1,201 @@
+/******************************************************************************/
+/*!
+\file   headlessBenchmark.cpp
+\author Wilfred Ng Jun Hwee
+\par    DP email: junhweewilfred.ng[at]digipen.edu
+\par    course: csd2150
+\par    Final Mesh Viewer
+\date   04/15/2022
+\brief
+	Renders the mesh viewer scene offscreen for a fixed number of frames and
+	reports the frame cost, no window is shown & nothing is presented
+*/
+/******************************************************************************/
+
+//includes
+#include "vk_gameobject.hpp"
+#include "renderer.hpp"
+#include "camera.hpp"
+#include "rendererSystem.hpp"
+#include "pointLightSystem.hpp"
+#include "vk_samplercache.hpp"
+#include "vk_buffer.hpp"
+#include "Examples/MeshViewer/3DMeshViewer.hpp"
+
+//std
+#include <chrono>
+#include <iostream>
+
+#define BENCHMARK_WARMUP_FRAMES 16
+#define BENCHMARK_FRAMES 512
+#define BENCHMARK_VERTEX_FORMAT nekographics::NKModel::VertexFormat::Full//Packed to measure the quantized vertices 
+#define BENCHMARK_OPTIMIZE_MESHES false//true to reorder the meshes for the vertex cache & overdraw on import 
+#define BENCHMARK_SKULL_COPIES 0//extra skulls sharing the skull model, 10000 to measure the instanced path 
+#define BENCHMARK_GPU_DRIVEN false//true to build the draws with compute & draw them indirectly 
+#define BENCHMARK_OCCLUSION_CULLING true//gpu driven only, culls against a depth pyramid of the previous frame 
+#define BENCHMARK_RECORDING_THREADS 0//threads recording the render pass into secondary command buffers, 0 records inline 
+
+int headlessBenchmark() {
+
+	//creating all vulkan without a surface
+	nekographics::gameApp application{ true };
+
+	/**************
+	Loading Textures
+	**************/
+	nekographics::NKMaterial skullMaterial{};
+	skullMaterial.normalTexture = application.loadTextures("Textures/dds/TD_Checker_Normal_OpenGL.dds");
+	skullMaterial.diffuseTexture = application.loadTextures("Textures/dds/TD_Checker_Base_Color.dds");
+	skullMaterial.aoTexture = application.loadTextures("Textures/dds/TD_Checker_Mixed_AO.dds");
+	skullMaterial.roughnessTexture = application.loadTextures("Textures/dds/TD_Checker_Roughness.dds");
+
+	nekographics::NKMaterial carMaterial{};
+	carMaterial.normalTexture = application.loadTextures("Textures/dds/_Normal_DirectX.dds");
+	carMaterial.diffuseTexture = application.loadTextures("Textures/dds/_Base_Color.dds");
+	carMaterial.aoTexture = application.loadTextures("Textures/dds/_Mixed_AO.dds");
+	carMaterial.roughnessTexture = application.loadTextures("Textures/dds/_Roughness.dds");
+
+	uint32_t skullMaterialIndex = application.m_materials.addMaterial(skullMaterial);
+	uint32_t carMaterialIndex = application.m_materials.addMaterial(carMaterial);
+
+	application.pipelineLayout();//setting up the pipeline
+
+	/**************
+	Same scene as the mesh viewer
+	**************/
+	nekographics::NKScene& scene = application.scene;
+
+	auto skull = scene.createEntity();
+	nekographics::NKModelFuture skullModel = application.m_modelLoader.loadAssimpModel("Models/FBX/Skull_textured.fbx", BENCHMARK_VERTEX_FORMAT, BENCHMARK_OPTIMIZE_MESHES);
+	scene.models.add(skull).pendingModel = skullModel;
+	scene.models.get(skull).material = skullMaterialIndex;
+	scene.transforms.get(skull).scale = { 0.01, 0.01, 0.01f };
+
+	auto vintageCar = scene.createEntity();
+	scene.models.add(vintageCar).pendingModel = application.m_modelLoader.loadAssimpModel("Models/FBX/_2_Vintage_Car_01_low.fbx", BENCHMARK_VERTEX_FORMAT, BENCHMARK_OPTIMIZE_MESHES);
+	scene.models.get(vintageCar).material = carMaterialIndex;
+	scene.transforms.get(vintageCar).translation = { 0.0f, 0.0f, -8.0f };
+	scene.transforms.get(vintageCar).scale = { 0.5f, 0.5f, 0.5f };
+
+	auto floor = scene.createEntity();
+	scene.models.add(floor).model = nekographics::NKModel::processMesh(application.m_vkDevice, xprim_geom::cube::Generate(4, 4, 4, 4, xprim_geom::float3{ 1,1,1 }), BENCHMARK_VERTEX_FORMAT, BENCHMARK_OPTIMIZE_MESHES);
+	scene.models.get(floor).material = carMaterialIndex;
+	scene.transforms.get(floor).translation = { 0.f, 2.f, 0.f };
+	scene.transforms.get(floor).scale = { 20.0, 0.1f, 20.f };
+
+	//a grid of copies behind the scene, drawn as one instanced draw per pipeline 
+	scene.transforms.reserve(scene.getEntityCount() + BENCHMARK_SKULL_COPIES);
+	scene.models.reserve(scene.models.size() + BENCHMARK_SKULL_COPIES);
+	for (int i = 0; i < BENCHMARK_SKULL_COPIES; ++i) {
+		auto copy = scene.createEntity();
+		scene.models.add(copy).pendingModel = skullModel;
+		scene.models.get(copy).material = skullMaterialIndex;
+		auto& transform = scene.transforms.get(copy);
+		transform.translation = { static_cast<float>(i % 100) * 0.5f - 25.f, static_cast<float>(i / 100 % 10) * -0.5f, -10.f - static_cast<float>(i / 1000) * 0.5f };
+		transform.scale = { 0.005f, 0.005f, 0.005f };
+	}
+
+	application.loadPointLights(2);//loading point lights
+
+	//every frame should draw the full scene, so finish loading before timing 
+	application.m_modelLoader.waitAll();
+
+	nekographics::SimpleRenderSystem simpleRenderSystem{ application.m_vkDevice, application.m_vkRenderer.getSwapChainRenderPass() , application.globalSetLayout->getDescriptorSetLayout() };
+	nekographics::PointLightSystem pointLightSystem{ application.m_vkDevice,application.m_vkRenderer.getSwapChainRenderPass(),application.globalSetLayout->getDescriptorSetLayout() };
+	simpleRenderSystem.precompilePipelines(&application.m_jobSystem);//every variant now, no compile on the frame that first needs one 
+	simpleRenderSystem.setGpuDriven(BENCHMARK_GPU_DRIVEN);
+	application.m_vkRenderer.setSecondaryRecording(BENCHMARK_RECORDING_THREADS);
+	if (simpleRenderSystem.isGpuDriven() && BENCHMARK_OCCLUSION_CULLING) {
+		application.m_vkRenderer.setDepthPyramidEnabled(true);
+		simpleRenderSystem.setDepthPyramid(application.m_vkRenderer.getDepthPyramid());
+	}
+	application.m_vkDevice.printPipelineCacheStats();//the second run creates them from the cache the first one saved 
+	auto& samplerCache = application.m_vkDevice.getSamplerCache();
+	std::cout << "samplers: " << samplerCache.getSamplerCount() << " created for " << samplerCache.getRequestCount() << " requests" << std::endl;
+
+	//fixed camera so every run renders the same frames
+	nekographics::NKCamera camera{};
+	glm::vec3 cameraPosition = { 0.f,0.f,5.f };
+	camera.setViewTarget(cameraPosition, glm::vec3(0.f, 0.f, 0.f));
+	camera.setPerspectiveProjection(glm::radians(50.f), application.m_vkRenderer.getAspectRatio(), 0.1f, 100.f);
+
+	/***********
+	Frame Loop
+	************/
+	const float frameTime = 1.f / 60.f;//fixed step so the lights animate deterministically
+	std::chrono::high_resolution_clock::time_point startTime{};
+
+	for (int frame = 0; frame < BENCHMARK_WARMUP_FRAMES + BENCHMARK_FRAMES; ++frame) {
+		//only time the frames after the warm up
+		if (frame == BENCHMARK_WARMUP_FRAMES) {
+			vkDeviceWaitIdle(application.m_vkDevice.device());
+			startTime = std::chrono::high_resolution_clock::now();
+		}
+
+		if (auto commandBuffer = application.m_vkRenderer.beginFrame()) {
+			int frameIndex = application.m_vkRenderer.getFrameIndex();
+			nekographics::FrameInfo frameInfo{
+			  frameIndex,
+			  frameTime,
+			  commandBuffer,
+			  camera,
+			  application.globalDescriptorSets[frameIndex],
+			  scene };
+
+			nekographics::GlobalUbo ubo{};
+			ubo.projection = camera.getProjection();
+			ubo.view = camera.getView();
+			ubo.inverseView = camera.getInverseView();
+			ubo.cameraEyePos = { cameraPosition ,1.f };
+
+			pointLightSystem.update(frameInfo, ubo);
+			application.uboBuffers[frameIndex]->writeToBuffer(&ubo);
+			application.uboBuffers[frameIndex]->flush();
+
+			//read the very last frame back so it can be checked
+			application.m_vkRenderer.setReadbackEnabled(frame == BENCHMARK_WARMUP_FRAMES + BENCHMARK_FRAMES - 1);
+			application.draw(camera, simpleRenderSystem, pointLightSystem, frameInfo, commandBuffer);
+		}
+	}
+
+	vkDeviceWaitIdle(application.m_vkDevice.device());//include the gpu work of the last frames
+	auto endTime = std::chrono::high_resolution_clock::now();
+
+	float totalMs = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+	std::cout << "headless benchmark: " << BENCHMARK_FRAMES << " frames in " << totalMs << " ms, "
+		<< totalMs / BENCHMARK_FRAMES << " ms/frame, "
+		<< 1000.f * BENCHMARK_FRAMES / totalMs << " fps" << std::endl;
+
+	const auto& stats = simpleRenderSystem.getCullingStats();
+	std::cout << "culling: " << stats.objects << " objects, "
+		<< stats.frustumCulledObjects << " frustum culled, "
+		<< stats.occlusionCulledObjects << " occlusion culled, "
+		<< stats.frustumCulledMeshes + stats.occlusionCulledMeshes << " child meshes culled";
+	if (simpleRenderSystem.isGpuDriven()) {
+		std::cout << ", " << stats.visibleInstances << " instances in " << stats.visibleDraws << "/" << stats.draws << " draws";
+	}
+	std::cout << std::endl;
+
+	if (!simpleRenderSystem.isGpuDriven()) {
+		const auto& binds = simpleRenderSystem.getBindStats();
+		std::cout << "binds: " << binds.pipelineBinds << " pipeline (" << binds.pipelineBindsSkipped << " skipped), "
+			<< binds.geometryBinds << " geometry (" << binds.geometryBindsSkipped << " skipped)" << std::endl;
+	}
+
+	if (nekographics::gameApp::STREAM_TEXTURES) {
+		auto streaming = application.m_textureStreamer.getStats();
+		std::cout << "textures: " << streaming.textures << " streamed, "
+			<< streaming.residentBytes / 1024 << "/" << streaming.fullBytes / 1024 << " KB resident, "
+			<< streaming.mipsStreamedIn << " mips streamed in, " << streaming.mipsEvicted << " evicted, "
+			<< streaming.budgetMisses << " budget misses" << std::endl;
+	}
+
+	application.m_vkDevice.printAllocatorStats();
+
+	std::vector<uint8_t> pixels;
+	if (application.m_vkRenderer.readLastFrame(pixels)) {
+		std::cout << "read back " << pixels.size() << " bytes of the last frame" << std::endl;
+	}
+
+	return 0;
+}
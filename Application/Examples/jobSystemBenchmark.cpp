@@ -0,0 +1,118 @@
+/******************************************************************************/
+/*!
+\file   jobSystemBenchmark.cpp
+\author Wilfred Ng Jun Hwee
+\par    DP email: junhweewilfred.ng[at]digipen.edu
+\par    course: csd2150
+\par    Final Mesh Viewer
+\date   04/15/2022
+\brief
+	Runs the same batch of small tasks serially, on one std::thread per task
+	and on the job system, then reports the throughput of each. No vulkan
+*/
+/******************************************************************************/
+
+//includes
+#include "vk_jobsystem.hpp"
+
+//std
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#define JOB_BENCHMARK_TASKS 2048
+#define JOB_BENCHMARK_TASK_ITERATIONS 2000//work per task, about what culling a few hundred objects costs
+#define JOB_BENCHMARK_ROUNDS 8
+#define JOB_BENCHMARK_WORKERS 0//0 picks one less than the hardware threads
+
+namespace {
+	//a task's result is written out so the work can't be optimised away
+	void runTask(uint32_t task, std::vector<float>& results) {
+		float sum = 0.f;
+		for (uint32_t i = 0; i < JOB_BENCHMARK_TASK_ITERATIONS; ++i) {
+			sum += std::sin(static_cast<float>(task + i) * 0.001f);
+		}
+		results[task] = sum;
+	}
+
+	//best of the rounds, the first round also pays for the page faults
+	float measure(const char* name, const std::function<void()>& batch) {
+		float bestMs = 0.f;
+		for (uint32_t round = 0; round < JOB_BENCHMARK_ROUNDS; ++round) {
+			auto startTime = std::chrono::high_resolution_clock::now();
+			batch();
+			auto endTime = std::chrono::high_resolution_clock::now();
+			float ms = std::chrono::duration<float, std::chrono::milliseconds::period>(endTime - startTime).count();
+			bestMs = round == 0 ? ms : std::min(bestMs, ms);
+		}
+
+		std::cout << name << ": " << bestMs << " ms, "
+			<< 1000.f * JOB_BENCHMARK_TASKS / bestMs << " tasks/s" << std::endl;
+		return bestMs;
+	}
+}
+
+int jobSystemBenchmark() {
+	std::vector<float> results(JOB_BENCHMARK_TASKS);
+	nekographics::NKJobSystem jobSystem{ JOB_BENCHMARK_WORKERS };
+
+	std::cout << "job system benchmark: " << JOB_BENCHMARK_TASKS << " tasks of " << JOB_BENCHMARK_TASK_ITERATIONS
+		<< " iterations, " << jobSystem.getThreadCount() << " job threads" << std::endl;
+
+	float serialMs = measure("serial", [&] {
+		for (uint32_t task = 0; task < JOB_BENCHMARK_TASKS; ++task) {
+			runTask(task, results);
+		}
+	});
+
+	float threadMs = measure("std::thread per task", [&] {
+		std::vector<std::thread> threads;
+		threads.reserve(JOB_BENCHMARK_TASKS);
+		for (uint32_t task = 0; task < JOB_BENCHMARK_TASKS; ++task) {
+			threads.emplace_back(runTask, task, std::ref(results));
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	});
+
+	float jobMs = measure("job per task", [&] {
+		nekographics::NKJobCounter counter;
+		for (uint32_t task = 0; task < JOB_BENCHMARK_TASKS; ++task) {
+			jobSystem.run([task, &results] { runTask(task, results); }, &counter);
+		}
+		jobSystem.wait(counter);
+	});
+
+	float parallelForMs = measure("parallelFor, 32 tasks per job", [&] {
+		jobSystem.parallelFor(JOB_BENCHMARK_TASKS, 32, [&results](uint32_t begin, uint32_t end) {
+			for (uint32_t task = begin; task < end; ++task) {
+				runTask(task, results);
+			}
+		});
+	});
+
+	//every job spawns a follow up & one last job waits on all of them, like a system waiting on another's results
+	float dependencyMs = measure("jobs spawning jobs + dependency", [&] {
+		nekographics::NKJobCounter counter;
+		nekographics::NKJobCounter done;
+		for (uint32_t task = 0; task < JOB_BENCHMARK_TASKS; task += 2) {
+			jobSystem.run([task, &results, &jobSystem, &counter] {
+				runTask(task, results);
+				jobSystem.run([task, &results] { runTask(task + 1, results); }, &counter);
+			}, &counter);
+		}
+		jobSystem.runAfter(counter, [] {}, &done);
+		jobSystem.wait(done);
+	});
+
+	std::cout << "speed up over serial: std::thread " << serialMs / threadMs
+		<< "x, jobs " << serialMs / jobMs
+		<< "x, parallelFor " << serialMs / parallelForMs
+		<< "x, dependencies " << serialMs / dependencyMs << "x" << std::endl;
+	return 0;
+}
@@ -33,41 +33,48 @@ int meshViewer() {
 	nekographics::gameApp application{};
 
 	//showing the window
-	application.m_window.showWindow();
+	application.m_window->showWindow();
 
 	/**************
 	Loading Textures
 	**************/
 	//for the skull
-	application.loadTextures("Textures/dds/TD_Checker_Normal_OpenGL.dds");		//loading texture : Normal Map
-	application.loadTextures("Textures/dds/TD_Checker_Base_Color.dds");			//loading texture : Diffuse 
-	application.loadTextures("Textures/dds/TD_Checker_Mixed_AO.dds");			//loading texture : Ambient Occlusion
-	application.loadTextures("Textures/dds/TD_Checker_Roughness.dds");			//loading texture : Roughness
+	nekographics::NKMaterial skullMaterial{};
+	skullMaterial.normalTexture = application.loadTextures("Textures/dds/TD_Checker_Normal_OpenGL.dds");		//loading texture : Normal Map
+	skullMaterial.diffuseTexture = application.loadTextures("Textures/dds/TD_Checker_Base_Color.dds");			//loading texture : Diffuse 
+	skullMaterial.aoTexture = application.loadTextures("Textures/dds/TD_Checker_Mixed_AO.dds");				//loading texture : Ambient Occlusion
+	skullMaterial.roughnessTexture = application.loadTextures("Textures/dds/TD_Checker_Roughness.dds");		//loading texture : Roughness
 
 	//for the vintage car 
-	application.loadTextures("Textures/dds/_Normal_DirectX.dds");				//loading texture : Normal Map
-	application.loadTextures("Textures/dds/_Base_Color.dds");					//loading texture : Diffuse 
-	application.loadTextures("Textures/dds/_Mixed_AO.dds");						//loading texture : Ambient Occlusion
-	application.loadTextures("Textures/dds/_Roughness.dds");					//loading texture : Roughness
+	nekographics::NKMaterial carMaterial{};
+	carMaterial.normalTexture = application.loadTextures("Textures/dds/_Normal_DirectX.dds");				//loading texture : Normal Map
+	carMaterial.diffuseTexture = application.loadTextures("Textures/dds/_Base_Color.dds");					//loading texture : Diffuse 
+	carMaterial.aoTexture = application.loadTextures("Textures/dds/_Mixed_AO.dds");						//loading texture : Ambient Occlusion
+	carMaterial.roughnessTexture = application.loadTextures("Textures/dds/_Roughness.dds");				//loading texture : Roughness
+
+	//objects pick their textures by material index, any number of them share the same pipelines 
+	uint32_t skullMaterialIndex = application.m_materials.addMaterial(skullMaterial);
+	uint32_t carMaterialIndex = application.m_materials.addMaterial(carMaterial);
 
 	application.pipelineLayout();//setting up the pipeline 
 
 	/**************
 	Creating FBX model
 	**************/
-	std::shared_ptr<nekographics::NKModel> skullModel = nekographics::NKModel::createAssimpModelFromFile(application.m_vkDevice, "Models/FBX/Skull_textured.fbx"); // skull model
-	auto skull = nekographics::NkGameObject::createGameObject();
-	skull.model = skullModel;
-	skull.transform.translation = { 0.f, 0.f, 0.f };
-	skull.transform.scale = { 0.01, 0.01, 0.01f };
-	application.gameObjects.emplace(skull.getId(), std::move(skull));
-
-	std::shared_ptr<nekographics::NKModel> vintageCarModel = nekographics::NKModel::createAssimpModelFromFile(application.m_vkDevice, "Models/FBX/_2_Vintage_Car_01_low.fbx"); // car model 
-	auto vintageCar = nekographics::NkGameObject::createGameObject();
-	vintageCar.model = vintageCarModel;
-	vintageCar.transform.translation = { 0.0f, 0.0f, -8.0f };
-	vintageCar.transform.scale = { 0.5f, 0.5f, 0.5f };
-	application.gameObjects.emplace(vintageCar.getId(), std::move(vintageCar));
+	//both files are parsed in parallel on the loader threads, the objects show up once their model is ready 
+	nekographics::NKScene& scene = application.scene;
+
+	auto skull = scene.createEntity();
+	scene.models.add(skull).pendingModel = application.m_modelLoader.loadAssimpModel("Models/FBX/Skull_textured.fbx"); // skull model
+	scene.models.get(skull).material = skullMaterialIndex;
+	scene.transforms.get(skull).translation = { 0.f, 0.f, 0.f };
+	scene.transforms.get(skull).scale = { 0.01, 0.01, 0.01f };
+
+	auto vintageCar = scene.createEntity();
+	scene.models.add(vintageCar).pendingModel = application.m_modelLoader.loadAssimpModel("Models/FBX/_2_Vintage_Car_01_low.fbx"); // car model 
+	scene.models.get(vintageCar).material = carMaterialIndex;
+	scene.transforms.get(vintageCar).translation = { 0.0f, 0.0f, -8.0f };
+	scene.transforms.get(vintageCar).scale = { 0.5f, 0.5f, 0.5f };
 
 	/**************
 	Creating Mesh
@@ -77,11 +84,11 @@ int meshViewer() {
 		xprim_geom::cube::Generate(4, 4, 4, 4, xprim_geom::float3{ 1,1,1 }); glm::vec2 UVScale{ 1,1 };
 	std::shared_ptr<nekographics::NKModel> customModel =
 		nekographics::NKModel::processMesh(application.m_vkDevice, floorMesh);
-	auto customFloorMesh = nekographics::NkGameObject::createGameObject();
-	customFloorMesh.model = customModel;
-	customFloorMesh.transform.translation = { 0.f, 2.f, 0.f };
-	customFloorMesh.transform.scale = { 20.0, 0.1f, 20.f };
-	application.gameObjects.emplace(customFloorMesh.getId(), std::move(customFloorMesh));
+	auto customFloorMesh = scene.createEntity();
+	scene.models.add(customFloorMesh).model = customModel;
+	scene.models.get(customFloorMesh).material = carMaterialIndex;
+	scene.transforms.get(customFloorMesh).translation = { 0.f, 2.f, 0.f };
+	scene.transforms.get(customFloorMesh).scale = { 20.0, 0.1f, 20.f };
 
 	application.loadPointLights(2);//loading point lights
 
@@ -90,16 +97,17 @@ int meshViewer() {
 	************/
 	nekographics::SimpleRenderSystem simpleRenderSystem{ application.m_vkDevice, application.m_vkRenderer.getSwapChainRenderPass() , application.globalSetLayout->getDescriptorSetLayout()};
 	nekographics::PointLightSystem pointLightSystem{ application.m_vkDevice,application.m_vkRenderer.getSwapChainRenderPass(),application.globalSetLayout->getDescriptorSetLayout() };
+	simpleRenderSystem.precompilePipelines(&application.m_jobSystem);//every variant now, no compile on the frame that first needs one 
 
 	nekographics::NKCamera camera{};//creating the camera 
 
 	glm::vec3 cameraStartingPosition = { 0.f,0.f,5.f };
 	camera.setViewTarget(cameraStartingPosition, glm::vec3(0.f, 0.f, 0.f));
 
-	//getting the viewer object 
-	auto viewerObject = nekographics::NkGameObject::createGameObject();
-	viewerObject.transform.translation = cameraStartingPosition;
-	viewerObject.transform.rotation = { 0.f,3.14f,0.f };//setting the starting rotation of the camera to face obj 
+	//the viewer isn't part of the scene, it only needs a transform 
+	nekographics::TransformComponent viewerTransform{};
+	viewerTransform.translation = cameraStartingPosition;
+	viewerTransform.rotation = { 0.f,3.14f,0.f };//setting the starting rotation of the camera to face obj 
 	nekographics::KeyboardMovementController cameraController{};
 
 	auto currentTime = std::chrono::high_resolution_clock::now();//setting the current time 
@@ -107,13 +115,15 @@ int meshViewer() {
 	/***********
 	Game Loop
 	************/
-	while (!application.m_window.closeWindow()) {
+	while (!application.m_window->closeWindow()) {
 
 		/***********
 		Input Manager
 		************/
 		InputManager.update();//update the input manager
 
+		application.m_modelLoader.update();//create the models that finished parsing 
+
 		/***********
 		Calculating DT
 		************/
@@ -125,23 +135,23 @@ int meshViewer() {
 		Camera
 		************/
 		if (cameraController.firstPerson) {
-			cameraController.moveInPlaneXZ(&application.m_window, frameTime, viewerObject);//calculating camera controller 
-			camera.setViewYXZ(viewerObject.transform.translation, viewerObject.transform.rotation);
+			cameraController.moveInPlaneXZ(application.m_window.get(), frameTime, viewerTransform);//calculating camera controller 
+			camera.setViewYXZ(viewerTransform.translation, viewerTransform.rotation);
 		}
 		else {
 			//if you're looking at the first model
 			if (cameraController.modelNumber) {
-				cameraController.moveThirdPerson(frameTime, application.gameObjects,viewerObject);
-				camera.setViewTarget(viewerObject.transform.translation, application.gameObjects[0].transform.translation);//setting the view target 
+				cameraController.moveThirdPerson(frameTime, scene, viewerTransform);
+				camera.setViewTarget(viewerTransform.translation, scene.transforms.get(skull).translation);//setting the view target 
 			}
 			else {
-				cameraController.moveThirdPerson(frameTime, application.gameObjects, viewerObject);
-				camera.setViewTarget(viewerObject.transform.translation, application.gameObjects[1].transform.translation);//setting the view target 
+				cameraController.moveThirdPerson(frameTime, scene, viewerTransform);
+				camera.setViewTarget(viewerTransform.translation, scene.transforms.get(vintageCar).translation);//setting the view target 
 			}
 		}
 
 		//checking it's minimised 
-		if (!application.m_window.isMinimised()) {
+		if (!application.m_window->isMinimised()) {
 			float aspect = application.m_vkRenderer.getAspectRatio();
 			//check if nan
 			if (!std::isnan(aspect)) {
@@ -149,13 +159,13 @@ int meshViewer() {
 			}
 		}
 
-		pointLightSystem.inputUpdate(viewerObject);//update light with input 
+		pointLightSystem.inputUpdate(viewerTransform);//update light with input 
 		
-		if (!application.m_window.Update()) {
+		if (!application.m_window->Update()) {
 			/***********
 			Draw
 			************/
-			if (application.m_window.mCanRender && !application.m_window.isMinimised()) {
+			if (application.m_window->mCanRender && !application.m_window->isMinimised()) {
 				if (auto commandBuffer = application.m_vkRenderer.beginFrame()) {
 					int frameIndex = application.m_vkRenderer.getFrameIndex();
 					nekographics::FrameInfo frameInfo{
@@ -164,14 +174,14 @@ int meshViewer() {
 					  commandBuffer,
 					  camera,
 					  application.globalDescriptorSets[frameIndex],
-					  application.gameObjects };
+					  scene };
 
 					// updates
 					nekographics::GlobalUbo ubo{};
 					ubo.projection = camera.getProjection();
 					ubo.view = camera.getView();
 					ubo.inverseView = camera.getInverseView();
-					ubo.cameraEyePos = { viewerObject.transform.translation ,1.f };
+					ubo.cameraEyePos = { viewerTransform.translation ,1.f };
 
 					pointLightSystem.update(frameInfo, ubo);//point light system update 
 					application.uboBuffers[frameIndex]->writeToBuffer(&ubo);
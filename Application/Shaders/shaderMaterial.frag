@@ -1,10 +1,12 @@
 #version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout (location = 0) in vec4 fragColor;
 layout (location = 1) in vec3 fragPosWorld;
 layout (location = 2) in vec3 fragNormalWorld;
 layout (location = 3) in vec2 fragTexCoord;
 layout (location = 4) in mat3 outT2W;
+layout (location = 7) flat in uint fragMaterial;                                                      // into the material buffer
 
 layout (location = 0) out vec4 outFragColor;
 
@@ -23,10 +25,19 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
   int numLights;
 } ubo;
 
-layout(set = 0, binding = 1) uniform sampler2D SamplerNormalMap;		                                     // [INPUT_TEXTURE_NORMAL]
-layout(set = 0, binding = 2) uniform sampler2D SamplerDiffuseMap;		                                     // [INPUT_TEXTURE_DIFFUSE]
-layout(set = 0, binding = 3) uniform sampler2D SamplerAOMap;			                                       // [INPUT_TEXTURE_AO]
-layout(set = 0, binding = 4) uniform sampler2D SamplerRoughnessMap;	                                     // [INPUT_TEXTURE_ROUGHNESS]
+// matches NKMaterial, indices into textures
+struct Material {
+  uint normalTexture;                                                                                    // [INPUT_TEXTURE_NORMAL]
+  uint diffuseTexture;                                                                                   // [INPUT_TEXTURE_DIFFUSE]
+  uint aoTexture;                                                                                        // [INPUT_TEXTURE_AO]
+  uint roughnessTexture;                                                                                 // [INPUT_TEXTURE_ROUGHNESS]
+};
+
+layout(std430, set = 0, binding = 1) readonly buffer MaterialBuffer {
+  Material materials[];
+} materialBuffer;
+
+layout(set = 0, binding = 2) uniform sampler2D textures[];                                               // every texture of the material table
 
 layout(push_constant) uniform Push {
   mat4 modelMatrix;
@@ -35,8 +46,11 @@ layout(push_constant) uniform Push {
 
 void main() {
 
+  // the instances of one draw may use different materials, so the indices aren't uniform
+  const Material material = materialBuffer.materials[fragMaterial];
+
 	vec3 Normal;                                                                                          // get the normal from a compress texture BC5
-	Normal.xy	= (texture(SamplerNormalMap, fragTexCoord).gr * 2.0) - 1.0;// For BC5 it used (rg)
+	Normal.xy	= (texture(textures[nonuniformEXT(material.normalTexture)], fragTexCoord).gr * 2.0) - 1.0;// For BC5 it used (rg)
 	
 	// Derive the final element (all in Tangent space)
   // x^2 + y^2 + z^2 = 1
@@ -52,9 +66,9 @@ void main() {
   vec4 worldEyeSpacePos = ubo.cameraEyePos;
 
   // Load Textures
-  const vec3  Albedo          = texture(SamplerDiffuseMap, fragTexCoord).rgb;
-  const float Shininess       = mix( 1, 100, 1 - texture( SamplerRoughnessMap, fragTexCoord).r );       //80 preset 
-  const vec3  SamplerAOColor  = texture(SamplerAOMap, fragTexCoord).rgb;
+  const vec3  Albedo          = texture(textures[nonuniformEXT(material.diffuseTexture)], fragTexCoord).rgb;
+  const float Shininess       = mix( 1, 100, 1 - texture( textures[nonuniformEXT(material.roughnessTexture)], fragTexCoord).r );       //80 preset 
+  const vec3  SamplerAOColor  = texture(textures[nonuniformEXT(material.aoTexture)], fragTexCoord).rgb;
 
 	// Different techniques to do Lighting
   vec3 TotalLight     = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w;
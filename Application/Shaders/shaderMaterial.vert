@@ -12,6 +12,7 @@ layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
 layout(location = 3) out vec2 fragTexCoord;
 layout(location = 4) out mat3 outT2W;
+layout(location = 7) flat out uint fragMaterial;     // outT2W takes 4 to 6
 
 struct PointLight {
   vec4 position; // ignore w
@@ -28,11 +29,6 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
   int numLights;
 } ubo;
 
-layout(set = 0, binding = 1) uniform sampler2D SamplerNormalMap;		// [INPUT_TEXTURE_NORMAL]
-layout(set = 0, binding = 2) uniform sampler2D SamplerDiffuseMap;		// [INPUT_TEXTURE_DIFFUSE]
-layout(set = 0, binding = 3) uniform sampler2D SamplerAOMap;			  // [INPUT_TEXTURE_AO]
-layout(set = 0, binding = 4) uniform sampler2D SamplerRoughnessMap;	// [INPUT_TEXTURE_ROUGHNESS]
-
 layout(push_constant) uniform Push {
   mat4 modelMatrix;
   mat4 normalMatrix;
@@ -48,6 +44,7 @@ void main() {
   outT2W                  = mat3(push.modelMatrix) * mat3(tangent, BiTangent, normal);
   fragColor               = pow( vec4(color,1.0), Gamma.rrrr );    // SRGB to RGB
   fragTexCoord            = uv;
+  fragMaterial            = uint(push.normalMatrix[3][3]);    // the renderer packs the material index there
   vec4 positionWorld      = push.modelMatrix * vec4(position, 1.0);
   fragPosWorld            = positionWorld.xyz;
   gl_Position             = ubo.projection * ubo.view * positionWorld;
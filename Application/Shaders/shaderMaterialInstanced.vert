@@ -12,43 +12,46 @@ layout(location = 1) out vec3 fragPosWorld;
 layout(location = 2) out vec3 fragNormalWorld;
 layout(location = 3) out vec2 fragTexCoord;
 layout(location = 4) out mat3 outT2W;
+layout(location = 7) flat out uint fragMaterial;     // outT2W takes 4 to 6
 
 struct PointLight {
-  vec4 position;                                                    // ignore w
-  vec4 color;                                                       // w is intensity
+  vec4 position; // ignore w
+  vec4 color; // w is intensity
 };
 
 layout(set = 0, binding = 0) uniform GlobalUbo {
   mat4 projection;
   mat4 view;
-  mat4 invView;                                                     // stores the inverse view matrix   
-  vec4 ambientLightColor;                                           // w is intensity
-  vec4 cameraEyePos;                                                //position of the camera 
+  mat4 invView;                       // stores the inverse view matrix 
+  vec4 ambientLightColor; // w is intensity
+  vec4 cameraEyePos;//position of the camera 
   PointLight pointLights[10];
   int numLights;
 } ubo;
 
-layout(set = 0, binding = 5) uniform sampler2D SamplerNormalMap;		// [INPUT_TEXTURE_NORMAL]
-layout(set = 0, binding = 6) uniform sampler2D SamplerDiffuseMap;		// [INPUT_TEXTURE_DIFFUSE]
-layout(set = 0, binding = 7) uniform sampler2D SamplerAOMap;			  // [INPUT_TEXTURE_AO]
-layout(set = 0, binding = 8) uniform sampler2D SamplerRoughnessMap;	// [INPUT_TEXTURE_ROUGHNESS]
-
-layout(push_constant) uniform Push {
+// one entry per drawn copy, gl_InstanceIndex already includes the draw's firstInstance
+struct Instance {
   mat4 modelMatrix;
   mat4 normalMatrix;
-} push;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer InstanceBuffer {
+  Instance instances[];
+} instanceBuffer;
 
 void main() {
+  const mat4 modelMatrix = instanceBuffer.instances[gl_InstanceIndex].modelMatrix;
   const float Gamma = ubo.view[3][3];
 
   // Decompress the binormal
   vec3 BiTangent               = normalize(cross(tangent, normal));
 
   // Compute lighting information
-  outT2W                  = mat3(push.modelMatrix) * mat3(tangent, BiTangent, normal);
+  outT2W                  = mat3(modelMatrix) * mat3(tangent, BiTangent, normal);
   fragColor               = pow( vec4(color,1.0), Gamma.rrrr );    // SRGB to RGB
   fragTexCoord            = uv;
-  vec4 positionWorld      = push.modelMatrix * vec4(position, 1.0);
+  fragMaterial            = uint(instanceBuffer.instances[gl_InstanceIndex].normalMatrix[3][3]);    // the renderer packs the material index there
+  vec4 positionWorld      = modelMatrix * vec4(position, 1.0);
   fragPosWorld            = positionWorld.xyz;
   gl_Position             = ubo.projection * ubo.view * positionWorld;
 }
\ No newline at end of file
@@ -0,0 +1,68 @@
+#version 450
+
+// NKModel::PackedVertex, formats are unpacked by the vertex fetch
+layout(location = 0) in vec3 position;
+layout(location = 1) in vec2 normalOct;         // R16G16_SNORM octahedral
+layout(location = 2) in vec4 tangentOct;        // R8G8B8A8_SNORM octahedral xy, z = bitangent sign
+layout(location = 3) in vec2 uv;                // R16G16_SFLOAT
+layout(location = 4) in vec4 color;             // R8G8B8A8_UNORM
+
+layout(location = 0) out vec4 fragColor;
+layout(location = 1) out vec3 fragPosWorld;
+layout(location = 2) out vec3 fragNormalWorld;
+layout(location = 3) out vec2 fragTexCoord;
+layout(location = 4) out mat3 outT2W;
+layout(location = 7) flat out uint fragMaterial;     // outT2W takes 4 to 6
+
+struct PointLight {
+  vec4 position; // ignore w
+  vec4 color; // w is intensity
+};
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+  mat4 projection;
+  mat4 view;
+  mat4 invView;                       // stores the inverse view matrix 
+  vec4 ambientLightColor; // w is intensity
+  vec4 cameraEyePos;//position of the camera 
+  PointLight pointLights[10];
+  int numLights;
+} ubo;
+
+// one entry per drawn copy, gl_InstanceIndex already includes the draw's firstInstance
+struct Instance {
+  mat4 modelMatrix;
+  mat4 normalMatrix;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer InstanceBuffer {
+  Instance instances[];
+} instanceBuffer;
+
+// Octahedral [-1,1]^2 back to a unit vector
+vec3 octDecode(vec2 e) {
+  vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  float t = max(-v.z, 0.0);
+  v.xy += vec2(v.x >= 0.0 ? -t : t, v.y >= 0.0 ? -t : t);
+  return normalize(v);
+}
+
+void main() {
+  const mat4 modelMatrix = instanceBuffer.instances[gl_InstanceIndex].modelMatrix;
+  const float Gamma = ubo.view[3][3];
+
+  vec3 normal                  = octDecode(normalOct);
+  vec3 tangent                 = octDecode(tangentOct.xy);
+
+  // Decompress the binormal
+  vec3 BiTangent               = normalize(cross(tangent, normal)) * (tangentOct.z < 0.0 ? -1.0 : 1.0);
+
+  // Compute lighting information
+  outT2W                  = mat3(modelMatrix) * mat3(tangent, BiTangent, normal);
+  fragColor               = pow( vec4(color.rgb,1.0), Gamma.rrrr );    // SRGB to RGB
+  fragTexCoord            = uv;
+  fragMaterial            = uint(instanceBuffer.instances[gl_InstanceIndex].normalMatrix[3][3]);    // the renderer packs the material index there
+  vec4 positionWorld      = modelMatrix * vec4(position, 1.0);
+  fragPosWorld            = positionWorld.xyz;
+  gl_Position             = ubo.projection * ubo.view * positionWorld;
+}
\ No newline at end of file
@@ -1,5 +1,7 @@
 #include "pointLightSystem.hpp"
 #include "controller.hpp"
+#include "vk_commandpool.hpp"
+#include "vk_pipelineregistry.hpp"
 // libs
 #define GLM_FORCE_RADIANS
 #define GLM_FORCE_DEPTH_ZERO_TO_ONE
@@ -29,6 +31,7 @@ namespace nekographics {
     }
 
     PointLightSystem::~PointLightSystem() {
+        m_Device.getPipelineRegistry().releaseLayout(pipelineLayout);
         vkDestroyPipelineLayout(m_Device.device(), pipelineLayout, nullptr);
     }
 
@@ -56,16 +59,17 @@ namespace nekographics {
 
         auto rotateLight = glm::rotate(glm::mat4(1.f), 0.5f * frameInfo.frameTime, { 0.f, -1.f, 0.f });
         int lightIndex = 0;
-        for (auto& kv : frameInfo.gameObjects) {
-
-            auto& obj = kv.second;
-            if (obj.pointLight == nullptr) continue;
+        NKScene& scene = frameInfo.scene;
+        for (size_t i = 0; i < scene.pointLights.size(); ++i) {
+            NkEntity entity = scene.pointLights.entityAt(i);
+            auto& pointLight = scene.pointLights.componentAt(i);
+            auto& transform = scene.transforms.get(entity);
 
             assert(lightIndex < MAX_LIGHTS && "Point lights exceed maximum specified");
 
             // update light position
-            obj.transform.translation = glm::vec3(rotateLight * glm::vec4(obj.transform.translation, 1.f));
-            //obj.transform.translation = glm::vec4(obj.transform.translation, 1.f);
+            transform.translation = glm::vec3(rotateLight * glm::vec4(transform.translation, 1.f));
+            //transform.translation = glm::vec4(transform.translation, 1.f);
 
             // copy light to ubo
             //update the first one to be in the camera position 
@@ -73,29 +77,29 @@ namespace nekographics {
                 //if following camera update with the camera position 
                 if (mFollowCamera) {
                     ubo.pointLights[lightIndex].position = ubo.cameraEyePos;
-                    obj.transform.translation = ubo.cameraEyePos;
+                    transform.translation = ubo.cameraEyePos;
                 }
                 else {
                     ubo.pointLights[lightIndex].position = mStaticCameraPos;
-                    obj.transform.translation = mStaticCameraPos;
+                    transform.translation = mStaticCameraPos;
                 }
             }
             else {
-                ubo.pointLights[lightIndex].position = glm::vec4(obj.transform.translation, 1.f);
+                ubo.pointLights[lightIndex].position = glm::vec4(transform.translation, 1.f);
             }
-            ubo.pointLights[lightIndex].color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
+            ubo.pointLights[lightIndex].color = glm::vec4(scene.colors.get(entity), pointLight.lightIntensity);
 
             lightIndex += 1;
         }
         ubo.numLights = lightIndex;
     }
 
-    void PointLightSystem::inputUpdate(NkGameObject& viewerObject) {
+    void PointLightSystem::inputUpdate(const TransformComponent& viewerTransform) {
         //check light following camera
         if (KeyManager.isKeyTriggered(VK_SPACE)) {
             mFollowCamera = !mFollowCamera;//toggle between states
             if (!mFollowCamera) {
-                mStaticCameraPos = { viewerObject.transform.translation,1.f };
+                mStaticCameraPos = { viewerTransform.translation,1.f };
             }
         }
     }
@@ -109,19 +113,21 @@ namespace nekographics {
         pipelineConfig.bindingDescriptions.clear();
         pipelineConfig.renderPass = renderPass;
         pipelineConfig.pipelineLayout = pipelineLayout;
-        m_Pipeline = std::make_unique<NKPipeline>(
-            m_Device,
+        m_Pipeline = m_Device.getPipelineRegistry().getGraphicsPipeline(
             "Shaders/pointLight.vert.spv",
             "Shaders/pointLight.frag.spv",
             pipelineConfig);
     }
 
     void PointLightSystem::render(FrameInfo& frameInfo) {
+        //a few quads, the secondary is recorded on this thread 
+        VkCommandBuffer commandBuffer = frameInfo.secondaryPools != nullptr
+            ? frameInfo.secondaryPools->beginSecondary(0) : frameInfo.commandBuffer;
 
-        m_Pipeline->bind(frameInfo.commandBuffer);
+        m_Pipeline->bind(commandBuffer);
 
         vkCmdBindDescriptorSets(
-            frameInfo.commandBuffer,
+            commandBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             pipelineLayout,
             0,
@@ -130,23 +136,29 @@ namespace nekographics {
             0,
             nullptr);
 
-        for (auto& kv : frameInfo.gameObjects) {
-            auto& obj = kv.second;
-            if (obj.pointLight == nullptr) continue;
+        NKScene& scene = frameInfo.scene;
+        for (size_t i = 0; i < scene.pointLights.size(); ++i) {
+            NkEntity entity = scene.pointLights.entityAt(i);
+            const auto& transform = scene.transforms.get(entity);
 
             PointLightPushConstants push{};
-            push.position = glm::vec4(obj.transform.translation, 1.f);
-            push.color = glm::vec4(obj.color, obj.pointLight->lightIntensity);
-            push.radius = obj.transform.scale.x;
+            push.position = glm::vec4(transform.translation, 1.f);
+            push.color = glm::vec4(scene.colors.get(entity), scene.pointLights.componentAt(i).lightIntensity);
+            push.radius = transform.scale.x;
 
             vkCmdPushConstants(
-                frameInfo.commandBuffer,
+                commandBuffer,
                 pipelineLayout,
                 VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
                 0,
                 sizeof(PointLightPushConstants),
                 &push);
-            vkCmdDraw(frameInfo.commandBuffer, 6, 1, 0, 0);
+            vkCmdDraw(commandBuffer, 6, 1, 0, 0);
+        }
+
+        if (commandBuffer != frameInfo.commandBuffer) {
+            NKFrameCommandPools::endSecondary(commandBuffer);
+            vkCmdExecuteCommands(frameInfo.commandBuffer, 1, &commandBuffer);
         }
     }
 
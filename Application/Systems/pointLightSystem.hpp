@@ -21,7 +21,7 @@ namespace nekographics {
         PointLightSystem& operator=(const PointLightSystem&) = delete;
 
         void update(FrameInfo& frameInfo, GlobalUbo& ubo);
-        void inputUpdate(NkGameObject& viewerObject);//updating the point light based on the input 
+        void inputUpdate(const TransformComponent& viewerTransform);//updating the point light based on the input 
         void render(FrameInfo& frameInfo);
 
         bool mFollowCamera = true;//if light is following camera 
@@ -32,7 +32,7 @@ namespace nekographics {
 
 
         NKDevice& m_Device;
-        std::unique_ptr<NKPipeline> m_Pipeline;
+        NKPipeline* m_Pipeline = nullptr;//owned by the device's pipeline registry 
         VkPipelineLayout pipelineLayout;
     };
 }  // namespace lve
\ No newline at end of file
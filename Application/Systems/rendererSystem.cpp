@@ -1,4 +1,6 @@
 #include "rendererSystem.hpp"
+#include "vk_swapchain.hpp"
+#include "vk_jobsystem.hpp"
 
 // libs
 #define GLM_FORCE_RADIANS
@@ -7,9 +9,16 @@
 #include <glm/gtc/constants.hpp>
 
 // std
+#include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <numeric>
 #include <stdexcept>
+#include <string>
+#include <tuple>
 
 namespace nekographics {
 
@@ -30,14 +39,127 @@ namespace nekographics {
         glm::mat4 normalMatrix{ 1.f };
     };
 
+    //one entry of the instance buffer, matches Instance in the *Instanced.vert shaders (std430) 
+    struct InstanceData {
+        glm::mat4 modelMatrix{ 1.f };
+        glm::mat4 normalMatrix{ 1.f };
+    };
+
+    //the shaders only read the 3x3 of the normal matrix, the corner carries the material index without growing the push constants past 128 bytes 
+    static glm::mat4 packNormalMatrix(const glm::mat3& normalMatrix, uint32_t material) {
+        glm::mat4 packed{ normalMatrix };
+        packed[3][3] = static_cast<float>(material);
+        return packed;
+    }
+
+    //one entry of the object buffer, matches Object in indirectInstances.comp (std430) 
+    struct IndirectObjectData {
+        glm::mat4 modelMatrix{ 1.f };
+        glm::mat4 normalMatrix{ 1.f };
+        glm::vec4 boundingSphere{ 0.f };//model space, xyz center & w radius 
+        uint32_t firstDrawRef = 0;
+        uint32_t drawRefCount = 0;
+        uint32_t materialIndex = 0;//also packed into normalMatrix, which the instances are copied from 
+        uint32_t padding = 0;
+    };
+
+    //matches CullData in indirectInstances.comp (std140) 
+    struct IndirectCullData {
+        glm::vec4 frustumPlanes[6];//world space, xyz normal pointing inside & w distance 
+        glm::mat4 occlusionView{ 1.f };
+        glm::mat4 occlusionProjection{ 1.f };
+        glm::vec2 pyramidSize{ 1.f };
+        uint32_t pyramidMipCount = 1;
+        uint32_t flags = 0;
+    };
+
+    enum IndirectCullFlags : uint32_t {
+        CULL_FRUSTUM = 1,
+        CULL_OCCLUSION = 2
+    };
+
+    //indices of the counters in the stats buffer, matches StatsBuffer in the indirect*.comp shaders 
+    enum IndirectStat : uint32_t {
+        STAT_FRUSTUM_CULLED_OBJECTS,
+        STAT_OCCLUSION_CULLED_OBJECTS,
+        STAT_FRUSTUM_CULLED_MESHES,
+        STAT_OCCLUSION_CULLED_MESHES,
+        STAT_VISIBLE_INSTANCES,
+        STAT_VISIBLE_DRAWS,
+        STAT_COUNT
+    };
+
+    //push constants of both indirect compute passes 
+    struct IndirectPushConstantData {
+        uint32_t objectCount;
+        uint32_t drawCount;
+    };
+
     SimpleRenderSystem::SimpleRenderSystem(NKDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout)
         : m_systemDevice{ device } {
+        createInstanceBuffers();
         createPipelineLayout(globalSetLayout);
         createPipeline(renderPass);
     }
 
     SimpleRenderSystem::~SimpleRenderSystem() {
+        //the registry's pipelines made with these layouts go with them 
+        m_systemDevice.getPipelineRegistry().releaseLayout(pipelineLayout);
         vkDestroyPipelineLayout(m_systemDevice.device(), pipelineLayout, nullptr);
+        if (m_indirectPipelineLayout != VK_NULL_HANDLE) {
+            m_systemDevice.getPipelineRegistry().releaseLayout(m_indirectPipelineLayout);
+            vkDestroyPipelineLayout(m_systemDevice.device(), m_indirectPipelineLayout, nullptr);
+        }
+    }
+
+    void SimpleRenderSystem::createInstanceBuffers() {
+        m_instanceSetLayout = NKDescriptorSetLayout::Builder(m_systemDevice)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+            .build();
+
+        m_instancePool = NKDescriptorPool::Builder(m_systemDevice)
+            .setMaxSets(NKSwapChain::MAX_FRAMES_IN_FLIGHT)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, NKSwapChain::MAX_FRAMES_IN_FLIGHT)
+            .build();
+
+        m_instanceBuffers.resize(NKSwapChain::MAX_FRAMES_IN_FLIGHT);
+        m_instanceDescriptorSets.resize(NKSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (int i = 0; i < NKSwapChain::MAX_FRAMES_IN_FLIGHT; i++) {
+            m_instanceBuffers[i] = std::make_unique<NKBuffer>(
+                m_systemDevice,
+                sizeof(InstanceData),
+                INITIAL_INSTANCE_CAPACITY,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+            m_instanceBuffers[i]->map();
+
+            auto bufferInfo = m_instanceBuffers[i]->descriptorInfo();
+            NkDescriptorWriter(*m_instanceSetLayout, *m_instancePool)
+                .writeBuffer(0, &bufferInfo)
+                .build(m_instanceDescriptorSets[i]);
+        }
+    }
+
+    void SimpleRenderSystem::reserveInstances(int frameIndex, uint32_t instanceCount) {
+        auto& instanceBuffer = m_instanceBuffers[frameIndex];
+        if (instanceCount <= instanceBuffer->getInstanceCount()) {
+            return;
+        }
+
+        //the frame's fence was waited on in beginFrame, so its buffer & set are no longer read by the gpu 
+        uint32_t capacity = std::max(instanceCount, instanceBuffer->getInstanceCount() * 2);
+        instanceBuffer = std::make_unique<NKBuffer>(
+            m_systemDevice,
+            sizeof(InstanceData),
+            capacity,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        instanceBuffer->map();
+
+        auto bufferInfo = instanceBuffer->descriptorInfo();
+        NkDescriptorWriter(*m_instanceSetLayout, *m_instancePool)
+            .writeBuffer(0, &bufferInfo)
+            .overwrite(m_instanceDescriptorSets[frameIndex]);
     }
 
     void SimpleRenderSystem::createPipelineLayout(VkDescriptorSetLayout globalSetLayout) {
@@ -47,7 +169,8 @@ namespace nekographics {
         pushConstantRange.offset = 0;//must be a multiple of 4, offset is mainly for if you are using seperate ranges for the vertex and fragment shaders
         pushConstantRange.size = sizeof(SimplePushConstantData);//must be a multiple of 4
 
-        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout };
+        //set 1 is only read by the instanced pipelines, sharing one layout keeps set 0 bound across pipeline switches 
+        std::vector<VkDescriptorSetLayout> descriptorSetLayouts{ globalSetLayout, m_instanceSetLayout->getDescriptorSetLayout() };
 
         //setting the pipeline layout to 
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
@@ -68,79 +191,785 @@ namespace nekographics {
         //using this pipeline 
         assert(pipelineLayout != nullptr && "Cannot create pipeline before pipeline layout");
 
-        PipelineConfigInfo pipelineConfig{};
+        m_renderPass = renderPass;
+
+        //the base pipeline, materials are picked per draw so every object shares it 
+        createPipelineVariant(0);
+    }
+
+    void SimpleRenderSystem::configurePipeline(uint32_t variant, PipelineConfigInfo& pipelineConfig, std::string& vertexShader, std::string& fragmentShader) {
         NKPipeline::defaultPipelineConfigInfo(pipelineConfig);
-        pipelineConfig.renderPass = renderPass;//setting the render pass, render pass describes the structure & format of our framebuffer object & their attachments
+        if (variant & PIPELINE_PACKED) {
+            pipelineConfig.bindingDescriptions = NKModel::PackedVertex::getBindingDescriptions();
+            pipelineConfig.attributeDescriptions = NKModel::PackedVertex::getAttributeDescriptions();
+        }
+        pipelineConfig.renderPass = m_renderPass;//setting the render pass, render pass describes the structure & format of our framebuffer object & their attachments
         pipelineConfig.pipelineLayout = pipelineLayout;
 
-        //making the pipeline base off the shader file for the skull 
-        m_systemPipeline = std::make_unique<NKPipeline>(
-            m_systemDevice,
-            "Shaders/shaderSkull.vert.spv",
-            "Shaders/shaderSkull.frag.spv",
-            pipelineConfig);
+        //only the vertex shaders differ between variants, they hand the same outputs to the fragment shader 
+        std::string shading = "Shaders/shaderMaterial";
+        vertexShader = shading
+            + ((variant & PIPELINE_PACKED) ? "Packed" : "")
+            + ((variant & PIPELINE_INSTANCED) ? "Instanced" : "")
+            + ".vert.spv";
+        fragmentShader = shading + ".frag.spv";
+    }
 
-        //making the pipeline base off the shader file for the car
-        m_systemPipelineCar = std::make_unique<NKPipeline>(
-            m_systemDevice,
-            "Shaders/shaderCar.vert.spv",
-            "Shaders/shaderCar.frag.spv",
-            pipelineConfig);
+    void SimpleRenderSystem::createPipelineVariant(uint32_t variant) {
+        PipelineConfigInfo pipelineConfig{};
+        std::string vertexShader;
+        std::string fragmentShader;
+        configurePipeline(variant, pipelineConfig, vertexShader, fragmentShader);
+
+        //the fragment shader module is shared by every variant 
+        m_pipelines[variant] = m_systemDevice.getPipelineRegistry().getGraphicsPipeline(vertexShader, fragmentShader, pipelineConfig);
+    }
+
+    NKPipeline* SimpleRenderSystem::getPipeline(uint32_t variant) {
+        if (m_pipelines[variant] == nullptr) {
+            createPipelineVariant(variant);
+        }
+        return m_pipelines[variant];
+    }
+
+    void SimpleRenderSystem::precompilePipelines(NKJobSystem* jobSystem) {
+        std::array<PipelineConfigInfo, PIPELINE_VARIANT_COUNT> pipelineConfigs;
+        std::vector<NKGraphicsPipelineDesc> pipelines;
+        std::vector<uint32_t> variants;
+        for (uint32_t variant = 0; variant < PIPELINE_VARIANT_COUNT; ++variant) {
+            NKGraphicsPipelineDesc desc{};
+            configurePipeline(variant, pipelineConfigs[variant], desc.vertFilepath, desc.fragFilepath);
+            desc.configInfo = &pipelineConfigs[variant];
+
+            //variants whose shaders weren't built are left to getPipeline, startup only needs what is on disk 
+            if (!std::filesystem::exists(desc.vertFilepath) || !std::filesystem::exists(desc.fragFilepath)) {
+                continue;
+            }
+            pipelines.push_back(std::move(desc));
+            variants.push_back(variant);
+        }
+
+        auto& registry = m_systemDevice.getPipelineRegistry();
+        registry.precompile(pipelines, jobSystem);
+        for (size_t i = 0; i < pipelines.size(); ++i) {
+            m_pipelines[variants[i]] = registry.getGraphicsPipeline(pipelines[i].vertFilepath, pipelines[i].fragFilepath, *pipelines[i].configInfo);
+        }
+    }
+
+    void SimpleRenderSystem::drawModel(
+        VkCommandBuffer commandBuffer, NKModel& model, NKGeometryBindState& geometryBinds, uint32_t instanceCount, uint32_t firstInstance) {
+        //models with child models never get here, addDrawItems splits them into their meshes 
+        model.bind(commandBuffer, &geometryBinds);//binding the geometry 
+        model.draw(commandBuffer, instanceCount, firstInstance);//drawing 
+    }
+
+    void SimpleRenderSystem::addDrawItems(uint32_t variant, uint32_t material, NKModel& model, const TransformComponent& transform) {
+        if (!model.getHasChildModels()) {
+            m_drawItems.push_back({ variant, material, &model, static_cast<uint32_t>(m_drawTransforms.size()) });
+            m_drawTransforms.push_back({ transform.worldMatrix(), transform.worldNormalMatrix() });
+            return;
+        }
+
+        //one item per mesh instance, meshes repeated in the hierarchy share the child model & get instanced together 
+        const NKSceneGraph& sceneGraph = model.getSceneGraph();
+        for (const auto& instance : sceneGraph.getMeshInstances()) {
+            m_drawItems.push_back({ variant, material, model.getChildModels()[instance.mesh].get(), static_cast<uint32_t>(m_drawTransforms.size()) });
+            m_drawTransforms.push_back({
+                transform.worldMatrix() * sceneGraph.getWorld(instance.node),
+                transform.worldNormalMatrix() * sceneGraph.getWorldNormal(instance.node) });
+        }
     }
 
     void SimpleRenderSystem::renderGameObjects(
         FrameInfo& frameInfo) {
 
-        ////check the frame info for the type of object you are rendering 
-        //m_systemPipeline->bind(frameInfo.commandBuffer);//binding the pipeline
+        if (m_gpuDriven) {
+            if (frameInfo.secondaryPools == nullptr) {
+                renderIndirect(frameInfo);
+                return;
+            }
+
+            //a handful of indirect draws, one secondary is enough 
+            FrameInfo secondaryInfo = frameInfo;
+            secondaryInfo.commandBuffer = frameInfo.secondaryPools->beginSecondary(0);
+            renderIndirect(secondaryInfo);
+            NKFrameCommandPools::endSecondary(secondaryInfo.commandBuffer);
+            vkCmdExecuteCommands(frameInfo.commandBuffer, 1, &secondaryInfo.commandBuffer);
+            return;
+        }
+
+        //gather what to draw 
+        m_drawItems.clear();
+        m_drawTransforms.clear();
+
+        NKScene& scene = frameInfo.scene;
+        for (size_t slot = 0; slot < scene.models.size(); ++slot) {
+            NkEntity entity = scene.models.entityAt(slot);
+            auto& modelComponent = scene.models.componentAt(slot);
+            if (!modelComponent.attachPendingModel()) continue;//no model, or still loading 
+            if (!modelComponent.model->isReady()) continue;//geometry still being streamed in 
+            auto& transform = scene.transforms.get(entity);
+
+            //the vertex layout of the model picks between the full & packed variant, the material is read per draw 
+            uint32_t variant = modelComponent.model->getVertexFormat() == NKModel::VertexFormat::Packed ? PIPELINE_PACKED : 0;
+            addDrawItems(variant, modelComponent.material, *modelComponent.model, transform);
+        }
+
+        m_cullingStats = {};
+        m_cullingStats.objects = static_cast<uint32_t>(m_drawItems.size());
+        m_frustum = NKFrustum::fromCamera(frameInfo.camera);
+        if (m_cullingEnabled) {
+            cullDrawItems();
+        }
+
+        //objects sharing a pipeline & a model become one instanced draw 
+        sortDrawItems(frameInfo.camera);
+
+        reserveInstances(frameInfo.frameIndex, static_cast<uint32_t>(m_drawItems.size()));
+        InstanceData* instances = static_cast<InstanceData*>(m_instanceBuffers[frameInfo.frameIndex]->getMappedMemory());
+        uint32_t instanceCursor = 0;
+
+        //groups & pipelines are settled up front, the recording below may run on several threads 
+        m_drawGroups.clear();
+        uint32_t drawCount = 0;
+        for (size_t groupStart = 0; groupStart < m_drawItems.size();) {
+            size_t groupEnd = groupStart + 1;
+            while (groupEnd < m_drawItems.size() && m_drawItems[groupEnd].variant == m_drawItems[groupStart].variant
+                && m_drawItems[groupEnd].model == m_drawItems[groupStart].model) {
+                groupEnd++;
+            }
+            uint32_t groupSize = static_cast<uint32_t>(groupEnd - groupStart);
+            bool instanced = groupSize >= MIN_INSTANCED_DRAW;
+
+            DrawGroup group{};
+            group.pipeline = getPipeline(m_drawItems[groupStart].variant | (instanced ? PIPELINE_INSTANCED : 0));
+            group.firstItem = static_cast<uint32_t>(groupStart);
+            group.itemCount = groupSize;
+            group.instanced = instanced;
+
+            if (instanced) {
+                //matrices go to the instance buffer, one draw for the whole group 
+                for (size_t i = groupStart; i < groupEnd; ++i) {
+                    const auto& transform = m_drawTransforms[m_drawItems[i].transform];
+                    instances[instanceCursor + (i - groupStart)] = { transform.modelMatrix, packNormalMatrix(transform.normalMatrix, m_drawItems[i].material) };
+                }
+                group.firstInstance = instanceCursor;
+                instanceCursor += groupSize;
+            }
+
+            drawCount += instanced ? 1 : groupSize;
+            m_drawGroups.push_back(group);
+            groupStart = groupEnd;
+        }
+
+        m_bindStats = {};
+        if (frameInfo.secondaryPools == nullptr) {
+            recordDrawGroups(frameInfo, frameInfo.commandBuffer, 0, static_cast<uint32_t>(m_drawGroups.size()), m_bindStats);
+            return;
+        }
+
+        //contiguous runs of groups with about the same number of draws, one secondary per thread 
+        uint32_t threadCount = std::clamp(drawCount / MIN_DRAWS_PER_RECORDING_THREAD, 1u, frameInfo.secondaryPools->getThreadCount());
+        m_recordRanges.assign(threadCount + 1, static_cast<uint32_t>(m_drawGroups.size()));
+        m_recordRanges[0] = 0;
+        uint32_t thread = 1;
+        uint32_t drawsSoFar = 0;
+        for (uint32_t i = 0; i < m_drawGroups.size() && thread < threadCount; ++i) {
+            if (drawsSoFar >= static_cast<uint64_t>(drawCount) * thread / threadCount) {
+                m_recordRanges[thread++] = i;
+            }
+            drawsSoFar += m_drawGroups[i].instanced ? 1 : m_drawGroups[i].itemCount;
+        }
+
+        //a range always records into the pool of its own index, whichever job thread picks it up 
+        m_secondaryBuffers.resize(threadCount);
+        m_recordBindStats.assign(threadCount, BindStats{});
+        auto record = [&](uint32_t first, uint32_t last) {
+            for (uint32_t t = first; t < last; ++t) {
+                VkCommandBuffer commandBuffer = frameInfo.secondaryPools->beginSecondary(t);
+                recordDrawGroups(frameInfo, commandBuffer, m_recordRanges[t], m_recordRanges[t + 1], m_recordBindStats[t]);
+                NKFrameCommandPools::endSecondary(commandBuffer);
+                m_secondaryBuffers[t] = commandBuffer;
+            }
+        };
+
+        if (frameInfo.jobSystem) {
+            frameInfo.jobSystem->parallelFor(threadCount, 1, record);//rethrows a failed recording 
+        }
+        else {
+            record(0, threadCount);
+        }
+
+        //every secondary starts with nothing bound, the binds at the range starts are counted too 
+        for (const auto& stats : m_recordBindStats) {
+            m_bindStats.pipelineBinds += stats.pipelineBinds;
+            m_bindStats.pipelineBindsSkipped += stats.pipelineBindsSkipped;
+            m_bindStats.geometryBinds += stats.geometryBinds;
+            m_bindStats.geometryBindsSkipped += stats.geometryBindsSkipped;
+        }
+
+        //executed in group order, same result as recording inline 
+        vkCmdExecuteCommands(frameInfo.commandBuffer, threadCount, m_secondaryBuffers.data());
+    }
+
+    void SimpleRenderSystem::recordDrawGroups(FrameInfo& frameInfo, VkCommandBuffer commandBuffer, uint32_t firstGroup, uint32_t lastGroup, BindStats& bindStats) {
+        VkDescriptorSet descriptorSets[] = { frameInfo.globalDescriptorSet, m_instanceDescriptorSets[frameInfo.frameIndex] };
+        vkCmdBindDescriptorSets(
+            commandBuffer,
+            VK_PIPELINE_BIND_POINT_GRAPHICS,
+            pipelineLayout,
+            0,
+            2,
+            descriptorSets,
+            0,
+            nullptr);
+
+        NKPipeline* boundPipeline = nullptr;
+        NKGeometryBindState geometryBinds{};//models share the pool's buffers, most binds are skipped 
+
+        for (uint32_t g = firstGroup; g < lastGroup; ++g) {
+            const DrawGroup& group = m_drawGroups[g];
+            if (group.pipeline != boundPipeline) {
+                group.pipeline->bind(commandBuffer);//binding the pipeline
+                boundPipeline = group.pipeline;
+                bindStats.pipelineBinds++;
+            }
+            else {
+                bindStats.pipelineBindsSkipped++;
+            }
+
+            if (group.instanced) {
+                drawModel(commandBuffer, *m_drawItems[group.firstItem].model, geometryBinds, group.itemCount, group.firstInstance);
+                continue;
+            }
+
+            for (uint32_t i = group.firstItem; i < group.firstItem + group.itemCount; ++i) {
+                const auto& transform = m_drawTransforms[m_drawItems[i].transform];
+
+                SimplePushConstantData push{};//creating a simple constant data 
+                //initialize the push constant data 
+                push.modelMatrix = transform.modelMatrix;
+                push.normalMatrix = packNormalMatrix(transform.normalMatrix, m_drawItems[i].material);
+
+                vkCmdPushConstants(
+                    commandBuffer,
+                    pipelineLayout,
+                    VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
+                    0,
+                    sizeof(SimplePushConstantData),
+                    &push);
+
+                drawModel(commandBuffer, *m_drawItems[i].model, geometryBinds, 1, 0);
+            }
+        }
+
+        bindStats.geometryBinds = geometryBinds.bindCount;
+        bindStats.geometryBindsSkipped = geometryBinds.skippedBindCount;
+    }
+
+    void SimpleRenderSystem::cullDrawItems() {
+        //one batch for the whole frame so the planes are tested against several spheres at a time 
+        m_cullSpheres.clear();
+        m_cullSpheres.reserve(m_drawItems.size());
+        for (auto& item : m_drawItems) {
+            m_cullSpheres.add(NKFrustum::transformSphere(m_drawTransforms[item.transform].modelMatrix, item.model->getBoundingSphere()));
+        }
+
+        m_visibleItems.resize(m_drawItems.size());
+        uint32_t visibleCount = m_frustum.cullSpheres(m_cullSpheres, m_visibleItems.data());
+
+        //the indices come out ascending, compacting in place keeps the gathered order 
+        for (uint32_t i = 0; i < visibleCount; ++i) {
+            m_drawItems[i] = m_drawItems[m_visibleItems[i]];
+        }
+        m_cullingStats.frustumCulledObjects = static_cast<uint32_t>(m_drawItems.size()) - visibleCount;
+        m_drawItems.resize(visibleCount);
+    }
+
+    void SimpleRenderSystem::sortDrawItems(const NKCamera& camera) {
+        //pipeline, then the buffers & mesh so a group is one run of items, front to back inside it for early z 
+        m_renderQueue.clear();
+        m_renderQueue.reserve(m_drawItems.size());
+
+        //dense ranks, geometry handles sharing the low bits would sort other meshes in between a model's items 
+        m_meshRanks.clear();
+        m_itemRanks.resize(m_drawItems.size());
+        for (uint32_t i = 0; i < m_drawItems.size(); ++i) {
+            m_itemRanks[i] = m_meshRanks.try_emplace(m_drawItems[i].model, static_cast<uint32_t>(m_meshRanks.size())).first->second;
+        }
+        const bool wideRanks = m_meshRanks.size() > (1u << NKSortKey::MESH_BITS);//gives up the depth order, never the groups 
+
+        const glm::mat4& view = camera.getView();
+        for (uint32_t i = 0; i < m_drawItems.size(); ++i) {
+            const DrawItem& item = m_drawItems[i];
+            const NKGeometryRange& range = item.model->getGeometryRange();
+            uint32_t geometry = range.vertexPool << 8 | range.vertexChunk;
+            uint32_t material = 0;//materials are bindless, none of them needs its own descriptor set 
+
+            uint64_t key;
+            if (wideRanks) {
+                key = NKSortKey::makeWide(RENDER_PASS_OPAQUE, item.variant, material, geometry, m_itemRanks[i]);
+            }
+            else {
+                float viewDepth = (view * m_drawTransforms[item.transform].modelMatrix[3]).z;
+                key = NKSortKey::make(RENDER_PASS_OPAQUE, item.variant, material, geometry, m_itemRanks[i], viewDepth);
+            }
+            m_renderQueue.push(key, i);
+        }
+        m_renderQueue.sort();
+
+        m_sortedItems.clear();
+        m_sortedItems.reserve(m_drawItems.size());
+        for (const auto& entry : m_renderQueue.getEntries()) {
+            m_sortedItems.push_back(m_drawItems[entry.item]);
+        }
+        m_drawItems.swap(m_sortedItems);
+    }
+
+    void SimpleRenderSystem::setGpuDriven(bool enabled) {
+        //the instances of every draw are found through firstInstance, 1.0 gpus may not allow it in indirect commands 
+        if (enabled && !m_systemDevice.supportsDrawIndirectFirstInstance()) {
+            std::cout << "drawIndirectFirstInstance is not supported, keeping the cpu driven render path" << std::endl;
+            enabled = false;
+        }
+
+        if (enabled && m_indirectPipelineLayout == VK_NULL_HANDLE) {
+            createIndirectResources();
+        }
+        m_hasOcclusionCamera = m_hasOcclusionCamera && enabled && m_gpuDriven;//the pyramid kept being built without the camera being tracked 
+        m_gpuDriven = enabled;
+    }
+
+    void SimpleRenderSystem::createIndirectResources() {
+        //never built, keeps binding 9 valid while occlusion culling is off. Every pyramid gets the same cached sampler 
+        m_placeholderPyramid = std::make_unique<NKDepthPyramid>(m_systemDevice, VkExtent2D{ 1, 1 }, VK_FORMAT_D32_SFLOAT);
+
+        m_indirectSetLayout = NKDescriptorSetLayout::Builder(m_systemDevice)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)//objects 
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)//draws 
+            .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)//draw refs 
+            .addBinding(3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)//instances 
+            .addBinding(4, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)//draw batches 
+            .addBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)//compacted commands 
+            .addBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)//counts 
+            .addBinding(7, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)//cull data 
+            .addBinding(8, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)//draw bounds 
+            .addBinding(9, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)//depth pyramid 
+            .addBinding(10, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT)//stats 
+            .setImmutableSampler(9, m_placeholderPyramid->getSampler())
+            .build();
+
+        //per frame a compute set & a set 1 for the instanced pipelines reading the gpu written instances 
+        m_indirectPool = NKDescriptorPool::Builder(m_systemDevice)
+            .setMaxSets(NKSwapChain::MAX_FRAMES_IN_FLIGHT * 2)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, NKSwapChain::MAX_FRAMES_IN_FLIGHT * 10)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, NKSwapChain::MAX_FRAMES_IN_FLIGHT)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, NKSwapChain::MAX_FRAMES_IN_FLIGHT)
+            .build();
+
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(IndirectPushConstantData);
+
+        VkDescriptorSetLayout setLayout = m_indirectSetLayout->getDescriptorSetLayout();
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &setLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+        if (vkCreatePipelineLayout(m_systemDevice.device(), &pipelineLayoutInfo, nullptr, &m_indirectPipelineLayout) !=
+            VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline layout!");
+        }
+
+        auto& registry = m_systemDevice.getPipelineRegistry();
+        m_indirectInstancesPipeline = registry.getComputePipeline("Shaders/indirectInstances.comp.spv", m_indirectPipelineLayout);
+        m_indirectCompactPipeline = registry.getComputePipeline("Shaders/indirectCompact.comp.spv", m_indirectPipelineLayout);
+
+        m_indirectFrames.resize(NKSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto& frame : m_indirectFrames) {
+            if (!m_indirectPool->allocateDescriptor(setLayout, frame.computeSet) ||
+                !m_indirectPool->allocateDescriptor(m_instanceSetLayout->getDescriptorSetLayout(), frame.instanceSet)) {
+                throw std::runtime_error("failed to allocate indirect descriptor sets!");
+            }
+
+            constexpr VkMemoryPropertyFlags hostMemory = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+            frame.cullData = std::make_unique<NKBuffer>(m_systemDevice, sizeof(IndirectCullData), 1, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, hostMemory);
+            frame.cullData->map();
+            frame.stats = std::make_unique<NKBuffer>(m_systemDevice, sizeof(uint32_t), STAT_COUNT,
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, hostMemory);
+            frame.stats->map();
+        }
+    }
+
+    bool SimpleRenderSystem::reserveIndirectBuffer(
+        std::unique_ptr<NKBuffer>& buffer, VkDeviceSize elementSize, uint32_t elementCount, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryProperties) {
+        if (buffer != nullptr && elementCount <= buffer->getInstanceCount()) {
+            return false;
+        }
+
+        //only reached for the frame being recorded, its fence was waited on in beginFrame 
+        uint32_t capacity = std::max(elementCount, buffer != nullptr ? buffer->getInstanceCount() * 2 : INITIAL_INSTANCE_CAPACITY);
+        buffer = std::make_unique<NKBuffer>(m_systemDevice, elementSize, capacity, usage, memoryProperties);
+        if (memoryProperties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            buffer->map();
+        }
+        return true;
+    }
+
+    void SimpleRenderSystem::writeIndirectDescriptors(IndirectFrame& frame) {
+        std::array<VkDescriptorBufferInfo, 11> bufferInfos = {
+            frame.objects->descriptorInfo(),
+            frame.draws->descriptorInfo(),
+            frame.drawRefs->descriptorInfo(),
+            frame.instances->descriptorInfo(),
+            frame.drawBatches->descriptorInfo(),
+            frame.commands->descriptorInfo(),
+            frame.counts->descriptorInfo(),
+            frame.cullData->descriptorInfo(),
+            frame.drawBounds->descriptorInfo(),
+            VkDescriptorBufferInfo{},//the depth pyramid 
+            frame.stats->descriptorInfo() };
+
+        frame.depthPyramid = m_depthPyramid != nullptr ? m_depthPyramid : m_placeholderPyramid.get();
+        frame.depthPyramidGeneration = frame.depthPyramid->getGeneration();
+        VkDescriptorImageInfo pyramidInfo{ frame.depthPyramid->getSampler(), frame.depthPyramid->getImageView(), VK_IMAGE_LAYOUT_GENERAL };
+
+        NkDescriptorWriter writer(*m_indirectSetLayout, *m_indirectPool);
+        for (uint32_t binding = 0; binding < bufferInfos.size(); ++binding) {
+            if (binding == 9) {
+                writer.writeImage(binding, &pyramidInfo);
+            }
+            else {
+                writer.writeBuffer(binding, &bufferInfos[binding]);
+            }
+        }
+        writer.overwrite(frame.computeSet);
+        frame.descriptorsDirty = false;
+
+        NkDescriptorWriter(*m_instanceSetLayout, *m_indirectPool)
+            .writeBuffer(0, &bufferInfos[3])
+            .overwrite(frame.instanceSet);
+    }
+
+    uint32_t SimpleRenderSystem::gatherIndirectDraws(FrameInfo& frameInfo, IndirectFrame& frame) {
+        constexpr VkMemoryPropertyFlags hostMemory = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        constexpr uint32_t noEntry = ~0u;
+
+        m_indirectLookup.clear();
+        m_indirectEntries.clear();
+        m_indirectDraws.clear();
+        m_indirectDrawRefs.clear();
+        m_indirectBatches.clear();
+        m_drawItems.clear();
+        m_drawTransforms.clear();
+
+        //same as the cpu path, models with a scene graph become one object per mesh instance 
+
+        NKScene& scene = frameInfo.scene;
+        for (size_t slot = 0; slot < scene.models.size(); ++slot) {
+            NkEntity entity = scene.models.entityAt(slot);
+            auto& modelComponent = scene.models.componentAt(slot);
+            if (!modelComponent.attachPendingModel()) continue;//no model, or still loading 
+            if (!modelComponent.model->isReady()) continue;//geometry still being streamed in 
+            auto& transform = scene.transforms.get(entity);
+
+            uint32_t variant = modelComponent.model->getVertexFormat() == NKModel::VertexFormat::Packed ? PIPELINE_PACKED : 0;
+            addDrawItems(variant, modelComponent.material, *modelComponent.model, transform);
+        }
+
+        //every item may become an object, so the object buffer is sized before walking them 
+        frame.descriptorsDirty |= reserveIndirectBuffer(frame.objects, sizeof(IndirectObjectData),
+            static_cast<uint32_t>(m_drawItems.size()), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostMemory);
+        IndirectObjectData* objects = static_cast<IndirectObjectData*>(frame.objects->getMappedMemory());
+        uint32_t objectCount = 0;
+        size_t fallbackCount = 0;//items the indirect draws can't handle, moved to the front of m_drawItems 
+
+        for (size_t i = 0; i < m_drawItems.size(); ++i) {
+            const DrawItem item = m_drawItems[i];
+            NKModel& model = *item.model;
+
+            //the first object using a model & variant adds its draw 
+            auto lookup = m_indirectLookup.try_emplace(&model);
+            if (lookup.second) {
+                lookup.first->second.fill(noEntry);
+            }
+            uint32_t& entryIndex = lookup.first->second[item.variant];
+            if (entryIndex == noEntry) {
+                entryIndex = static_cast<uint32_t>(m_indirectEntries.size());
+
+                IndirectEntry entry{ static_cast<uint32_t>(m_indirectDrawRefs.size()), 0, 0, model.getHasIndexBuffer() };
+                if (entry.indexed) {
+                    m_indirectDrawRefs.push_back(static_cast<uint32_t>(m_indirectDraws.size()));
+                    m_indirectDraws.push_back({ item.variant, model.getGeometry(), model.getGeometryRange(), entryIndex, model.getBoundingSphere() });
+                }
+                entry.drawRefCount = static_cast<uint32_t>(m_indirectDrawRefs.size()) - entry.firstDrawRef;
+                m_indirectEntries.push_back(entry);
+            }
+
+            auto& entry = m_indirectEntries[entryIndex];
+            if (!entry.indexed) {
+                m_drawItems[fallbackCount++] = item;
+                continue;
+            }
+
+            entry.objectCount++;
+            const DrawTransform& transform = m_drawTransforms[item.transform];
+            objects[objectCount++] = { transform.modelMatrix, packNormalMatrix(transform.normalMatrix, item.material), model.getBoundingSphere(),
+                entry.firstDrawRef, entry.drawRefCount, item.material };
+        }
+        m_drawItems.resize(fallbackCount);
+
+        m_indirectDrawCount = static_cast<uint32_t>(m_indirectDraws.size());
+        if (objectCount == 0) {
+            return 0;
+        }
+
+        //draws sharing a pipeline & the buffers they live in end up next to each other, each run is one indirect draw 
+        m_indirectOrder.resize(m_indirectDraws.size());
+        std::iota(m_indirectOrder.begin(), m_indirectOrder.end(), 0u);
+        auto batchKey = [](const IndirectDraw& draw) {
+            return std::make_tuple(draw.variant, draw.range.vertexPool, draw.range.vertexChunk, draw.range.indexChunk, static_cast<uint32_t>(draw.range.indexType));
+        };
+        std::sort(m_indirectOrder.begin(), m_indirectOrder.end(), [&](uint32_t a, uint32_t b) {
+            return batchKey(m_indirectDraws[a]) < batchKey(m_indirectDraws[b]);
+        });
+
+        frame.descriptorsDirty |= reserveIndirectBuffer(frame.draws, sizeof(VkDrawIndexedIndirectCommand),
+            m_indirectDrawCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostMemory);
+        frame.descriptorsDirty |= reserveIndirectBuffer(frame.drawBounds, sizeof(glm::vec4),
+            m_indirectDrawCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostMemory);
+        frame.descriptorsDirty |= reserveIndirectBuffer(frame.drawBatches, sizeof(glm::uvec2),
+            m_indirectDrawCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostMemory);
+        frame.descriptorsDirty |= reserveIndirectBuffer(frame.drawRefs, sizeof(uint32_t),
+            static_cast<uint32_t>(m_indirectDrawRefs.size()), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, hostMemory);
+        frame.descriptorsDirty |= reserveIndirectBuffer(frame.commands, sizeof(VkDrawIndexedIndirectCommand),
+            m_indirectDrawCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        //the draws start without instances, the compute pass counts them up & each gets room for all its objects 
+        auto* draws = static_cast<VkDrawIndexedIndirectCommand*>(frame.draws->getMappedMemory());
+        auto* drawBatches = static_cast<glm::uvec2*>(frame.drawBatches->getMappedMemory());
+        auto* drawBounds = static_cast<glm::vec4*>(frame.drawBounds->getMappedMemory());
+        m_indirectCommandIndex.resize(m_indirectDraws.size());
+        uint32_t instanceCount = 0;
+        const IndirectDraw* batchDraw = nullptr;
+
+        for (uint32_t i = 0; i < m_indirectDrawCount; ++i) {
+            const IndirectDraw& draw = m_indirectDraws[m_indirectOrder[i]];
+            if (batchDraw == nullptr || batchKey(*batchDraw) != batchKey(draw)) {
+                m_indirectBatches.push_back({ draw.variant, draw.geometry, i, 0 });
+                batchDraw = &draw;
+            }
+            IndirectBatch& batch = m_indirectBatches.back();
+            batch.drawCount++;
+
+            draws[i] = { draw.range.indexCount, 0, draw.range.firstIndex, static_cast<int32_t>(draw.range.vertexOffset), instanceCount };
+            drawBatches[i] = { static_cast<uint32_t>(m_indirectBatches.size() - 1), batch.firstDraw };
+            drawBounds[i] = draw.boundingSphere;
+            m_indirectCommandIndex[m_indirectOrder[i]] = i;
+            instanceCount += m_indirectEntries[draw.entry].objectCount;
+        }
+
+        //the refs were gathered against the unsorted draws 
+        uint32_t* drawRefs = static_cast<uint32_t*>(frame.drawRefs->getMappedMemory());
+        for (size_t i = 0; i < m_indirectDrawRefs.size(); ++i) {
+            drawRefs[i] = m_indirectCommandIndex[m_indirectDrawRefs[i]];
+        }
+
+        frame.descriptorsDirty |= reserveIndirectBuffer(frame.instances, sizeof(InstanceData),
+            instanceCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        frame.descriptorsDirty |= reserveIndirectBuffer(frame.counts, sizeof(uint32_t),
+            static_cast<uint32_t>(m_indirectBatches.size()), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+        return objectCount;
+    }
+
+    void SimpleRenderSystem::writeCullData(FrameInfo& frameInfo, IndirectFrame& frame) {
+        auto* cullData = static_cast<IndirectCullData*>(frame.cullData->getMappedMemory());
+
+        m_frustum = NKFrustum::fromCamera(frameInfo.camera);
+        std::copy(m_frustum.getPlanes().begin(), m_frustum.getPlanes().end(), cullData->frustumPlanes);
+
+        //the pyramid holds the depth of the previous frame, projected with the camera that rendered it 
+        const NKDepthPyramid* pyramid = m_depthPyramid != nullptr ? m_depthPyramid : m_placeholderPyramid.get();
+        const bool occlusion = m_cullingEnabled && m_depthPyramid != nullptr && m_depthPyramid->isValid() && m_hasOcclusionCamera;
+        cullData->occlusionView = m_occlusionView;
+        cullData->occlusionProjection = m_occlusionProjection;
+        cullData->pyramidSize = glm::vec2(static_cast<float>(pyramid->getExtent().width), static_cast<float>(pyramid->getExtent().height));
+        cullData->pyramidMipCount = pyramid->getMipCount();
+        cullData->flags = (m_cullingEnabled ? CULL_FRUSTUM : 0u) | (occlusion ? CULL_OCCLUSION : 0u);
+
+        //this frame's depth is what the pyramid will hold for the next one 
+        m_occlusionView = frameInfo.camera.getView();
+        m_occlusionProjection = frameInfo.camera.getProjection();
+        m_hasOcclusionCamera = true;
+    }
+
+    void SimpleRenderSystem::readCullingStats(IndirectFrame& frame) {
+        //the frame's fence was waited on in beginFrame & the host read was made visible by the last barrier of the frame 
+        if (!frame.statsPending) {
+            return;
+        }
+        frame.statsPending = false;
+
+        const uint32_t* counters = static_cast<const uint32_t*>(frame.stats->getMappedMemory());
+        m_cullingStats.objects = frame.statsObjects;
+        m_cullingStats.frustumCulledObjects = counters[STAT_FRUSTUM_CULLED_OBJECTS];
+        m_cullingStats.occlusionCulledObjects = counters[STAT_OCCLUSION_CULLED_OBJECTS];
+        m_cullingStats.frustumCulledMeshes = counters[STAT_FRUSTUM_CULLED_MESHES];
+        m_cullingStats.occlusionCulledMeshes = counters[STAT_OCCLUSION_CULLED_MESHES];
+        m_cullingStats.visibleInstances = counters[STAT_VISIBLE_INSTANCES];
+        m_cullingStats.draws = frame.statsDraws;
+        m_cullingStats.visibleDraws = counters[STAT_VISIBLE_DRAWS];
+    }
+
+    void SimpleRenderSystem::prepareGameObjects(FrameInfo& frameInfo) {
+        if (!m_gpuDriven) {
+            return;
+        }
+
+        IndirectFrame& frame = m_indirectFrames[frameInfo.frameIndex];
+        readCullingStats(frame);
+
+        uint32_t objectCount = gatherIndirectDraws(frameInfo, frame);
+        writeCullData(frameInfo, frame);
+        m_indirectPrepared = true;
+        if (objectCount == 0) {
+            return;
+        }
+
+        //new buffers, or a depth pyramid that was swapped or recreated since the set was written 
+        NKDepthPyramid* pyramid = m_depthPyramid != nullptr ? m_depthPyramid : m_placeholderPyramid.get();
+        if (frame.descriptorsDirty || frame.depthPyramid != pyramid || frame.depthPyramidGeneration != pyramid->getGeneration()) {
+            writeIndirectDescriptors(frame);
+        }
+
+        VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+
+        //the counts restart at 0, without the count extension the unused commands have to draw nothing 
+        vkCmdFillBuffer(commandBuffer, frame.counts->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+        vkCmdFillBuffer(commandBuffer, frame.stats->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+        if (getIndirectCountDraw() == nullptr) {
+            vkCmdFillBuffer(commandBuffer, frame.commands->getBuffer(), 0, VK_WHOLE_SIZE, 0);
+        }
+
+        VkMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        IndirectPushConstantData push{ objectCount, m_indirectDrawCount };
+        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_indirectPipelineLayout, 0, 1, &frame.computeSet, 0, nullptr);
+        vkCmdPushConstants(commandBuffer, m_indirectPipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(IndirectPushConstantData), &push);
+
+        //pass 1, every object appends its matrices to the draws of its model 
+        m_indirectInstancesPipeline->bind(commandBuffer);
+        vkCmdDispatch(commandBuffer, (objectCount + INDIRECT_GROUP_SIZE - 1) / INDIRECT_GROUP_SIZE, 1, 1);
+
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        //pass 2, draws that got instances are packed to the front of their batch 
+        m_indirectCompactPipeline->bind(commandBuffer);
+        vkCmdDispatch(commandBuffer, (m_indirectDrawCount + INDIRECT_GROUP_SIZE - 1) / INDIRECT_GROUP_SIZE, 1, 1);
+
+        //the stats are read on the host once the frame's fence signals 
+        barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+            0, 1, &barrier, 0, nullptr, 0, nullptr);
+
+        frame.statsPending = true;
+        frame.statsObjects = objectCount;
+        frame.statsDraws = m_indirectDrawCount;
+    }
+
+    PFN_vkCmdDrawIndexedIndirectCountKHR SimpleRenderSystem::getIndirectCountDraw() const {
+        //the count draw reads up to drawCount commands, which needs multiDrawIndirect as well as the extension 
+        return m_systemDevice.supportsMultiDrawIndirect() ? m_systemDevice.cmdDrawIndexedIndirectCount() : nullptr;
+    }
+
+    void SimpleRenderSystem::renderIndirect(FrameInfo& frameInfo) {
+        assert(m_indirectPrepared && "prepareGameObjects has to be recorded before the render pass in gpu driven mode");
+        m_indirectPrepared = false;
 
+        IndirectFrame& frame = m_indirectFrames[frameInfo.frameIndex];
+        VkCommandBuffer commandBuffer = frameInfo.commandBuffer;
+
+        VkDescriptorSet descriptorSets[] = { frameInfo.globalDescriptorSet, frame.instanceSet };
         vkCmdBindDescriptorSets(
-            frameInfo.commandBuffer,
+            commandBuffer,
             VK_PIPELINE_BIND_POINT_GRAPHICS,
             pipelineLayout,
             0,
-            1,
-            &frameInfo.globalDescriptorSet,
+            m_indirectBatches.empty() ? 1 : 2,//the instance set is only written once something was gathered 
+            descriptorSets,
             0,
             nullptr);
 
-        for (auto& kv : frameInfo.gameObjects) {
-            auto& obj = kv.second;
-            if (obj.model == nullptr) continue;
-            
-            //check which model it is to bind the respective shader 
-            if (kv.first == 0) {
-                m_systemPipeline->bind(frameInfo.commandBuffer);//binding the pipeline
+        NKPipeline* boundPipeline = nullptr;
+        NKGeometryBindState geometryBinds{};
+
+        const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+        const bool multiDraw = m_systemDevice.supportsMultiDrawIndirect();
+        const uint32_t maxDrawCount = multiDraw ? m_systemDevice.properties.limits.maxDrawIndirectCount : 1;
+        auto drawIndexedIndirectCount = getIndirectCountDraw();
+
+        for (size_t batchIndex = 0; batchIndex < m_indirectBatches.size(); ++batchIndex) {
+            const IndirectBatch& batch = m_indirectBatches[batchIndex];
+
+            NKPipeline* pipeline = getPipeline(batch.variant | PIPELINE_INSTANCED);
+            if (pipeline != boundPipeline) {
+                pipeline->bind(commandBuffer);
+                boundPipeline = pipeline;
             }
-            else if (kv.first == 1) {
-                m_systemPipelineCar->bind(frameInfo.commandBuffer);//binding the pipeline
+            m_systemDevice.getGeometryPool().bind(commandBuffer, batch.geometry, &geometryBinds);
+
+            VkDeviceSize offset = static_cast<VkDeviceSize>(batch.firstDraw) * stride;
+            if (drawIndexedIndirectCount != nullptr) {
+                //only the compacted commands are read 
+                drawIndexedIndirectCount(commandBuffer, frame.commands->getBuffer(), offset,
+                    frame.counts->getBuffer(), batchIndex * sizeof(uint32_t), batch.drawCount, stride);
+                continue;
             }
 
-            SimplePushConstantData push{};//creating a simple constant data 
-            //initialize the push constant data 
-            push.modelMatrix = obj.transform.mat4();
-            push.normalMatrix = obj.transform.normalMatrix();
+            //the tail past the compacted commands was cleared, those commands draw no instances 
+            for (uint32_t first = 0; first < batch.drawCount; first += maxDrawCount) {
+                uint32_t drawCount = std::min(maxDrawCount, batch.drawCount - first);
+                vkCmdDrawIndexedIndirect(commandBuffer, frame.commands->getBuffer(), offset + static_cast<VkDeviceSize>(first) * stride, drawCount, stride);
+            }
+        }
+
+        //models with non indexed meshes, drawn one object at a time 
+        for (auto& item : m_drawItems) {
+            NKPipeline* pipeline = getPipeline(item.variant);
+            if (pipeline != boundPipeline) {
+                pipeline->bind(commandBuffer);
+                boundPipeline = pipeline;
+            }
 
+            SimplePushConstantData push{};
+            push.modelMatrix = m_drawTransforms[item.transform].modelMatrix;
+            push.normalMatrix = packNormalMatrix(m_drawTransforms[item.transform].normalMatrix, item.material);
             vkCmdPushConstants(
-                frameInfo.commandBuffer,
+                commandBuffer,
                 pipelineLayout,
                 VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
                 0,
                 sizeof(SimplePushConstantData),
                 &push);
 
-            //check if there are child models 
-            if (obj.model->getHasChildModels()) {
-                //loop through all the child models 
-                for (auto& childModels : obj.model->getChildModels()) {
-                    childModels->bind(frameInfo.commandBuffer);//binding the pipeline 
-                    childModels->draw(frameInfo.commandBuffer);//draw all the child models 
-                }
-            }
-            else {
-                obj.model->bind(frameInfo.commandBuffer);//binding the pipeline 
-                obj.model->draw(frameInfo.commandBuffer);//drawing 
-            }
+            drawModel(commandBuffer, *item.model, geometryBinds, 1, 0);
         }
     }
 
@@ -5,30 +5,243 @@
 #include "vk_gameobject.hpp"
 #include "vk_pipeline.hpp"
 #include "vk_frameinfo.hpp"
+#include "vk_descriptors.hpp"
+#include "vk_buffer.hpp"
+#include "vk_depthpyramid.hpp"
+#include "vk_frustum.hpp"
+#include "vk_commandpool.hpp"
+#include "vk_pipelineregistry.hpp"
+#include "vk_renderqueue.hpp"
 // std
+#include <array>
 #include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace nekographics {
 	class SimpleRenderSystem {
 	public:
+		static constexpr uint32_t MIN_INSTANCED_DRAW = 2;//objects sharing a model & pipeline, smaller groups keep the push constant path 
+		static constexpr uint32_t INITIAL_INSTANCE_CAPACITY = 1024;//per frame, grows on demand 
+		static constexpr uint32_t INDIRECT_GROUP_SIZE = 64;//local_size_x of the indirect*.comp shaders 
+		static constexpr uint32_t MIN_DRAWS_PER_RECORDING_THREAD = 256;//fewer draws than this aren't worth another thread 
+
 		SimpleRenderSystem(NKDevice& device, VkRenderPass renderPass, VkDescriptorSetLayout globalSetLayout);
 		~SimpleRenderSystem();
 
 		SimpleRenderSystem(const SimpleRenderSystem&) = delete;
 		SimpleRenderSystem& operator=(const SimpleRenderSystem&) = delete;
 
+		/*
+		GPU driven mode, the objects' transforms & draw ranges are written to storage buffers and two
+		compute passes build the instance data & the VkDrawIndexedIndirectCommands, the render pass
+		then records one indirect draw per pipeline & geometry chunk however many objects there are.
+		Needs drawIndirectFirstInstance, without it the cpu path is kept.
+		*/
+		void setGpuDriven(bool enabled);
+		bool isGpuDriven() const { return m_gpuDriven; }
+
+		//culling counters of one frame, the cpu path only fills in the object & frustum counters 
+		struct CullingStats {
+			uint32_t objects = 0;//objects handed to the culling, one per mesh instance of models with a scene graph 
+			uint32_t frustumCulledObjects = 0;
+			uint32_t occlusionCulledObjects = 0;
+			uint32_t frustumCulledMeshes = 0;//draws of visible objects, gpu driven only 
+			uint32_t occlusionCulledMeshes = 0;
+			uint32_t visibleInstances = 0;//instances written, one per visible object & child model 
+			uint32_t draws = 0;//indirect commands before culling 
+			uint32_t visibleDraws = 0;//indirect commands left with instances 
+		};
+
+		/*
+		The cpu path tests the objects' bounding spheres against the camera frustum in one batch before
+		recording anything, the meshes of models with a scene graph are tested as objects of their own.
+		In gpu driven mode the instance pass does the same tests, plus one against the depth pyramid of the
+		previous frame when one is set. Draws that lose all their instances are dropped by the compaction pass.
+		*/
+		void setCullingEnabled(bool enabled) { m_cullingEnabled = enabled; }
+		bool isCullingEnabled() const { return m_cullingEnabled; }
+		void setDepthPyramid(NKDepthPyramid* depthPyramid) { m_depthPyramid = depthPyramid; }//occlusion culling source, null turns it off 
+
+		//gpu driven mode reads them back from the gpu, MAX_FRAMES_IN_FLIGHT frames behind the frame being recorded 
+		const CullingStats& getCullingStats() const { return m_cullingStats; }
+
+		//state changes of the last cpu path frame, summed over the recording threads 
+		struct BindStats {
+			uint32_t pipelineBinds = 0;
+			uint32_t pipelineBindsSkipped = 0;//groups that kept the pipeline of the one before 
+			uint32_t geometryBinds = 0;//vertex & index buffers 
+			uint32_t geometryBindsSkipped = 0;
+		};
+		const BindStats& getBindStats() const { return m_bindStats; }
+
+		//records the work that has to run outside the render pass, call it before beginSwapChainRenderPass 
+		void prepareGameObjects(FrameInfo& frameInfo);
+		//with frameInfo.secondaryPools set the cpu path splits its draws across the recording threads 
 		void renderGameObjects(FrameInfo& frameInfo);
 
+		//compiles every pipeline variant whose shaders are on disk up front instead of on the frame that first draws with it 
+		void precompilePipelines(NKJobSystem* jobSystem = nullptr);
+
 	private:
+		//pipeline variants, the bits combine 
+		enum PipelineVariant : uint32_t {
+			PIPELINE_PACKED = 1,//decodes NKModel::PackedVertex 
+			PIPELINE_INSTANCED = 2,//matrices from the instance buffer instead of push constants 
+			PIPELINE_VARIANT_COUNT = 4
+		};
+
+		//draw order of the cpu path, the variant is the pipeline field of the NKSortKey 
+		static constexpr uint32_t RENDER_PASS_OPAQUE = 0;
+
+		//one object to draw this frame, sorted by NKSortKey so objects sharing a pipeline & model end up next to each other 
+		struct DrawItem {
+			uint32_t variant;
+			uint32_t material;//into the material table, instances of one draw may differ 
+			NKModel* model;//never one with child models 
+			uint32_t transform;//into m_drawTransforms 
+		};
+
+		//run of draw items sharing a pipeline & model, recorded as one instanced draw or one draw per item 
+		struct DrawGroup {
+			NKPipeline* pipeline;
+			uint32_t firstItem;
+			uint32_t itemCount;
+			uint32_t firstInstance;
+			bool instanced;
+		};
+
+		//world matrices of a draw item, the entity's times the scene graph node's for child models 
+		struct DrawTransform {
+			glm::mat4 modelMatrix;
+			glm::mat3 normalMatrix;
+		};
+
+		//one child model drawn by the gpu driven path, draws sharing a batch key become one indirect draw 
+		struct IndirectDraw {
+			uint32_t variant;
+			NKGeometryHandle geometry;
+			NKGeometryRange range;
+			uint32_t entry;//the model & variant it was gathered for 
+			glm::vec4 boundingSphere;//of the child model, model space 
+		};
+
+		//a model drawn with one variant, the objects using it all get an instance in each of its draws 
+		struct IndirectEntry {
+			uint32_t firstDrawRef;
+			uint32_t drawRefCount;
+			uint32_t objectCount;
+			bool indexed;//models with non indexed meshes stay on the push constant path 
+		};
+
+		//one indirect draw call, its commands are [firstDraw, firstDraw + drawCount) of the command buffer 
+		struct IndirectBatch {
+			uint32_t variant;
+			NKGeometryHandle geometry;//any draw of the batch, they all bind the same buffers 
+			uint32_t firstDraw;
+			uint32_t drawCount;
+		};
+
+		//gpu driven resources of one frame in flight, they grow on demand 
+		struct IndirectFrame {
+			std::unique_ptr<NKBuffer> objects;//per object transform, draw refs & material 
+			std::unique_ptr<NKBuffer> draws;//one command per draw, the instance counts are filled in by the gpu 
+			std::unique_ptr<NKBuffer> drawRefs;//the draws of every entry 
+			std::unique_ptr<NKBuffer> drawBatches;//batch & first command of every draw 
+			std::unique_ptr<NKBuffer> instances;//written by indirectInstances.comp 
+			std::unique_ptr<NKBuffer> commands;//compacted by indirectCompact.comp 
+			std::unique_ptr<NKBuffer> counts;//commands written per batch 
+			std::unique_ptr<NKBuffer> drawBounds;//bounding sphere of every draw 
+			std::unique_ptr<NKBuffer> cullData;//frustum & occlusion camera 
+			std::unique_ptr<NKBuffer> stats;//culling counters, read back when the frame index comes around again 
+			VkDescriptorSet computeSet = VK_NULL_HANDLE;
+			VkDescriptorSet instanceSet = VK_NULL_HANDLE;
+			bool descriptorsDirty = false;
+			NKDepthPyramid* depthPyramid = nullptr;//the pyramid the compute set samples 
+			uint32_t depthPyramidGeneration = 0;
+			bool statsPending = false;
+			uint32_t statsObjects = 0;
+			uint32_t statsDraws = 0;
+		};
+
 		void createPipelineLayout(VkDescriptorSetLayout globalSetLayout);
 		void createPipeline(VkRenderPass renderPass);
+		void configurePipeline(uint32_t variant, PipelineConfigInfo& pipelineConfig, std::string& vertexShader, std::string& fragmentShader);
+		void createPipelineVariant(uint32_t variant);//everything except the two default pipelines is built on first use unless precompiled 
+		NKPipeline* getPipeline(uint32_t variant);
+		void createInstanceBuffers();
+		void reserveInstances(int frameIndex, uint32_t instanceCount);
+		void drawModel(VkCommandBuffer commandBuffer, NKModel& model, NKGeometryBindState& geometryBinds, uint32_t instanceCount, uint32_t firstInstance);
+		void addDrawItems(uint32_t variant, uint32_t material, NKModel& model, const TransformComponent& transform);//one per mesh instance of models with a scene graph 
+		void cullDrawItems();
+		void sortDrawItems(const NKCamera& camera);
+		void recordDrawGroups(FrameInfo& frameInfo, VkCommandBuffer commandBuffer, uint32_t firstGroup, uint32_t lastGroup, BindStats& bindStats);//safe to call from several threads 
+
+		void createIndirectResources();
+		bool reserveIndirectBuffer(std::unique_ptr<NKBuffer>& buffer, VkDeviceSize elementSize, uint32_t elementCount, VkBufferUsageFlags usage, VkMemoryPropertyFlags memoryProperties);
+		void writeIndirectDescriptors(IndirectFrame& frame);
+		uint32_t gatherIndirectDraws(FrameInfo& frameInfo, IndirectFrame& frame);//returns the object count 
+		void writeCullData(FrameInfo& frameInfo, IndirectFrame& frame);
+		void readCullingStats(IndirectFrame& frame);
+		void renderIndirect(FrameInfo& frameInfo);
+		PFN_vkCmdDrawIndexedIndirectCountKHR getIndirectCountDraw() const;//null when the batches draw every command, cleared or not 
 
 		NKDevice& m_systemDevice;
 
-		std::unique_ptr<NKPipeline> m_systemPipeline;//pointer to the unique pipeline 
-		std::unique_ptr<NKPipeline> m_systemPipelineCar;//pointer to the unique pipeline 
+		std::array<NKPipeline*, PIPELINE_VARIANT_COUNT> m_pipelines{};//indexed by PipelineVariant bits, owned by the device's pipeline registry 
+
+		VkRenderPass m_renderPass;//kept for the lazily created pipelines 
 
 		VkPipelineLayout pipelineLayout;//the pipeline layout 
+
+		//per frame instance data, set 1 of the instanced pipelines 
+		std::unique_ptr<NKDescriptorSetLayout> m_instanceSetLayout;
+		std::unique_ptr<NKDescriptorPool> m_instancePool;
+		std::vector<std::unique_ptr<NKBuffer>> m_instanceBuffers;
+		std::vector<VkDescriptorSet> m_instanceDescriptorSets;
+
+		std::vector<DrawItem> m_drawItems;//reused every frame 
+		std::vector<DrawItem> m_sortedItems;//m_drawItems in queue order, swapped with it after sorting 
+		NKRenderQueue m_renderQueue;
+		std::unordered_map<const NKModel*, uint32_t> m_meshRanks;//sortDrawItems scratch, model -> the mesh field of its keys 
+		std::vector<uint32_t> m_itemRanks;//sortDrawItems scratch, the rank of every draw item 
+		std::vector<DrawTransform> m_drawTransforms;
+		std::vector<DrawGroup> m_drawGroups;
+		std::vector<uint32_t> m_recordRanges;//first group of every recording thread, then the group count 
+		std::vector<VkCommandBuffer> m_secondaryBuffers;//one per recording thread 
+		std::vector<BindStats> m_recordBindStats;//one per recording thread 
+		BindStats m_bindStats{};
+		NKFrustum m_frustum;//of the frame being recorded 
+		NKSphereBatch m_cullSpheres;//world space spheres of m_drawItems 
+		std::vector<uint32_t> m_visibleItems;
+
+		bool m_gpuDriven = false;
+		bool m_indirectPrepared = false;//prepareGameObjects ran for the frame being recorded 
+
+		std::unique_ptr<NKDescriptorSetLayout> m_indirectSetLayout;//the storage buffers of the compute passes 
+		std::unique_ptr<NKDescriptorPool> m_indirectPool;
+		VkPipelineLayout m_indirectPipelineLayout = VK_NULL_HANDLE;
+		NKComputePipeline* m_indirectInstancesPipeline = nullptr;
+		NKComputePipeline* m_indirectCompactPipeline = nullptr;
+		std::vector<IndirectFrame> m_indirectFrames;
+
+		//rebuilt every frame, the entries are looked up per model with one slot per non instanced variant 
+		std::unordered_map<NKModel*, std::array<uint32_t, PIPELINE_INSTANCED>> m_indirectLookup;
+		std::vector<IndirectEntry> m_indirectEntries;
+		std::vector<IndirectDraw> m_indirectDraws;
+		std::vector<uint32_t> m_indirectDrawRefs;//gathered order, remapped to command order 
+		std::vector<uint32_t> m_indirectOrder;//draw indices sorted by batch 
+		std::vector<uint32_t> m_indirectCommandIndex;//gathered draw -> command 
+		std::vector<IndirectBatch> m_indirectBatches;
+		uint32_t m_indirectDrawCount = 0;
+
+		bool m_cullingEnabled = true;
+		NKDepthPyramid* m_depthPyramid = nullptr;//owned by the renderer 
+		std::unique_ptr<NKDepthPyramid> m_placeholderPyramid;//bound while there is no pyramid to sample 
+		CullingStats m_cullingStats{};
+		bool m_hasOcclusionCamera = false;//the previous frame's camera, the one the pyramid was rendered with 
+		glm::mat4 m_occlusionView{ 1.f };
+		glm::mat4 m_occlusionProjection{ 1.f };
 	};
 }  // namespace lve
@@ -1,4 +1,5 @@
 #include "vk_gameobject.hpp"
+#include "vk_simdmath.hpp"
 
 namespace nekographics {
 
@@ -59,12 +60,159 @@ namespace nekographics {
         };
     }
 
-    NkGameObject NkGameObject::makePointLight(float intensity, float radius, glm::vec3 color) {
-        NkGameObject gameObj = NkGameObject::createGameObject();
-        gameObj.color = color;
-        gameObj.transform.scale.x = radius;
-        gameObj.pointLight = std::make_unique<PointLightComponent>();
-        gameObj.pointLight->lightIntensity = intensity;
-        return gameObj;
+    NkEntity NKScene::createEntity() {
+        NkEntity entity = nextEntity;
+        if (!freeEntities.empty()) {
+            entity = freeEntities.back();
+            freeEntities.pop_back();
+        }
+        else {
+            nextEntity++;
+        }
+        transforms.add(entity);
+        return entity;
+    }
+
+    NkEntity NKScene::createPointLight(float intensity, float radius, glm::vec3 color) {
+        NkEntity entity = createEntity();
+        transforms.get(entity).scale.x = radius;
+        colors.add(entity, color);
+        pointLights.add(entity, PointLightComponent{ intensity });
+        return entity;
+    }
+
+    void NKScene::destroyEntity(NkEntity entity) {
+        if (!isAlive(entity)) return;
+
+        transforms.remove(entity);
+        colors.remove(entity);
+        models.remove(entity);
+        pointLights.remove(entity);
+        freeEntities.push_back(entity);
+
+        for (size_t slot = 0; slot < transforms.size(); ++slot) {
+            auto& transform = transforms.componentAt(slot);
+            if (transform.parent == entity) {
+                transform.parent = INVALID_ENTITY;
+            }
+        }
+    }
+
+    //same layout as TransformComponent::mat4 & normalMatrix, from sines & cosines of x, y & z 
+    static void composeLocal(TransformComponent& transform, const glm::vec3& s, const glm::vec3& c) {
+        const float c3 = c.z;
+        const float s3 = s.z;
+        const float c2 = c.x;
+        const float s2 = s.x;
+        const float c1 = c.y;
+        const float s1 = s.y;
+        const glm::vec3 axisX{ c1 * c3 + s1 * s2 * s3, c2 * s3, c1 * s2 * s3 - c3 * s1 };
+        const glm::vec3 axisY{ c3 * s1 * s2 - c1 * s3, c2 * c3, c1 * c3 * s2 + s1 * s3 };
+        const glm::vec3 axisZ{ c2 * s1, -s2, c1 * c2 };
+        const glm::vec3& scale = transform.scale;
+        const glm::vec3 invScale = 1.0f / scale;
+
+        transform.cache.local = glm::mat4{
+            glm::vec4(axisX * scale.x, 0.0f),
+            glm::vec4(axisY * scale.y, 0.0f),
+            glm::vec4(axisZ * scale.z, 0.0f),
+            glm::vec4(transform.translation, 1.0f) };
+        transform.cache.localNormal = glm::mat3{ axisX * invScale.x, axisY * invScale.y, axisZ * invScale.z };
+    }
+
+    void NKScene::updateTransforms(NKJobSystem* jobSystem) {
+        updateEpoch++;
+
+        //the fields are written directly, so dirty means different from what the cache was built from 
+        dirtySlots.clear();
+        for (size_t slot = 0; slot < transforms.size(); ++slot) {
+            const auto& transform = transforms.componentAt(slot);
+            const auto& cache = transform.cache;
+            if (!cache.valid || transform.translation != cache.translation
+                || transform.rotation != cache.rotation || transform.scale != cache.scale) {
+                dirtySlots.push_back(static_cast<uint32_t>(slot));
+            }
+        }
+
+        if (!dirtySlots.empty()) {
+            const size_t count = dirtySlots.size();
+            angles.resize(count * 3);
+            sines.resize(count * 3);
+            cosines.resize(count * 3);
+            for (size_t i = 0; i < count; ++i) {
+                const glm::vec3& rotation = transforms.componentAt(dirtySlots[i]).rotation;
+                angles[i] = rotation.x;
+                angles[count + i] = rotation.y;
+                angles[count * 2 + i] = rotation.z;
+            }
+
+            //every dirty transform is independent, the world matrices below are not 
+            auto composeRange = [this, count](uint32_t begin, uint32_t end) {
+                for (size_t axis = 0; axis < 3; ++axis) {
+                    const size_t first = count * axis + begin;
+                    sinCosBatch(angles.data() + first, sines.data() + first, cosines.data() + first, end - begin);
+                }
+
+                for (size_t i = begin; i < end; ++i) {
+                    auto& transform = transforms.componentAt(dirtySlots[i]);
+                    composeLocal(transform,
+                        glm::vec3(sines[i], sines[count + i], sines[count * 2 + i]),
+                        glm::vec3(cosines[i], cosines[count + i], cosines[count * 2 + i]));
+
+                    auto& cache = transform.cache;
+                    cache.translation = transform.translation;
+                    cache.rotation = transform.rotation;
+                    cache.scale = transform.scale;
+                    cache.valid = true;
+                    cache.localChanged = true;
+                }
+            };
+
+            if (jobSystem) {
+                jobSystem->parallelFor(static_cast<uint32_t>(count), TRANSFORMS_PER_JOB, composeRange);
+            }
+            else {
+                composeRange(0, static_cast<uint32_t>(count));
+            }
+        }
+
+        for (size_t slot = 0; slot < transforms.size(); ++slot) {
+            resolveWorld(transforms.componentAt(slot));
+        }
+    }
+
+    void NKScene::resolveWorld(TransformComponent& transform) {
+        auto& cache = transform.cache;
+        if (cache.epoch == updateEpoch) return;
+        cache.epoch = updateEpoch;//set before the parent is visited, a parent cycle stops here 
+
+        TransformComponent* parent = transform.parent != INVALID_ENTITY ? transforms.tryGet(transform.parent) : nullptr;
+        bool reparented = cache.parent != transform.parent;
+        cache.parent = transform.parent;
+
+        if (parent) {
+            resolveWorld(*parent);//parents first, they may sit after the child in the pool 
+            if (cache.localChanged || reparented || cache.parentWorldVersion != parent->cache.worldVersion) {
+                cache.world = parent->cache.world * cache.local;
+                cache.worldNormal = parent->cache.worldNormal * cache.localNormal;
+                cache.parentWorldVersion = parent->cache.worldVersion;
+                cache.worldVersion++;
+            }
+        }
+        else if (cache.localChanged || reparented) {
+            cache.world = cache.local;
+            cache.worldNormal = cache.localNormal;
+            cache.worldVersion++;
+        }
+        cache.localChanged = false;
+    }
+
+    bool ModelComponent::attachPendingModel() {
+        if (pendingModel.valid() &&
+            pendingModel.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            model = pendingModel.get();//rethrows if the file failed to load 
+            pendingModel = {};
+        }
+        return model != nullptr;
     }
 }  
\ No newline at end of file
@@ -14,67 +14,188 @@
 
 //includes 
 #include "vk_model.hpp"
+#include "vk_modelloader.hpp"
+#include "vk_jobsystem.hpp"
 
 //libs
 #include <glm/gtc/matrix_transform.hpp>
 
 // std
+#include <cassert>
 #include <memory>
-#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace nekographics {
 
+    using NkEntity = uint32_t;
+    static constexpr NkEntity INVALID_ENTITY = ~0u;
+
     //the transform component of the game object
     struct TransformComponent {
         glm::vec3 translation{};
         glm::vec3 scale{ 1.f, 1.f, 1.f };
         glm::vec3 rotation{};
 
+        //the world matrix is the parent's world matrix * this one when set 
+        NkEntity parent = INVALID_ENTITY;
+
         // Matrix corrsponds to Translate * Ry * Rx * Rz * Scale
         // Rotations correspond to Tait-bryan angles of Y(1), X(2), Z(3)
         // https://en.wikipedia.org/wiki/Euler_angles#Rotation_matrix
+        // Local matrix, computed on every call 
         glm::mat4 mat4();
 
         glm::mat3 normalMatrix();
+
+        //cached by NKScene::updateTransforms, edits made after it show up on the next update 
+        const glm::mat4& worldMatrix() const { return cache.world; }
+        const glm::mat3& worldNormalMatrix() const { return cache.worldNormal; }
+
+        //what the cached matrices were built from, owned by NKScene::updateTransforms 
+        struct Cache {
+            glm::mat4 local{ 1.f };
+            glm::mat3 localNormal{ 1.f };
+            glm::mat4 world{ 1.f };
+            glm::mat3 worldNormal{ 1.f };
+
+            glm::vec3 translation{};
+            glm::vec3 scale{};
+            glm::vec3 rotation{};
+            NkEntity parent = INVALID_ENTITY;
+
+            bool valid = false;//false until the first update 
+            bool localChanged = false;
+            uint32_t worldVersion = 0;//bumped whenever world changes, children compare it 
+            uint32_t parentWorldVersion = 0;//the parent's worldVersion world was built with 
+            uint32_t epoch = 0;//the update that last resolved world 
+        } cache;
     };
 
     struct PointLightComponent {
         float lightIntensity = 1.0f;
     };
 
+    //model of an entity, it may still be loading on the NKModelLoader 
+    struct ModelComponent {
+        std::shared_ptr<NKModel> model{};
+
+        //nothing is drawn until it lands in model
+        NKModelFuture pendingModel{};
 
+        //index into the material table, picks the textures every mesh of the model is shaded with
+        uint32_t material = 0;
 
-    class NkGameObject {
+        //moves a finished pending model into model, returns true if the entity has a model
+        bool attachPendingModel();
+    };
+
+    /*
+    Sparse set of one component type. The components are packed in a vector, sparse maps an entity to
+    its slot & entities maps a slot back. Add, remove & lookup are O(1), remove moves the last component
+    into the hole so references into the pool only last until the next add or remove.
+    */
+    template <typename T>
+    class NKComponentPool {
     public:
-        using id_t = unsigned int;
-        using Map = std::unordered_map<id_t, NkGameObject>;//unordered map of the game objects
+        static constexpr uint32_t INVALID_SLOT = ~0u;
+
+        template <typename... Args>
+        T& add(NkEntity entity, Args&&... args) {
+            if (entity >= sparse.size()) {
+                sparse.resize(static_cast<size_t>(entity) + 1, INVALID_SLOT);
+            }
+            assert(sparse[entity] == INVALID_SLOT && "Entity already has this component");
+            sparse[entity] = static_cast<uint32_t>(components.size());
+            entities.push_back(entity);
+            return components.emplace_back(std::forward<Args>(args)...);
+        }
+
+        void remove(NkEntity entity) {
+            if (!has(entity)) return;
+
+            uint32_t slot = sparse[entity];
+            uint32_t last = static_cast<uint32_t>(components.size()) - 1;
+            if (slot != last) {
+                components[slot] = std::move(components[last]);
+                entities[slot] = entities[last];
+                sparse[entities[slot]] = slot;
+            }
+            components.pop_back();
+            entities.pop_back();
+            sparse[entity] = INVALID_SLOT;
+        }
 
+        bool has(NkEntity entity) const { return entity < sparse.size() && sparse[entity] != INVALID_SLOT; }
 
-        static NkGameObject createGameObject() {
-            static id_t currentId = 0;
-            return NkGameObject{ currentId++ };
+        T& get(NkEntity entity) {
+            assert(has(entity) && "Entity does not have this component");
+            return components[sparse[entity]];
+        }
+        const T& get(NkEntity entity) const {
+            assert(has(entity) && "Entity does not have this component");
+            return components[sparse[entity]];
+        }
+        T* tryGet(NkEntity entity) { return has(entity) ? &components[sparse[entity]] : nullptr; }
+
+        //packed iteration, slot i belongs to entityAt(i) 
+        size_t size() const { return components.size(); }
+        bool empty() const { return components.empty(); }
+        NkEntity entityAt(size_t slot) const { return entities[slot]; }
+        T& componentAt(size_t slot) { return components[slot]; }
+        const T& componentAt(size_t slot) const { return components[slot]; }
+
+        void reserve(size_t count) {
+            entities.reserve(count);
+            components.reserve(count);
         }
 
-        static NkGameObject makePointLight(
-            float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
+    private:
+        std::vector<uint32_t> sparse;//entity -> slot 
+        std::vector<NkEntity> entities;//slot -> entity 
+        std::vector<T> components;
+    };
 
-        NkGameObject(const NkGameObject&) = delete;
-        NkGameObject& operator=(const NkGameObject&) = delete;
-        NkGameObject(NkGameObject&&) = default;
-        NkGameObject& operator=(NkGameObject&&) = default;
+    /*
+    The entities of a scene with their components packed per type, systems walk only the pools they need.
+    Every entity has a transform, the other components are optional. Ids stay the same for the life of
+    the entity & are handed out again after destroyEntity.
+    */
+    class NKScene {
+    public:
+        NkEntity createEntity();
+        NkEntity createPointLight(
+            float intensity = 10.f, float radius = 0.1f, glm::vec3 color = glm::vec3(1.f));
+        void destroyEntity(NkEntity entity);//children of the entity become roots 
 
-        id_t getId() { return id; }
+        /*
+        Rebuilds the cached matrices of every transform whose translation, rotation, scale or parent changed
+        since the last update, then the world matrices of those & of their descendants. The sin & cos of the
+        dirty transforms are computed in one batch, split over the job system's threads when one is given.
+        Call once a frame before anything reads worldMatrix.
+        */
+        void updateTransforms(NKJobSystem* jobSystem = nullptr);
 
-        glm::vec3 color{};//the color component of the model 
-        TransformComponent transform{};//transform component of the model which is definitely needed
+        bool isAlive(NkEntity entity) const { return transforms.has(entity); }
+        size_t getEntityCount() const { return transforms.size(); }
 
-        //optional pointer components
-        std::shared_ptr<NKModel> model{};
-        std::unique_ptr<PointLightComponent> pointLight = nullptr;
+        NKComponentPool<TransformComponent> transforms;
+        NKComponentPool<glm::vec3> colors;//the color component of the model 
+        NKComponentPool<ModelComponent> models;
+        NKComponentPool<PointLightComponent> pointLights;
 
-        NkGameObject(id_t objId = 0) : id{ objId } {}
     private:
-
-        id_t id;
+        void resolveWorld(TransformComponent& transform);
+
+        std::vector<NkEntity> freeEntities;
+        NkEntity nextEntity = 0;
+
+        //updateTransforms scratch, kept to skip the allocations 
+        static constexpr uint32_t TRANSFORMS_PER_JOB = 1024;
+        uint32_t updateEpoch = 0;
+        std::vector<uint32_t> dirtySlots;
+        std::vector<float> angles;//x of every dirty transform, then y, then z 
+        std::vector<float> sines;
+        std::vector<float> cosines;
     };
 } 
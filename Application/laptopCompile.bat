@@ -1,7 +1,11 @@
-C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/shaderSkull.vert -o Shaders/shaderSkull.vert.spv
-C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/shaderSkull.frag -o Shaders/shaderSkull.frag.spv
-C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/shaderCar.vert -o Shaders/shaderCar.vert.spv
-C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/shaderCar.frag -o Shaders/shaderCar.frag.spv
+C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/shaderMaterial.vert -o Shaders/shaderMaterial.vert.spv
+C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/shaderMaterialInstanced.vert -o Shaders/shaderMaterialInstanced.vert.spv
+C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/shaderMaterialPacked.vert -o Shaders/shaderMaterialPacked.vert.spv
+C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/shaderMaterialPackedInstanced.vert -o Shaders/shaderMaterialPackedInstanced.vert.spv
+C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/shaderMaterial.frag -o Shaders/shaderMaterial.frag.spv
 C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/pointLight.vert -o Shaders/pointLight.vert.spv
 C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/pointLight.frag -o Shaders/pointLight.frag.spv
+C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/indirectInstances.comp -o Shaders/indirectInstances.comp.spv
+C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/indirectCompact.comp -o Shaders/indirectCompact.comp.spv
+C:/VulkanSDK/1.2.170.0/Bin/glslc.exe Shaders/depthPyramid.comp -o Shaders/depthPyramid.comp.spv
 pause
\ No newline at end of file
@@ -27,4 +27,6 @@ int main() {
 	///////////////////////////////////////////////////////////////////////////
 
 	if constexpr (!false) if (auto err = meshViewer(); err) return err;
+	if constexpr (false) if (auto err = headlessBenchmark(); err) return err;
+	if constexpr (false) if (auto err = jobSystemBenchmark(); err) return err;
 }
@@ -19,7 +19,7 @@
 namespace nekographics {
 
     void KeyboardMovementController::moveInPlaneXZ(
-        VkWindow* window, float dt, NkGameObject& gameObject) {
+        VkWindow* window, float dt, TransformComponent& transform) {
 
         /*********
         Check if wants to switch camera mode
@@ -47,14 +47,14 @@ namespace nekographics {
 
         //calculating the rotation 
         if (glm::dot(rotate, rotate) > std::numeric_limits<float>::epsilon()) {
-            gameObject.transform.rotation += lookSpeed * dt * glm::normalize(rotate);
+            transform.rotation += lookSpeed * dt * glm::normalize(rotate);
         }
 
         // limit pitch values between about +/- 85ish degrees
-        gameObject.transform.rotation.x = glm::clamp(gameObject.transform.rotation.x, -1.5f, 1.5f);
-        gameObject.transform.rotation.y = glm::mod(gameObject.transform.rotation.y, glm::two_pi<float>());
+        transform.rotation.x = glm::clamp(transform.rotation.x, -1.5f, 1.5f);
+        transform.rotation.y = glm::mod(transform.rotation.y, glm::two_pi<float>());
 
-        float yaw = gameObject.transform.rotation.y;
+        float yaw = transform.rotation.y;
         const glm::vec3 forwardDir{ sin(yaw), 0.f, cos(yaw) };
         const glm::vec3 rightDir{ forwardDir.z, 0.f, -forwardDir.x };
         const glm::vec3 upDir{ 0.f, -1.f, 0.f };
@@ -76,7 +76,7 @@ namespace nekographics {
 
         //calculating the translation
         if (glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon()) {
-            gameObject.transform.translation += moveSpeed * dt * glm::normalize(moveDir);
+            transform.translation += moveSpeed * dt * glm::normalize(moveDir);
         }
     }
 
@@ -90,7 +90,7 @@ namespace nekographics {
         return glm::acos(glm::dot(da, db));
     }
 
-    void KeyboardMovementController::moveThirdPerson(float dt, NkGameObject::Map& gameObject, NkGameObject& camera) {
+    void KeyboardMovementController::moveThirdPerson(float dt, NKScene& scene, TransformComponent& camera) {
 
         static TransformComponent currentGameObject; 
 
@@ -98,14 +98,14 @@ namespace nekographics {
         Toggle between the 2 models
         ***********/
         if (KeyManager.isKeyTriggered('1') && modelNumber == false) {
-            currentGameObject = gameObject[0].transform;
-            std::swap(gameObject[0].transform.translation, gameObject[1].transform.translation);
+            currentGameObject = scene.transforms.get(0);
+            std::swap(scene.transforms.get(0).translation, scene.transforms.get(1).translation);
             modelNumber = true;//switching the model number 
             std::cout << "viewing model skull\n";//printing out the model 
         }
         else if (KeyManager.isKeyTriggered('2') && modelNumber == true) {
-            currentGameObject = gameObject[1].transform;
-            std::swap(gameObject[0].transform.translation, gameObject[1].transform.translation);
+            currentGameObject = scene.transforms.get(1);
+            std::swap(scene.transforms.get(0).translation, scene.transforms.get(1).translation);
             modelNumber = false;//switching the model number 
             std::cout << "viewing model car\n";//printing out the model 
         }
@@ -150,7 +150,7 @@ namespace nekographics {
         /*********
         Rotating the Cube Object
         ***********/
-        glm::vec3 resultingVector = glm::vec3(0.f,0.f,0.f) - camera.transform.translation;//vector to game object
+        glm::vec3 resultingVector = glm::vec3(0.f,0.f,0.f) - camera.translation;//vector to game object
 
 
         const glm::vec3 forwardDir{ resultingVector };
@@ -162,7 +162,7 @@ namespace nekographics {
         if (MouseManager.getMouseScroll() > 0) {
             const float clampDistance = 0.3f;
             //clamp if too near to the box 
-            if (glm::distance(glm::vec3(0.f,0.f,0.f), camera.transform.translation) <= 3.f) {
+            if (glm::distance(glm::vec3(0.f,0.f,0.f), camera.translation) <= 3.f) {
                 moveDir = { 0.f,0.f,0.f };
             }
             else {
@@ -180,23 +180,23 @@ namespace nekographics {
         if (KeyManager.isKeyPressed('D')) {
             glm::vec3 rotationAxis = { 0.f,-1.f,0.f };
             glm::mat4 rot_mat = glm::rotate(glm::mat4(1.f), glm::radians(degree), rotationAxis);
-            camera.transform.translation = glm::vec3(glm::vec4(camera.transform.translation, 1.0f) * rot_mat);
+            camera.translation = glm::vec3(glm::vec4(camera.translation, 1.0f) * rot_mat);
         }
         float degreeOpp = -0.2f;
         if (KeyManager.isKeyPressed('A')) {
             glm::vec3 rotationAxis = { 0.f,-1.f,0.f };
             glm::mat4 rot_mat = glm::rotate(glm::mat4(1.f), glm::radians(degreeOpp), rotationAxis);
-            camera.transform.translation = glm::vec3(glm::vec4(camera.transform.translation, 1.0f) * rot_mat);
+            camera.translation = glm::vec3(glm::vec4(camera.translation, 1.0f) * rot_mat);
         }
         if (KeyManager.isKeyPressed('W')) {
             glm::vec3 rotationAxis = { -1.f,0.f,0.f };
             glm::mat4 rot_mat = glm::rotate(glm::mat4(1.f), glm::radians(degree), rotationAxis);
-            camera.transform.translation = glm::vec3(glm::vec4(camera.transform.translation, 1.0f) * rot_mat);
+            camera.translation = glm::vec3(glm::vec4(camera.translation, 1.0f) * rot_mat);
         }
         if (KeyManager.isKeyPressed('S')) {
             glm::vec3 rotationAxis = { -1.f,0.f,0.f };
             glm::mat4 rot_mat = glm::rotate(glm::mat4(1.f), glm::radians(degreeOpp), rotationAxis);
-            camera.transform.translation = glm::vec3(glm::vec4(camera.transform.translation, 1.0f) * rot_mat);
+            camera.translation = glm::vec3(glm::vec4(camera.translation, 1.0f) * rot_mat);
         }
 
 
@@ -207,13 +207,13 @@ namespace nekographics {
             float mouseDegree = 0.2f * MouseManager.getMousePosition_Relative().x;
             glm::vec3 rotationAxis = { 0.f,-1.f,0.f };
             glm::mat4 rot_mat = glm::rotate(glm::mat4(1.f), glm::radians(mouseDegree), rotationAxis);
-            camera.transform.translation = glm::vec3(glm::vec4(camera.transform.translation, 1.0f) * rot_mat);
+            camera.translation = glm::vec3(glm::vec4(camera.translation, 1.0f) * rot_mat);
 
 
             float mouseDegreeY = -0.2f * MouseManager.getMousePosition_Relative().y;
             glm::vec3 rotationAxisY = { -1.f,0.f,0.f };
             glm::mat4 rot_matY = glm::rotate(glm::mat4(1.f), glm::radians(mouseDegreeY), rotationAxisY);
-            camera.transform.translation = glm::vec3(glm::vec4(camera.transform.translation, 1.0f) * rot_matY);
+            camera.translation = glm::vec3(glm::vec4(camera.translation, 1.0f) * rot_matY);
         }
 
 
@@ -221,7 +221,7 @@ namespace nekographics {
         Recalculating translation 
         ***********/
         if (glm::dot(moveDir, moveDir) > std::numeric_limits<float>::epsilon()) {
-            camera.transform.translation += moveSpeed * dt * glm::normalize(moveDir);
+            camera.translation += moveSpeed * dt * glm::normalize(moveDir);
         }
     }
 }  
@@ -21,8 +21,8 @@ namespace nekographics {
     class KeyboardMovementController {
     public:
 
-        void moveInPlaneXZ(VkWindow* window, float dt, NkGameObject& gameObject);//moving the plane xz 
-        void moveThirdPerson(float dt, NkGameObject::Map& gameObject, NkGameObject& camera);//moving in third person perspective 
+        void moveInPlaneXZ(VkWindow* window, float dt, TransformComponent& transform);//moving the plane xz 
+        void moveThirdPerson(float dt, NKScene& scene, TransformComponent& camera);//moving in third person perspective, swaps entities 0 & 1 
 
         bool firstPerson = false;//tracks first person or third person perspective 
 
@@ -1,24 +1,32 @@
 #include "renderer.hpp"
+#ifdef _WIN32
+#include "WindowManager.h"
+#endif
 
 // std
+#include <algorithm>
 #include <array>
 #include <cassert>
 #include <stdexcept>
 
 namespace nekographics {
 
-    NKRenderer::NKRenderer(VkWindow& window, NKDevice& device)
-        : m_RendererWindow{ window }, m_RendererDevice{ device } {
+    NKRenderer::NKRenderer(VkWindow* window, NKDevice& device, VkExtent2D headlessExtent)
+        : m_RendererWindow{ window }, m_headlessExtent{ headlessExtent }, m_RendererDevice{ device } {
+        assert((window != nullptr || device.isHeadless()) && "A renderer without a window needs a headless device");
         recreateSwapChain();//recreating the swap chain 
-        createCommandBuffers();//creating the command buffer 
+        m_commandPools = std::make_unique<NKFrameCommandPools>(m_RendererDevice, 1);//the primaries, more threads with secondary recording 
     }
 
-    NKRenderer::~NKRenderer() { freeCommandBuffers(); }
+    NKRenderer::~NKRenderer() {
+        vkDeviceWaitIdle(m_RendererDevice.device());//the pools' buffers may still be executing 
+    }
 
     void NKRenderer::recreateSwapChain() {
-        auto extent = m_RendererWindow.getExtent();
+        auto extent = getWindowExtent();
         while (extent.width == 0 || extent.height == 0) {
-            extent = m_RendererWindow.getExtent();
+            assert(m_RendererWindow && "Headless extent can't be empty");
+            extent = getWindowExtent();
             //glfwWaitEvents();
         }
         vkDeviceWaitIdle(m_RendererDevice.device());
@@ -35,33 +43,36 @@ namespace nekographics {
                 throw std::runtime_error("Swap chain image(or depth) format has changed!");
             }
         }
+
+        //the device is idle, the pyramid can be recreated in place 
+        if (m_depthPyramid != nullptr) {
+            m_depthPyramid->resize(m_RendererSwapchain->getSwapChainExtent());
+        }
     }
 
-    void NKRenderer::createCommandBuffers() {
-        commandBuffers.resize(NKSwapChain::MAX_FRAMES_IN_FLIGHT);
+#ifdef _WIN32
+    VkExtent2D NKRenderer::getWindowExtent() const {
+        return m_RendererWindow ? m_RendererWindow->getExtent() : m_headlessExtent;
+    }
 
-        //allocate command buffer 
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;//primary vs secondary 
-        allocInfo.commandPool = m_RendererDevice.getCommandPool();//getting the command pool
-        allocInfo.commandBufferCount = static_cast<uint32_t>(commandBuffers.size());
+    bool NKRenderer::isWindowMinimised() const {
+        return m_RendererWindow && m_RendererWindow->isMinimised();
+    }
 
-        //allocate the command buffer 
-        if (vkAllocateCommandBuffers(m_RendererDevice.device(), &allocInfo, commandBuffers.data()) !=
-            VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate command buffers!");
-        }
+    bool NKRenderer::wasWindowResized() const {
+        return m_RendererWindow && m_RendererWindow->wasWindowResize();
     }
 
-    void NKRenderer::freeCommandBuffers() {
-        vkFreeCommandBuffers(
-            m_RendererDevice.device(),
-            m_RendererDevice.getCommandPool(),
-            static_cast<uint32_t>(commandBuffers.size()),
-            commandBuffers.data());
-        commandBuffers.clear();
+    void NKRenderer::resetWindowResized() {
+        if (m_RendererWindow) m_RendererWindow->resetWindowResizedFlag();
     }
+#else
+    //only win32 windows exist, anywhere else the renderer is headless 
+    VkExtent2D NKRenderer::getWindowExtent() const { return m_headlessExtent; }
+    bool NKRenderer::isWindowMinimised() const { return false; }
+    bool NKRenderer::wasWindowResized() const { return false; }
+    void NKRenderer::resetWindowResized() {}
+#endif
 
     VkCommandBuffer NKRenderer::beginFrame() {
         assert(!isFrameStarted && "Can't call beginFrame while already in progress");
@@ -70,7 +81,7 @@ namespace nekographics {
         auto result = m_RendererSwapchain->acquireNextImage(&currentImageIndex);
         //check if the swap chain is out of date
         if (result == VK_ERROR_OUT_OF_DATE_KHR) {
-            if (!m_RendererWindow.isMinimised()) {
+            if (!isWindowMinimised()) {
                 recreateSwapChain();//recreate the swap chain
                 return nullptr;//indicate that the frame is not successful
             }
@@ -82,9 +93,14 @@ namespace nekographics {
 
         isFrameStarted = true;
 
+        //the fence of this frame has signalled, every command buffer of its pools is recorded over 
+        m_commandPools->beginFrame(currentFrameIndex);
+        currentCommandBuffer = m_commandPools->getPrimary();
+
         auto commandBuffer = getCurrentCommandBuffer();
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;//setting the command buffer begin info 
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;//recorded again every time the frame comes around 
 
         //begin the record the command buffer 
         if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
@@ -96,18 +112,34 @@ namespace nekographics {
     void NKRenderer::endFrame() {
         assert(isFrameStarted && "Can't call endFrame while frame is not in progress");
         auto commandBuffer = getCurrentCommandBuffer();
+
+        //copy the offscreen image out before closing the command buffer 
+        if (m_RendererDevice.isHeadless() && readbackEnabled) {
+            m_RendererSwapchain->recordReadback(commandBuffer, currentImageIndex);
+        }
+
         if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
             throw std::runtime_error("failed to record command buffer!");
         }
 
+        //pending uploads go to the queue ahead of the frame that may draw them 
+        m_RendererDevice.getUploadManager().flush();
+
         auto result = m_RendererSwapchain->submitCommandBuffers(&commandBuffer, &currentImageIndex);//submitting the comamnd buffer to graphics queue 
+        lastSubmittedImageIndex = currentImageIndex;
+        m_RendererDevice.getGeometryPool().endFrame();//recycles meshes freed a few frames ago 
 
-        //check if the swap chain is out of date , or it is resized 
-        if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
-            m_RendererWindow.wasWindowResize()) {
+        //check if the swap chain is out of date , or it is resized, offscreen images never go out of date 
+        if (m_RendererDevice.isHeadless()) {
+            if (result != VK_SUCCESS) {
+                throw std::runtime_error("failed to submit offscreen frame!");
+            }
+        }
+        else if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR ||
+            wasWindowResized()) {
 
-            if (m_RendererWindow.isMinimised()) {
-                m_RendererWindow.resetWindowResizedFlag();
+            if (isWindowMinimised()) {
+                resetWindowResized();
                 recreateSwapChain();
             }
         }
@@ -119,6 +151,33 @@ namespace nekographics {
         currentFrameIndex = (currentFrameIndex + 1) % NKSwapChain::MAX_FRAMES_IN_FLIGHT;//setting the frames index 
     }
 
+    bool NKRenderer::readLastFrame(std::vector<uint8_t>& pixels) {
+        assert(!isFrameStarted && "Can't read back a frame while one is in progress");
+        return m_RendererSwapchain->readbackImage(lastSubmittedImageIndex, pixels);
+    }
+
+    void NKRenderer::setDepthPyramidEnabled(bool enable) {
+        depthPyramidEnabled = enable && m_RendererSwapchain->isDepthSampleable();
+        if (depthPyramidEnabled && m_depthPyramid == nullptr) {
+            m_depthPyramid = std::make_unique<NKDepthPyramid>(m_RendererDevice, m_RendererSwapchain->getSwapChainExtent(), m_RendererSwapchain->getDepthFormat());
+        }
+        else if (!depthPyramidEnabled && m_depthPyramid != nullptr) {
+            m_depthPyramid->invalidate();//stops occlusion culling against a stale pyramid 
+        }
+    }
+
+    void NKRenderer::setSecondaryRecording(uint32_t threadCount) {
+        assert(!isFrameStarted && "Can't change how the render pass is recorded while a frame is in progress");
+        secondaryRecording = threadCount > 0;
+        if (std::max(threadCount, 1u) == m_commandPools->getThreadCount()) {
+            return;
+        }
+
+        //the frames in flight may still be executing command buffers of the old pools 
+        vkDeviceWaitIdle(m_RendererDevice.device());
+        m_commandPools = std::make_unique<NKFrameCommandPools>(m_RendererDevice, std::max(threadCount, 1u));
+    }
+
     void NKRenderer::beginSwapChainRenderPass(VkCommandBuffer commandBuffer) {
         assert(isFrameStarted && "Can't call beginSwapChainRenderPass if frame is not in progress");
         assert(
@@ -142,6 +201,13 @@ namespace nekographics {
         renderPassInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
         renderPassInfo.pClearValues = clearValues.data();
 
+        //with secondary recording the primary only executes the secondaries until the render pass ends 
+        if (secondaryRecording) {
+            m_commandPools->setRenderPass(renderPassInfo.renderPass, renderPassInfo.framebuffer, renderPassInfo.renderArea.extent);
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+            return;//the secondaries set their own viewport & scissor 
+        }
+
         vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);//begining the render pass, VK_SUBPASS_CONTENTS_INLINE tells that only primary command buffer is being used
 
         //setting up the viewport and the scissor 
@@ -163,6 +229,15 @@ namespace nekographics {
             commandBuffer == getCurrentCommandBuffer() &&
             "Can't end render pass on command buffer from a different frame");
         vkCmdEndRenderPass(commandBuffer);//ending the render pass 
+
+        //reduced while the depth is still around, culling in the next frame tests against it 
+        if (depthPyramidEnabled) {
+            m_depthPyramid->build(
+                commandBuffer,
+                currentFrameIndex,
+                m_RendererSwapchain->getDepthImage(static_cast<int>(currentImageIndex)),
+                m_RendererSwapchain->getDepthImageView(static_cast<int>(currentImageIndex)));
+        }
     }
 
 }  
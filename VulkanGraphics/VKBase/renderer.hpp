@@ -2,8 +2,9 @@
 
 #include "vk_device.hpp"
 #include "vk_swapchain.hpp"
-#include "WindowManager.h"
 #include "vk_frameinfo.hpp"
+#include "vk_depthpyramid.hpp"
+#include "vk_commandpool.hpp"
 
 // std
 #include <cassert>
@@ -14,7 +15,8 @@
 namespace nekographics {
     class NKRenderer {
     public:
-        NKRenderer(VkWindow& window, NKDevice& device);
+        //without a window the device must be headless, frames are rendered offscreen at headlessExtent 
+        NKRenderer(VkWindow* window, NKDevice& device, VkExtent2D headlessExtent = { 0, 0 });
         ~NKRenderer();
 
         NKRenderer(const NKRenderer&) = delete;
@@ -22,11 +24,12 @@ namespace nekographics {
 
         VkRenderPass getSwapChainRenderPass() const { return m_RendererSwapchain->getRenderPass(); }//getting the swap chain render pass
         float getAspectRatio() const { return m_RendererSwapchain->extentAspectRatio(); }
+        VkExtent2D getSwapChainExtent() const { return m_RendererSwapchain->getSwapChainExtent(); }
         bool isFrameInProgress() const { return isFrameStarted; }
 
         VkCommandBuffer getCurrentCommandBuffer() const {
             assert(isFrameStarted && "Cannot get command buffer when frame not in progress");
-            return commandBuffers[currentFrameIndex];
+            return currentCommandBuffer;
         }
 
         int getFrameIndex() const {
@@ -34,23 +37,50 @@ namespace nekographics {
             return currentFrameIndex;
         }
 
+        //headless only, copies every rendered frame into a host visible buffer
+        void setReadbackEnabled(bool enable) { readbackEnabled = enable; }
+        bool readLastFrame(std::vector<uint8_t>& pixels);//waits for the last submitted frame and copies it out 
+
+        //hi-z pyramid of the depth attachment, rebuilt at the end of every swap chain render pass while enabled 
+        void setDepthPyramidEnabled(bool enable);
+        NKDepthPyramid* getDepthPyramid() const { return m_depthPyramid.get(); }//null until enabled or when the depth format can't be sampled 
+
+        /*
+        Records the swap chain render pass from secondary command buffers, the systems split their draws
+        across threadCount threads & execute the secondaries from the primary. 0 goes back to recording inline.
+        Only between frames.
+        */
+        void setSecondaryRecording(uint32_t threadCount);
+        NKFrameCommandPools* getSecondaryCommandPools() const { return secondaryRecording ? m_commandPools.get() : nullptr; }//null while recording inline 
+
         VkCommandBuffer beginFrame();
         void endFrame();
         void beginSwapChainRenderPass(VkCommandBuffer commandBuffer);
         void endSwapChainRenderPass(VkCommandBuffer commandBuffer);
 
     private:
-        void createCommandBuffers();
-        void freeCommandBuffers();
         void recreateSwapChain();
 
-        VkWindow& m_RendererWindow;//reference tothe renderer window 
+        //the window queries, headless renderers have no window to ask 
+        VkExtent2D getWindowExtent() const;
+        bool isWindowMinimised() const;
+        bool wasWindowResized() const;
+        void resetWindowResized();
+
+        VkWindow* m_RendererWindow;//the renderer window, null when headless 
+        VkExtent2D m_headlessExtent;//size of the offscreen images without a window 
         NKDevice& m_RendererDevice;//references to the renderer device
         std::unique_ptr<NKSwapChain> m_RendererSwapchain;//renderer swapchain
-        std::vector<VkCommandBuffer> commandBuffers;//stores the command buffers
+        VkCommandBuffer currentCommandBuffer{ VK_NULL_HANDLE };//primary of the frame in progress, from m_commandPools 
+        std::unique_ptr<NKDepthPyramid> m_depthPyramid;//kept once created so the systems holding it stay valid 
+        bool depthPyramidEnabled{ false };
+        std::unique_ptr<NKFrameCommandPools> m_commandPools;//per frame & thread, reset wholesale when the frame comes around 
+        bool secondaryRecording{ false };
 
         //tracking the frame 
         uint32_t currentImageIndex;//tracking the frame that is in progress
+        uint32_t lastSubmittedImageIndex{ 0 };//image of the most recently submitted frame 
+        bool readbackEnabled{ false };
         int currentFrameIndex{ 0 };//keep track of frame 0 to max frame index in flight 
         bool isFrameStarted{ false };
     };
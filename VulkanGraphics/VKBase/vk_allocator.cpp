@@ -0,0 +1,337 @@
+//includes
+#include "vk_allocator.hpp"
+
+// std headers
+#include <algorithm>
+#include <stdexcept>
+
+namespace nekographics {
+
+    static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+        return alignment > 1 ? (value + alignment - 1) / alignment * alignment : value;
+    }
+
+    static VkDeviceSize alignDown(VkDeviceSize value, VkDeviceSize alignment) {
+        return alignment > 1 ? value / alignment * alignment : value;
+    }
+
+    NKAllocator::NKAllocator(VkDevice deviceRef, VkPhysicalDevice physicalDevice) : device{ deviceRef } {
+        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        nonCoherentAtomSize = std::max<VkDeviceSize>(properties.limits.nonCoherentAtomSize, 1);
+
+        //linear & optimal pool for every memory type
+        pools.resize(static_cast<size_t>(memoryProperties.memoryTypeCount) * 2);
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            pools[i * 2].memoryTypeIndex = i;
+            pools[i * 2 + 1].memoryTypeIndex = i;
+        }
+    }
+
+    NKAllocator::~NKAllocator() {
+        for (auto& pool : pools) {
+            for (auto& block : pool.blocks) {
+                if (block) freeBlock(*block);
+            }
+        }
+        for (auto& block : dedicatedBlocks) {
+            if (block) freeBlock(*block);
+        }
+    }
+
+    uint32_t NKAllocator::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties) {
+        for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+            if ((typeFilter & (1 << i)) &&
+                (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+                return i;
+            }
+        }
+
+        throw std::runtime_error("failed to find suitable memory type!");
+    }
+
+    VkDeviceSize NKAllocator::preferredBlockSize(uint32_t memoryTypeIndex) const {
+        //small heaps (integrated gpus, the 256mb bar heap) get smaller blocks so one block can't eat the heap
+        VkDeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[memoryTypeIndex].heapIndex].size;
+        if (heapSize <= 1024ull * 1024 * 1024) {
+            return alignUp(heapSize / 8, 32);
+        }
+        return DEFAULT_BLOCK_SIZE;
+    }
+
+    std::unique_ptr<NKAllocator::Block> NKAllocator::allocateBlock(uint32_t memoryTypeIndex, VkDeviceSize size) {
+        VkMemoryAllocateInfo allocInfo{};
+        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+        allocInfo.allocationSize = size;
+        allocInfo.memoryTypeIndex = memoryTypeIndex;
+
+        auto block = std::make_unique<Block>();
+        if (vkAllocateMemory(device, &allocInfo, nullptr, &block->memory) != VK_SUCCESS) {
+            throw std::runtime_error("failed to allocate device memory block!");
+        }
+        block->size = size;
+        block->memoryTypeIndex = memoryTypeIndex;
+        block->freeRanges.emplace(0, size);
+
+        //host visible blocks stay mapped, sub allocations just offset into it
+        if (memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) {
+            if (vkMapMemory(device, block->memory, 0, VK_WHOLE_SIZE, 0, &block->mapped) != VK_SUCCESS) {
+                vkFreeMemory(device, block->memory, nullptr);//the block never reaches the pools, nothing else frees it
+                throw std::runtime_error("failed to map device memory block!");
+            }
+        }
+        return block;
+    }
+
+    void NKAllocator::freeBlock(Block& block) {
+        if (block.mapped) {
+            vkUnmapMemory(device, block.memory);
+            block.mapped = nullptr;
+        }
+        vkFreeMemory(device, block.memory, nullptr);
+        block.memory = VK_NULL_HANDLE;
+    }
+
+    bool NKAllocator::allocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset) {
+        //best fit, the smallest free range the aligned request fits in
+        auto best = block.freeRanges.end();
+        for (auto it = block.freeRanges.begin(); it != block.freeRanges.end(); ++it) {
+            VkDeviceSize aligned = alignUp(it->first, alignment);
+            if (aligned + size > it->first + it->second) continue;
+            if (best == block.freeRanges.end() || it->second < best->second) {
+                best = it;
+                if (best->second == size) break;//can't do better than an exact fit
+            }
+        }
+
+        if (best == block.freeRanges.end()) {
+            return false;
+        }
+
+        VkDeviceSize rangeOffset = best->first;
+        VkDeviceSize rangeEnd = best->first + best->second;
+        VkDeviceSize aligned = alignUp(rangeOffset, alignment);
+        block.freeRanges.erase(best);
+
+        //alignment padding in front & the tail stay free
+        if (aligned > rangeOffset) {
+            block.freeRanges.emplace(rangeOffset, aligned - rangeOffset);
+        }
+        if (aligned + size < rangeEnd) {
+            block.freeRanges.emplace(aligned + size, rangeEnd - (aligned + size));
+        }
+
+        block.usedBytes += size;
+        block.allocationCount++;
+        outOffset = aligned;
+        return true;
+    }
+
+    void NKAllocator::freeToBlock(Block& block, VkDeviceSize offset, VkDeviceSize size) {
+        auto inserted = block.freeRanges.emplace(offset, size).first;
+
+        //merge with the next range
+        auto next = std::next(inserted);
+        if (next != block.freeRanges.end() && inserted->first + inserted->second == next->first) {
+            inserted->second += next->second;
+            block.freeRanges.erase(next);
+        }
+
+        //merge with the previous range
+        if (inserted != block.freeRanges.begin()) {
+            auto prev = std::prev(inserted);
+            if (prev->first + prev->second == inserted->first) {
+                prev->second += inserted->second;
+                block.freeRanges.erase(inserted);
+            }
+        }
+
+        block.usedBytes -= size;
+        block.allocationCount--;
+    }
+
+    NKAllocation NKAllocator::allocate(
+        const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear) {
+        std::lock_guard<std::mutex> lock{ allocatorMutex };
+
+        NKAllocation allocation{};
+        allocation.memoryTypeIndex = findMemoryType(requirements.memoryTypeBits, properties);
+
+        VkDeviceSize size = requirements.size;
+        VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+
+        //keep non coherent ranges atom aligned so flushes never need to touch a neighbour
+        VkMemoryPropertyFlags typeFlags = memoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags;
+        if ((typeFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(typeFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+            alignment = std::max(alignment, nonCoherentAtomSize);
+            size = alignUp(size, nonCoherentAtomSize);
+        }
+
+        VkDeviceSize blockSize = preferredBlockSize(allocation.memoryTypeIndex);
+
+        //big resources get their own memory, they would just fragment the shared blocks
+        if (size > blockSize / 2) {
+            auto block = allocateBlock(allocation.memoryTypeIndex, size);
+            block->freeRanges.clear();
+            block->usedBytes = size;
+            block->allocationCount = 1;
+
+            allocation.memory = block->memory;
+            allocation.offset = 0;
+            allocation.size = size;
+            allocation.mapped = block->mapped;
+            allocation.dedicated = true;
+
+            //reuse a released slot so indices held by other allocations stay valid
+            auto slot = std::find(dedicatedBlocks.begin(), dedicatedBlocks.end(), nullptr);
+            if (slot == dedicatedBlocks.end()) {
+                slot = dedicatedBlocks.insert(dedicatedBlocks.end(), nullptr);
+            }
+            *slot = std::move(block);
+            allocation.blockIndex = static_cast<uint32_t>(slot - dedicatedBlocks.begin());
+            return allocation;
+        }
+
+        allocation.poolIndex = allocation.memoryTypeIndex * 2 + (linear ? 0 : 1);
+        Pool& pool = pools[allocation.poolIndex];
+
+        VkDeviceSize offset = 0;
+        uint32_t blockIndex = 0;
+        bool found = false;
+        for (; blockIndex < pool.blocks.size(); blockIndex++) {
+            if (pool.blocks[blockIndex] && allocateFromBlock(*pool.blocks[blockIndex], size, alignment, offset)) {
+                found = true;
+                break;
+            }
+        }
+
+        //no room anywhere, grab a new block
+        if (!found) {
+            auto slot = std::find(pool.blocks.begin(), pool.blocks.end(), nullptr);
+            if (slot == pool.blocks.end()) {
+                slot = pool.blocks.insert(pool.blocks.end(), nullptr);
+            }
+            *slot = allocateBlock(allocation.memoryTypeIndex, blockSize);
+            blockIndex = static_cast<uint32_t>(slot - pool.blocks.begin());
+            if (!allocateFromBlock(**slot, size, alignment, offset)) {
+                throw std::runtime_error("failed to sub allocate from a new memory block!");
+            }
+        }
+
+        Block& block = *pool.blocks[blockIndex];
+        allocation.memory = block.memory;
+        allocation.offset = offset;
+        allocation.size = size;
+        allocation.mapped = block.mapped ? static_cast<char*>(block.mapped) + offset : nullptr;
+        allocation.blockIndex = blockIndex;
+        return allocation;
+    }
+
+    void NKAllocator::free(NKAllocation& allocation) {
+        if (!allocation.isValid()) return;
+        std::lock_guard<std::mutex> lock{ allocatorMutex };
+
+        if (allocation.dedicated) {
+            auto& block = dedicatedBlocks[allocation.blockIndex];
+            freeBlock(*block);
+            block.reset();
+        }
+        else {
+            Pool& pool = pools[allocation.poolIndex];
+            auto& block = pool.blocks[allocation.blockIndex];
+            freeToBlock(*block, allocation.offset, allocation.size);
+
+            //release empty blocks but keep one around so a load/unload loop doesn't thrash the driver
+            if (block->allocationCount == 0) {
+                size_t liveBlocks = std::count_if(pool.blocks.begin(), pool.blocks.end(),
+                    [](const std::unique_ptr<Block>& b) { return b != nullptr; });
+                if (liveBlocks > 1) {
+                    freeBlock(*block);
+                    block.reset();
+                }
+            }
+        }
+
+        allocation = NKAllocation{};
+    }
+
+    VkMappedMemoryRange NKAllocator::mappedRange(const NKAllocation& allocation, VkDeviceSize size, VkDeviceSize offset) const {
+        if (size == VK_WHOLE_SIZE) {
+            size = allocation.size - offset;
+        }
+
+        //non coherent allocations are atom aligned at both ends so this never leaves the allocation
+        VkDeviceSize begin = alignDown(allocation.offset + offset, nonCoherentAtomSize);
+        VkDeviceSize end = std::min(
+            alignUp(allocation.offset + offset + size, nonCoherentAtomSize),
+            allocation.offset + allocation.size);
+
+        VkMappedMemoryRange range = {};
+        range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+        range.memory = allocation.memory;
+        range.offset = begin;
+        range.size = end - begin;
+        return range;
+    }
+
+    VkResult NKAllocator::flush(const NKAllocation& allocation, VkDeviceSize size, VkDeviceSize offset) {
+        //coherent memory doesn't need it
+        if (memoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+            return VK_SUCCESS;
+        }
+        VkMappedMemoryRange range = mappedRange(allocation, size, offset);
+        return vkFlushMappedMemoryRanges(device, 1, &range);
+    }
+
+    VkResult NKAllocator::invalidate(const NKAllocation& allocation, VkDeviceSize size, VkDeviceSize offset) {
+        if (memoryProperties.memoryTypes[allocation.memoryTypeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) {
+            return VK_SUCCESS;
+        }
+        VkMappedMemoryRange range = mappedRange(allocation, size, offset);
+        return vkInvalidateMappedMemoryRanges(device, 1, &range);
+    }
+
+    NKAllocatorStats NKAllocator::getStats() {
+        std::lock_guard<std::mutex> lock{ allocatorMutex };
+
+        NKAllocatorStats stats{};
+        stats.heaps.resize(memoryProperties.memoryHeapCount);
+        for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; i++) {
+            stats.heaps[i].heapSize = memoryProperties.memoryHeaps[i].size;
+        }
+
+        auto addBlock = [&](const Block& block) {
+            NKAllocatorHeapStats& heap = stats.heaps[memoryProperties.memoryTypes[block.memoryTypeIndex].heapIndex];
+            heap.blockBytes += block.size;
+            heap.usedBytes += block.usedBytes;
+
+            stats.blockCount++;
+            stats.allocationCount += block.allocationCount;
+            stats.blockBytes += block.size;
+            stats.usedBytes += block.usedBytes;
+            for (const auto& range : block.freeRanges) {
+                stats.freeBytes += range.second;
+                stats.largestFreeRange = std::max(stats.largestFreeRange, range.second);
+            }
+        };
+
+        for (const auto& pool : pools) {
+            for (const auto& block : pool.blocks) {
+                if (block) addBlock(*block);
+            }
+        }
+        for (const auto& block : dedicatedBlocks) {
+            if (!block) continue;
+            addBlock(*block);
+            stats.dedicatedBlockCount++;
+        }
+
+        if (stats.freeBytes > 0) {
+            stats.fragmentation = 1.f - static_cast<float>(stats.largestFreeRange) / static_cast<float>(stats.freeBytes);
+        }
+        return stats;
+    }
+
+}  // namespace lve
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace nekographics {
+
+    //a range of device memory handed out by NKAllocator, bind resources at memory + offset
+    struct NKAllocation {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void* mapped = nullptr;//persistent mapping of this range, null if the memory is not host visible
+        uint32_t memoryTypeIndex = 0;
+        uint32_t poolIndex = 0;
+        uint32_t blockIndex = 0;
+        bool dedicated = false;
+
+        bool isValid() const { return memory != VK_NULL_HANDLE; }
+    };
+
+    struct NKAllocatorHeapStats {
+        VkDeviceSize heapSize = 0;
+        VkDeviceSize blockBytes = 0;//bytes reserved from the driver with vkAllocateMemory
+        VkDeviceSize usedBytes = 0;//bytes handed out to resources
+    };
+
+    struct NKAllocatorStats {
+        uint32_t blockCount = 0;//number of live vkAllocateMemory calls
+        uint32_t dedicatedBlockCount = 0;
+        uint32_t allocationCount = 0;//number of live sub allocations
+        VkDeviceSize blockBytes = 0;
+        VkDeviceSize usedBytes = 0;
+        VkDeviceSize freeBytes = 0;
+        VkDeviceSize largestFreeRange = 0;
+        float fragmentation = 0.f;//0 = all free space is one range, close to 1 = free space is scattered
+        std::vector<NKAllocatorHeapStats> heaps;
+    };
+
+    /*
+    Block based sub allocator, each memory type gets large blocks which are carved up with a
+    best fit free list. Linear resources (buffers, linear images) and optimal images live in
+    separate pools so bufferImageGranularity never has to be padded for, host visible blocks
+    are mapped once for their whole lifetime.
+    */
+    class NKAllocator {
+    public:
+        static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+        NKAllocator(VkDevice device, VkPhysicalDevice physicalDevice);
+        ~NKAllocator();
+
+        NKAllocator(const NKAllocator&) = delete;
+        NKAllocator& operator=(const NKAllocator&) = delete;
+
+        /**
+         * Finds space for a resource, allocating a new block from the driver if needed
+         *
+         * @param requirements Memory requirements queried from the buffer or image
+         * @param properties Required memory property flags
+         * @param linear true for buffers & linear tiled images, false for optimal tiled images
+         *
+         * @return NKAllocation describing the memory range
+         */
+        NKAllocation allocate(
+            const VkMemoryRequirements& requirements, VkMemoryPropertyFlags properties, bool linear);
+
+        /**
+         * Returns the range to its block, empty blocks are released except the last one of a pool
+         */
+        void free(NKAllocation& allocation);
+
+        /**
+         * Flush/invalidate a range relative to the allocation, rounded out to nonCoherentAtomSize
+         *
+         * @param size (Optional) Size of the memory range. Pass VK_WHOLE_SIZE for the whole allocation
+         * @param offset (Optional) Byte offset from beginning of the allocation
+         */
+        VkResult flush(const NKAllocation& allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+        VkResult invalidate(const NKAllocation& allocation, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+
+        NKAllocatorStats getStats();
+
+    private:
+        struct Block {
+            VkDeviceMemory memory = VK_NULL_HANDLE;
+            VkDeviceSize size = 0;
+            VkDeviceSize usedBytes = 0;
+            void* mapped = nullptr;
+            uint32_t memoryTypeIndex = 0;
+            uint32_t allocationCount = 0;
+            std::map<VkDeviceSize, VkDeviceSize> freeRanges;//offset -> size, kept coalesced
+        };
+
+        //one pool per memory type and resource kind
+        struct Pool {
+            uint32_t memoryTypeIndex = 0;
+            std::vector<std::unique_ptr<Block>> blocks;
+        };
+
+        uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+        VkDeviceSize preferredBlockSize(uint32_t memoryTypeIndex) const;
+        std::unique_ptr<Block> allocateBlock(uint32_t memoryTypeIndex, VkDeviceSize size);
+        void freeBlock(Block& block);
+        bool allocateFromBlock(Block& block, VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset);
+        void freeToBlock(Block& block, VkDeviceSize offset, VkDeviceSize size);
+        VkMappedMemoryRange mappedRange(const NKAllocation& allocation, VkDeviceSize size, VkDeviceSize offset) const;
+
+        VkDevice device;
+        VkPhysicalDeviceMemoryProperties memoryProperties;
+        VkDeviceSize nonCoherentAtomSize;
+
+        std::vector<Pool> pools;//[memoryType * 2 + (linear ? 0 : 1)]
+        std::vector<std::unique_ptr<Block>> dedicatedBlocks;//oversized allocations, one vkAllocateMemory each
+        std::mutex allocatorMutex;
+    };
+
+}  // namespace lve
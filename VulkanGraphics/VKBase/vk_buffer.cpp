@@ -38,46 +38,56 @@ namespace nekographics {
         memoryPropertyFlags{ memoryPropertyFlags } {
         alignmentSize = getAlignment(instanceSize, minOffsetAlignment);
         bufferSize = alignmentSize * instanceCount;
-        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, memory);
+        device.createBuffer(bufferSize, usageFlags, memoryPropertyFlags, buffer, allocation);
     }
 
     NKBuffer::~NKBuffer() {
         unmap();
-        vkDestroyBuffer(m_bufferDevice.device(), buffer, nullptr);
-        vkFreeMemory(m_bufferDevice.device(), memory, nullptr);
+        m_bufferDevice.destroyBuffer(buffer, allocation);
     }
 
     /**
      * Map a memory range of this buffer. If successful, mapped points to the specified buffer range.
+     * The memory block is already persistently mapped by the allocator so this only offsets into it.
      *
-     * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map the complete
-     * buffer range.
+     * @param size (Optional) Size of the memory range to map. Pass VK_WHOLE_SIZE to map from offset to
+     * the end of the buffer.
      * @param offset (Optional) Byte offset from beginning
      *
-     * @return VkResult of the buffer mapping call
+     * @return VkResult of the buffer mapping call, VK_ERROR_MEMORY_MAP_FAILED if the memory isn't host
+     * visible or the range is outside the buffer
      */
     VkResult NKBuffer::map(VkDeviceSize size, VkDeviceSize offset) {
-        assert(buffer && memory && "Called map on buffer before create");
-        return vkMapMemory(m_bufferDevice.device(), memory, offset, size, 0, &mapped);
+        assert(buffer && allocation.isValid() && "Called map on buffer before create");
+        if (!allocation.mapped) {
+            return VK_ERROR_MEMORY_MAP_FAILED;//not host visible 
+        }
+
+        //the allocation can be larger than the buffer, only the buffer's own range may be mapped 
+        if (offset > bufferSize || (size != VK_WHOLE_SIZE && size > bufferSize - offset)) {
+            assert(false && "Mapped range is outside the buffer");
+            return VK_ERROR_MEMORY_MAP_FAILED;
+        }
+        mapped = static_cast<char*>(allocation.mapped) + offset;
+        mappedSize = (size == VK_WHOLE_SIZE) ? bufferSize - offset : size;
+        return VK_SUCCESS;
     }
 
     /**
      * Unmap a mapped memory range
      *
-     * @note Does not return a result as vkUnmapMemory can't fail
+     * @note The block stays mapped by the allocator, this only drops the pointer
      */
     void NKBuffer::unmap() {
-        if (mapped) {
-            vkUnmapMemory(m_bufferDevice.device(), memory);
-            mapped = nullptr;
-        }
+        mapped = nullptr;
+        mappedSize = 0;
     }
 
     /**
-     * Copies the specified data to the mapped buffer. Default value writes whole buffer range
+     * Copies the specified data to the mapped buffer. Default value writes whole mapped range
      *
      * @param data Pointer to the data to copy
-     * @param size (Optional) Size of the data to copy. Pass VK_WHOLE_SIZE to flush the complete buffer
+     * @param size (Optional) Size of the data to copy. Pass VK_WHOLE_SIZE to write the complete mapped
      * range.
      * @param offset (Optional) Byte offset from beginning of mapped region
      *
@@ -86,9 +96,10 @@ namespace nekographics {
         assert(mapped && "Cannot copy to unmapped buffer");
 
         if (size == VK_WHOLE_SIZE) {
-            memcpy(mapped, data, bufferSize);
+            memcpy(mapped, data, mappedSize);
         }
         else {
+            assert(offset <= mappedSize && size <= mappedSize - offset && "Write is outside the mapped range");
             char* memOffset = (char*)mapped;
             memOffset += offset;
             memcpy(memOffset, data, size);
@@ -107,12 +118,7 @@ namespace nekographics {
      * @return VkResult of the flush call
      */
     VkResult NKBuffer::flush(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkFlushMappedMemoryRanges(m_bufferDevice.device(), 1, &mappedRange);
+        return m_bufferDevice.getAllocator().flush(allocation, size, offset);
     }
 
     /**
@@ -127,12 +133,7 @@ namespace nekographics {
      * @return VkResult of the invalidate call
      */
     VkResult NKBuffer::invalidate(VkDeviceSize size, VkDeviceSize offset) {
-        VkMappedMemoryRange mappedRange = {};
-        mappedRange.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
-        mappedRange.memory = memory;
-        mappedRange.offset = offset;
-        mappedRange.size = size;
-        return vkInvalidateMappedMemoryRanges(m_bufferDevice.device(), 1, &mappedRange);
+        return m_bufferDevice.getAllocator().invalidate(allocation, size, offset);
     }
 
     /**
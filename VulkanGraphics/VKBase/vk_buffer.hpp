@@ -45,8 +45,9 @@ namespace nekographics {
 
         NKDevice& m_bufferDevice;
         void* mapped = nullptr;
+        VkDeviceSize mappedSize = 0;//bytes of the buffer from mapped on
         VkBuffer buffer = VK_NULL_HANDLE;
-        VkDeviceMemory memory = VK_NULL_HANDLE;
+        NKAllocation allocation;//sub allocated from the device allocator, host visible memory stays mapped
 
         VkDeviceSize bufferSize;
         uint32_t instanceCount;
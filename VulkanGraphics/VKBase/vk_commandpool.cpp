@@ -0,0 +1,120 @@
+#include "vk_commandpool.hpp"
+#include "vk_swapchain.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+
+namespace nekographics {
+
+    NKFrameCommandPools::NKFrameCommandPools(NKDevice& device, uint32_t threadCount)
+        : device{ device }, threadCount{ threadCount } {
+        assert(threadCount > 0 && "Need at least one recording thread");
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = device.findPhysicalQueueFamilies().graphicsFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;//no per buffer reset, the whole pool is reset
+
+        pools.resize(static_cast<size_t>(NKSwapChain::MAX_FRAMES_IN_FLIGHT) * threadCount);
+        for (auto& pool : pools) {
+            if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &pool.commandPool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create frame command pool!");
+            }
+        }
+    }
+
+    NKFrameCommandPools::~NKFrameCommandPools() {
+        //destroying a pool frees its command buffers
+        for (auto& pool : pools) {
+            vkDestroyCommandPool(device.device(), pool.commandPool, nullptr);
+        }
+    }
+
+    void NKFrameCommandPools::beginFrame(int frameIndex) {
+        currentFrame = frameIndex;
+        for (uint32_t thread = 0; thread < threadCount; ++thread) {
+            Pool& pool = getPool(thread);
+            vkResetCommandPool(device.device(), pool.commandPool, 0);
+            pool.usedSecondaries = 0;
+        }
+    }
+
+    VkCommandBuffer NKFrameCommandPools::getPrimary() {
+        Pool& pool = getPool(0);
+        if (pool.primary == VK_NULL_HANDLE) {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = pool.commandPool;
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(device.device(), &allocInfo, &pool.primary) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate command buffers!");
+            }
+        }
+        return pool.primary;
+    }
+
+    void NKFrameCommandPools::setRenderPass(VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent) {
+        this->renderPass = renderPass;
+        this->framebuffer = framebuffer;
+        this->extent = extent;
+    }
+
+    VkCommandBuffer NKFrameCommandPools::beginSecondary(uint32_t thread) {
+        assert(thread < threadCount && "Recording thread index out of range");
+        assert(renderPass != VK_NULL_HANDLE && "Secondary command buffers need the render pass they continue");
+
+        Pool& pool = getPool(thread);
+        if (pool.usedSecondaries == pool.secondaries.size()) {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+            allocInfo.commandPool = pool.commandPool;
+            allocInfo.commandBufferCount = 1;
+
+            VkCommandBuffer commandBuffer;
+            if (vkAllocateCommandBuffers(device.device(), &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate secondary command buffer!");
+            }
+            pool.secondaries.push_back(commandBuffer);
+        }
+        VkCommandBuffer commandBuffer = pool.secondaries[pool.usedSecondaries++];
+
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        inheritanceInfo.renderPass = renderPass;
+        inheritanceInfo.subpass = 0;
+        inheritanceInfo.framebuffer = framebuffer;
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+        if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin recording secondary command buffer!");
+        }
+
+        //dynamic state isn't inherited from the primary
+        VkViewport viewport{};
+        viewport.x = 0.0f;
+        viewport.y = 0.0f;
+        viewport.width = static_cast<float>(extent.width);
+        viewport.height = static_cast<float>(extent.height);
+        viewport.minDepth = 0.0f;
+        viewport.maxDepth = 1.0f;
+        VkRect2D scissor{ {0, 0}, extent };
+        vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+        vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+        return commandBuffer;
+    }
+
+    void NKFrameCommandPools::endSecondary(VkCommandBuffer commandBuffer) {
+        if (vkEndCommandBuffer(commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to record secondary command buffer!");
+        }
+    }
+
+}  // namespace lve
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "vk_device.hpp"
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace nekographics {
+
+    /*
+    Command pools of the frames in flight, one per recording thread so threads never share a pool.
+    Nothing is freed one buffer at a time, the pools of a frame are reset together once its fence has
+    signalled & the command buffers they hold are handed out again. The frame's primary command buffer
+    comes from the pool of thread 0.
+    */
+    class NKFrameCommandPools {
+    public:
+        NKFrameCommandPools(NKDevice& device, uint32_t threadCount);
+        ~NKFrameCommandPools();
+
+        NKFrameCommandPools(const NKFrameCommandPools&) = delete;
+        NKFrameCommandPools& operator=(const NKFrameCommandPools&) = delete;
+
+        uint32_t getThreadCount() const { return threadCount; }
+
+        //resets every pool of the frame, its fence has to have signalled
+        void beginFrame(int frameIndex);
+
+        //the primary command buffer of the current frame, not begun. Allocated once & reused after every reset
+        VkCommandBuffer getPrimary();
+
+        //what the secondary command buffers continue, set when the render pass begins
+        void setRenderPass(VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent);
+
+        /**
+         * A secondary command buffer of the current frame, begun inside the render pass with the viewport & scissor set
+         *
+         * @param thread Index of the recording thread, one thread per index at a time
+         * @return Ended with endSecondary & executed from the primary command buffer, in whatever order the caller needs
+         */
+        VkCommandBuffer beginSecondary(uint32_t thread);
+        static void endSecondary(VkCommandBuffer commandBuffer);
+
+    private:
+        struct Pool {
+            VkCommandPool commandPool = VK_NULL_HANDLE;
+            VkCommandBuffer primary = VK_NULL_HANDLE;//thread 0 only
+            std::vector<VkCommandBuffer> secondaries;//kept across resets
+            uint32_t usedSecondaries = 0;
+        };
+
+        Pool& getPool(uint32_t thread) { return pools[static_cast<size_t>(currentFrame) * threadCount + thread]; }
+
+        NKDevice& device;
+        uint32_t threadCount;
+        int currentFrame = 0;
+        std::vector<Pool> pools;//frame major
+
+        VkRenderPass renderPass = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkExtent2D extent{};
+    };
+
+}  // namespace lve
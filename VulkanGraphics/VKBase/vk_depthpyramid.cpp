@@ -0,0 +1,319 @@
+#include "vk_depthpyramid.hpp"
+#include "vk_swapchain.hpp"
+#include "vk_pipelineregistry.hpp"
+#include "vk_samplercache.hpp"
+
+// std
+#include <algorithm>
+#include <stdexcept>
+
+namespace nekographics {
+
+    struct DepthPyramidPushConstants {
+        uint32_t srcSize[2];
+        uint32_t dstSize[2];
+    };
+
+    NKDepthPyramid::NKDepthPyramid(NKDevice& device, VkExtent2D depthExtent, VkFormat depthFormat)
+        : device{ device }, depthFormat{ depthFormat } {
+        createSampler();
+        createDescriptors();
+        createPipelineLayout();
+        createImage(depthExtent);
+    }
+
+    NKDepthPyramid::~NKDepthPyramid() {
+        destroyImage();
+        pipeline = nullptr;
+        device.getPipelineRegistry().releaseLayout(pipelineLayout);
+        vkDestroyPipelineLayout(device.device(), pipelineLayout, nullptr);
+    }
+
+    void NKDepthPyramid::resize(VkExtent2D newDepthExtent) {
+        if (newDepthExtent.width == depthExtent.width && newDepthExtent.height == depthExtent.height) {
+            return;
+        }
+        destroyImage();
+        createImage(newDepthExtent);
+        valid = false;
+        ++generation;
+    }
+
+    void NKDepthPyramid::createSampler() {
+        //texelFetch only, the sampler just has to exist for the combined image samplers
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_NEAREST;
+        samplerInfo.minFilter = VK_FILTER_NEAREST;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+        samplerInfo.anisotropyEnable = VK_FALSE;
+        samplerInfo.maxAnisotropy = 1.0f;
+        samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+        samplerInfo.unnormalizedCoordinates = VK_FALSE;
+        samplerInfo.compareEnable = VK_FALSE;
+        samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+        samplerInfo.minLod = 0.0f;
+        samplerInfo.maxLod = static_cast<float>(MAX_MIP_LEVELS);
+
+        //the placeholder & the real pyramid end up with the same one
+        sampler = device.getSamplerCache().getSampler(samplerInfo);
+    }
+
+    void NKDepthPyramid::createDescriptors() {
+        setLayout = NKDescriptorSetLayout::Builder(device)
+            .addBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_COMPUTE_BIT)//source level
+            .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, VK_SHADER_STAGE_COMPUTE_BIT)//destination level
+            .setImmutableSampler(0, sampler)
+            .build();
+
+        //reset & refilled whenever the image is recreated
+        const uint32_t maxSets = NKSwapChain::MAX_FRAMES_IN_FLIGHT + MAX_MIP_LEVELS;
+        descriptorPool = NKDescriptorPool::Builder(device)
+            .setMaxSets(maxSets)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, maxSets)
+            .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, maxSets)
+            .build();
+    }
+
+    void NKDepthPyramid::createPipelineLayout() {
+        VkPushConstantRange pushConstantRange{};
+        pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+        pushConstantRange.offset = 0;
+        pushConstantRange.size = sizeof(DepthPyramidPushConstants);
+
+        VkDescriptorSetLayout descriptorSetLayout = setLayout->getDescriptorSetLayout();
+
+        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+        pipelineLayoutInfo.setLayoutCount = 1;
+        pipelineLayoutInfo.pSetLayouts = &descriptorSetLayout;
+        pipelineLayoutInfo.pushConstantRangeCount = 1;
+        pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        if (vkCreatePipelineLayout(device.device(), &pipelineLayoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create depth pyramid pipeline layout!");
+        }
+    }
+
+    uint32_t NKDepthPyramid::previousPowerOfTwo(uint32_t value) {
+        uint32_t result = 1;
+        while (result * 2 <= value) {
+            result *= 2;
+        }
+        return result;
+    }
+
+    VkExtent2D NKDepthPyramid::getLevelExtent(uint32_t level) const {
+        return { std::max(extent.width >> level, 1u), std::max(extent.height >> level, 1u) };
+    }
+
+    void NKDepthPyramid::createImage(VkExtent2D newDepthExtent) {
+        depthExtent = newDepthExtent;
+
+        //rounding down keeps every level an exact 2x2 reduction, the first pass takes care of the odd footprint
+        extent = { previousPowerOfTwo(std::max(depthExtent.width, 1u)), previousPowerOfTwo(std::max(depthExtent.height, 1u)) };
+        mipCount = 1;
+        while (mipCount < MAX_MIP_LEVELS && (extent.width >> mipCount) + (extent.height >> mipCount) > 0) {
+            ++mipCount;
+        }
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = extent.width;
+        imageInfo.extent.height = extent.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = mipCount;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = VK_FORMAT_R32_SFLOAT;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image, imageAllocation);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = VK_FORMAT_R32_SFLOAT;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = mipCount;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+        if (vkCreateImageView(device.device(), &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create depth pyramid image view!");
+        }
+
+        levelViews.resize(mipCount);
+        for (uint32_t level = 0; level < mipCount; ++level) {
+            viewInfo.subresourceRange.baseMipLevel = level;
+            viewInfo.subresourceRange.levelCount = 1;
+            if (vkCreateImageView(device.device(), &viewInfo, nullptr, &levelViews[level]) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create depth pyramid image view!");
+            }
+        }
+
+        //the image lives in GENERAL, written as storage & read through the sampler
+        VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipCount, 0, 1 };
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &barrier);
+        device.endSingleTimeCommands(commandBuffer);
+
+        //level 0 reads the depth attachment of whichever frame builds it, those sets are written in build()
+        depthSets.resize(NKSwapChain::MAX_FRAMES_IN_FLIGHT);
+        for (auto& set : depthSets) {
+            if (!descriptorPool->allocateDescriptor(setLayout->getDescriptorSetLayout(), set)) {
+                throw std::runtime_error("failed to allocate depth pyramid descriptor set!");
+            }
+        }
+
+        levelSets.resize(mipCount - 1);
+        for (uint32_t level = 1; level < mipCount; ++level) {
+            VkDescriptorImageInfo srcInfo{ sampler, levelViews[level - 1], VK_IMAGE_LAYOUT_GENERAL };
+            VkDescriptorImageInfo dstInfo{ VK_NULL_HANDLE, levelViews[level], VK_IMAGE_LAYOUT_GENERAL };
+            if (!NkDescriptorWriter(*setLayout, *descriptorPool)
+                .writeImage(0, &srcInfo)
+                .writeImage(1, &dstInfo)
+                .build(levelSets[level - 1])) {
+                throw std::runtime_error("failed to allocate depth pyramid descriptor set!");
+            }
+        }
+    }
+
+    void NKDepthPyramid::destroyImage() {
+        descriptorPool->resetPool();
+        depthSets.clear();
+        levelSets.clear();
+
+        for (auto view : levelViews) {
+            vkDestroyImageView(device.device(), view, nullptr);
+        }
+        levelViews.clear();
+        vkDestroyImageView(device.device(), imageView, nullptr);
+        imageView = VK_NULL_HANDLE;
+        device.destroyImage(image, imageAllocation);
+    }
+
+    void NKDepthPyramid::build(VkCommandBuffer commandBuffer, int frameIndex, VkImage depthImage, VkImageView depthView) {
+        if (!pipeline) {
+            pipeline = device.getPipelineRegistry().getComputePipeline("Shaders/depthPyramid.comp.spv", pipelineLayout);
+        }
+
+        //the other candidates of NKSwapChain::findDepthFormat carry stencil
+        VkImageAspectFlags depthAspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+        if (depthFormat != VK_FORMAT_D32_SFLOAT) {
+            depthAspect |= VK_IMAGE_ASPECT_STENCIL_BIT;
+        }
+
+        //the depth attachment becomes readable, the pyramid waits for last frame's culling to stop reading it
+        VkImageMemoryBarrier barriers[2]{};
+        barriers[0].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        barriers[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barriers[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        barriers[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barriers[0].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[0].image = depthImage;
+        barriers[0].subresourceRange = { depthAspect, 0, 1, 0, 1 };
+
+        barriers[1].sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barriers[1].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        barriers[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        barriers[1].oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barriers[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        barriers[1].srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barriers[1].image = image;
+        barriers[1].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, mipCount, 0, 1 };
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            2, barriers);
+
+        //the frame's fence has been waited on, nothing in flight uses this set
+        VkDescriptorImageInfo srcInfo{ sampler, depthView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+        VkDescriptorImageInfo dstInfo{ VK_NULL_HANDLE, levelViews[0], VK_IMAGE_LAYOUT_GENERAL };
+        NkDescriptorWriter(*setLayout, *descriptorPool)
+            .writeImage(0, &srcInfo)
+            .writeImage(1, &dstInfo)
+            .overwrite(depthSets[frameIndex]);
+
+        pipeline->bind(commandBuffer);
+
+        for (uint32_t level = 0; level < mipCount; ++level) {
+            VkExtent2D srcExtent = level == 0 ? depthExtent : getLevelExtent(level - 1);
+            VkExtent2D dstExtent = getLevelExtent(level);
+            VkDescriptorSet set = level == 0 ? depthSets[frameIndex] : levelSets[level - 1];
+
+            DepthPyramidPushConstants push{ { srcExtent.width, srcExtent.height }, { dstExtent.width, dstExtent.height } };
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout, 0, 1, &set, 0, nullptr);
+            vkCmdPushConstants(commandBuffer, pipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(DepthPyramidPushConstants), &push);
+            vkCmdDispatch(commandBuffer, (dstExtent.width + GROUP_SIZE - 1) / GROUP_SIZE, (dstExtent.height + GROUP_SIZE - 1) / GROUP_SIZE, 1);
+
+            //the next level & the culling of the next frame read it
+            VkImageMemoryBarrier levelBarrier{};
+            levelBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+            levelBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+            levelBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+            levelBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
+            levelBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+            levelBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            levelBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+            levelBarrier.image = image;
+            levelBarrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, level, 1, 0, 1 };
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                0,
+                0, nullptr,
+                0, nullptr,
+                1, &levelBarrier);
+        }
+
+        //back to the layout the render pass expects, its load op clears it next time around
+        VkImageMemoryBarrier depthBarrier = barriers[0];
+        depthBarrier.srcAccessMask = 0;
+        depthBarrier.dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+        depthBarrier.oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        depthBarrier.newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+            VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &depthBarrier);
+
+        valid = true;
+    }
+
+}  // namespace lve
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "vk_device.hpp"
+#include "vk_descriptors.hpp"
+#include "vk_pipeline.hpp"
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace nekographics {
+
+    /*
+    Hierarchical depth buffer, every texel of a level holds the furthest depth of the texels it
+    covers in the level below. Level 0 is the depth attachment reduced to the previous power of
+    two, so a bounding rectangle of any size can be tested against at most 2x2 texels of the
+    matching level.
+
+    build() is recorded after the render pass that wrote the depth attachment, culling in the next
+    frame then tests against the depth the previous frame left behind. The image stays in
+    VK_IMAGE_LAYOUT_GENERAL.
+    */
+    class NKDepthPyramid {
+    public:
+        static constexpr uint32_t GROUP_SIZE = 8;//local_size of depthPyramid.comp
+        static constexpr uint32_t MAX_MIP_LEVELS = 16;
+
+        NKDepthPyramid(NKDevice& device, VkExtent2D depthExtent, VkFormat depthFormat);
+        ~NKDepthPyramid();
+
+        NKDepthPyramid(const NKDepthPyramid&) = delete;
+        NKDepthPyramid& operator=(const NKDepthPyramid&) = delete;
+
+        //recreates the pyramid for a new depth attachment size, the device must be idle
+        void resize(VkExtent2D depthExtent);
+
+        /**
+         * Records the reduction of a depth attachment that was just rendered
+         * The attachment is read as a sampled image and handed back in DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+         *
+         * @param frameIndex Frame in flight recording the command buffer, picks the descriptor set of the attachment
+         */
+        void build(VkCommandBuffer commandBuffer, int frameIndex, VkImage depthImage, VkImageView depthView);
+
+        //false until the first build after creation or a resize, nothing meaningful to test against before that
+        bool isValid() const { return valid; }
+        void invalidate() { valid = false; }
+
+        //changes whenever the image is recreated, descriptor sets holding getImageView() have to be rewritten
+        uint32_t getGeneration() const { return generation; }
+
+        VkImageView getImageView() const { return imageView; }
+        VkSampler getSampler() const { return sampler; }
+        VkExtent2D getExtent() const { return extent; }
+        uint32_t getMipCount() const { return mipCount; }
+
+    private:
+        void createSampler();
+        void createDescriptors();
+        void createPipelineLayout();
+        void createImage(VkExtent2D depthExtent);
+        void destroyImage();
+
+        VkExtent2D getLevelExtent(uint32_t level) const;
+        static uint32_t previousPowerOfTwo(uint32_t value);
+
+        NKDevice& device;
+        VkFormat depthFormat;
+        VkExtent2D depthExtent{};
+        VkExtent2D extent{};//level 0
+        uint32_t mipCount = 0;
+
+        VkImage image = VK_NULL_HANDLE;
+        NKAllocation imageAllocation;
+        VkImageView imageView = VK_NULL_HANDLE;//every level, read by the culling
+        std::vector<VkImageView> levelViews;//one level each, written by the reduction
+        VkSampler sampler = VK_NULL_HANDLE;
+
+        std::unique_ptr<NKDescriptorSetLayout> setLayout;
+        std::unique_ptr<NKDescriptorPool> descriptorPool;
+        std::vector<VkDescriptorSet> depthSets;//per frame in flight, depth attachment -> level 0
+        std::vector<VkDescriptorSet> levelSets;//level i -> level i + 1
+
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        NKComputePipeline* pipeline = nullptr;//from the device's pipeline registry on the first build
+
+        bool valid = false;
+        uint32_t generation = 0;
+    };
+
+}  // namespace lve
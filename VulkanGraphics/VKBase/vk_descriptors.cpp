@@ -23,24 +23,63 @@ namespace nekographics {
         return *this;
     }
 
+    NKDescriptorSetLayout::Builder& NKDescriptorSetLayout::Builder::setBindingFlags(
+        uint32_t binding, VkDescriptorBindingFlagsEXT flags) {
+        assert(bindings.count(binding) == 1 && "Flags set on a binding that wasn't added");
+        assert(m_DeviceBuilder.supportsDescriptorIndexing() && "Binding flags need descriptor indexing");
+        bindingFlags[binding] = flags;
+        return *this;
+    }
+
+    NKDescriptorSetLayout::Builder& NKDescriptorSetLayout::Builder::setImmutableSampler(
+        uint32_t binding, VkSampler sampler) {
+        assert(bindings.count(binding) == 1 && "Sampler set on a binding that wasn't added");
+        assert((bindings.at(binding).descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER
+            || bindings.at(binding).descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER) && "Immutable sampler on a binding without samplers");
+        immutableSamplers[binding] = sampler;
+        return *this;
+    }
+
     std::unique_ptr<NKDescriptorSetLayout> NKDescriptorSetLayout::Builder::build() const {
-        return std::make_unique<NKDescriptorSetLayout>(m_DeviceBuilder, bindings);
+        return std::make_unique<NKDescriptorSetLayout>(m_DeviceBuilder, bindings, bindingFlags, immutableSamplers);
     }
 
     // *************** Descriptor Set Layout *********************
 
     NKDescriptorSetLayout::NKDescriptorSetLayout(
-        NKDevice& lveDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings)
+        NKDevice& lveDevice,
+        std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+        const std::unordered_map<uint32_t, VkDescriptorBindingFlagsEXT>& bindingFlags,
+        const std::unordered_map<uint32_t, VkSampler>& immutableSamplers)
         : m_DeviceLayout{ lveDevice }, bindings{ bindings } {
-        //create a vector of just the set layout bindings 
+        //create a vector of just the set layout bindings & their flags in the same order 
         std::vector<VkDescriptorSetLayoutBinding> setLayoutBindings{};
+        std::vector<VkDescriptorBindingFlagsEXT> setLayoutBindingFlags{};
+        std::vector<std::vector<VkSampler>> bindingSamplers{};//one per element, only read by vkCreateDescriptorSetLayout
+        bindingSamplers.reserve(immutableSamplers.size());
+        bool updateAfterBind = false;
         for (auto kv : bindings) {
+            auto sampler = immutableSamplers.find(kv.first);
+            if (sampler != immutableSamplers.end()) {
+                bindingSamplers.emplace_back(kv.second.descriptorCount, sampler->second);
+                kv.second.pImmutableSamplers = bindingSamplers.back().data();
+            }
             setLayoutBindings.push_back(kv.second);
+            auto flags = bindingFlags.find(kv.first);
+            setLayoutBindingFlags.push_back(flags != bindingFlags.end() ? flags->second : 0);
+            updateAfterBind = updateAfterBind || (setLayoutBindingFlags.back() & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT);
         }
 
+        VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{};
+        bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+        bindingFlagsInfo.bindingCount = static_cast<uint32_t>(setLayoutBindingFlags.size());
+        bindingFlagsInfo.pBindingFlags = setLayoutBindingFlags.data();
+
         //create layout 
         VkDescriptorSetLayoutCreateInfo descriptorSetLayoutInfo{};
         descriptorSetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        descriptorSetLayoutInfo.pNext = bindingFlags.empty() ? nullptr : &bindingFlagsInfo;
+        descriptorSetLayoutInfo.flags = updateAfterBind ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT : 0;
         descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(setLayoutBindings.size());
         descriptorSetLayoutInfo.pBindings = setLayoutBindings.data();
 
@@ -29,15 +29,24 @@ namespace nekographics {
                 VkDescriptorType descriptorType,
                 VkShaderStageFlags stageFlags,
                 uint32_t count = 1);
+            //VK_EXT_descriptor_indexing flags of an added binding, update after bind ones need a pool made with the matching flag
+            Builder& setBindingFlags(uint32_t binding, VkDescriptorBindingFlagsEXT flags);
+            //bakes the sampler into every element of a sampler or combined image sampler binding, writes skip it
+            Builder& setImmutableSampler(uint32_t binding, VkSampler sampler);
             std::unique_ptr<NKDescriptorSetLayout> build() const;
 
         private:
             NKDevice& m_DeviceBuilder;
             std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings{};
+            std::unordered_map<uint32_t, VkDescriptorBindingFlagsEXT> bindingFlags{};
+            std::unordered_map<uint32_t, VkSampler> immutableSamplers{};
         };
 
         NKDescriptorSetLayout(
-            NKDevice& lveDevice, std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings);
+            NKDevice& lveDevice,
+            std::unordered_map<uint32_t, VkDescriptorSetLayoutBinding> bindings,
+            const std::unordered_map<uint32_t, VkDescriptorBindingFlagsEXT>& bindingFlags = {},
+            const std::unordered_map<uint32_t, VkSampler>& immutableSamplers = {});
         ~NKDescriptorSetLayout();
         NKDescriptorSetLayout(const NKDescriptorSetLayout&) = delete;
         NKDescriptorSetLayout& operator=(const NKDescriptorSetLayout&) = delete;
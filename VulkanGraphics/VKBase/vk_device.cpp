@@ -1,9 +1,16 @@
 
 //includes
 #include "vk_device.hpp"
+#include "vk_pipelineregistry.hpp"
+#include "vk_samplercache.hpp"
+#ifdef _WIN32
+#include "WindowManager.h"
+#endif
 
 // std headers
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <set>
 #include <unordered_set>
@@ -20,9 +27,9 @@ namespace nekographics {
 
         std::cerr << "validation layer: " << pCallbackData->pMessage << std::endl;
 
-        UNREFERENCED_PARAMETER(messageSeverity);
-        UNREFERENCED_PARAMETER(messageType);
-        UNREFERENCED_PARAMETER(pUserData);
+        (void)messageSeverity;
+        (void)messageType;
+        (void)pUserData;
 
         return VK_FALSE;
     }
@@ -56,25 +63,45 @@ namespace nekographics {
     }
 
     // class member functions
-    NKDevice::NKDevice(VkWindow& windowCreate) : window{ windowCreate } {
+    NKDevice::NKDevice(VkWindow* windowCreate) : window{ windowCreate }, headless_{ windowCreate == nullptr } {
+        //offscreen rendering does not need to present, so the swapchain extension is not required
+        if (headless_) {
+            deviceExtensions.clear();
+        }
+
         //creating instance & debug instance
         createInstance();
         setupDebugMessenger();
         createSurface();//creating window surface 
         pickPhysicalDevice();//trying to find physical device 
         createLogicalDevice();//creating logical device 
+        createAllocator();//memory sub allocator 
         createCommandPool();//command pool
+        createUploadManager();//staging ring 
+        createGeometryPool();//vertex & index mega buffers 
+        createPipelineCache();//compiled pipelines of the last run 
+        createPipelineRegistry();//shared pipelines 
+        createSamplerCache();//shared samplers 
     }
 
     NKDevice::~NKDevice() {
+        uploadManager_.reset();//waits for any upload still in flight 
+        geometryPool_.reset();//every model is gone by now 
+        pipelineRegistry_.reset();//every system is gone by now 
+        samplerCache_.reset();//every texture & layout is gone by now 
+        savePipelineCache();
+        vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
         vkDestroyCommandPool(device_, commandPool, nullptr);
+        allocator_.reset();//frees every memory block, all resources must be gone by now 
         vkDestroyDevice(device_, nullptr);
 
         if (enableValidationLayers) {
             DestroyDebugUtilsMessengerEXT(instance, debugMessenger, nullptr);
         }
 
-        vkDestroySurfaceKHR(instance, surface_, nullptr);
+        if (surface_ != VK_NULL_HANDLE) {
+            vkDestroySurfaceKHR(instance, surface_, nullptr);
+        }
         vkDestroyInstance(instance, nullptr);
     }
 
@@ -156,7 +183,7 @@ namespace nekographics {
         QueueFamilyIndices indices = findQueueFamilies(physicalDevice);
 
         std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-        std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily };
+        std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily, indices.presentFamily, indices.transferFamily };
 
         float queuePriority = 1.0f;
         for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -168,18 +195,42 @@ namespace nekographics {
             queueCreateInfos.push_back(queueCreateInfo);
         }
 
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        //indirect draws with many commands & a non zero firstInstance, the gpu driven path needs them 
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        deviceFeatures.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+        enabledFeatures_ = deviceFeatures;
+
+        //the draw count can come from a buffer when the extension is there, otherwise empty commands are drawn 
+        std::vector<const char*> enabledExtensions = deviceExtensions;
+        bool drawIndirectCount = hasDeviceExtension(physicalDevice, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        if (drawIndirectCount) {
+            enabledExtensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+        }
+
+        //the material textures are one big array, only the parts of the extension it uses are turned on 
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures{};
+        descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        descriptorIndexing_ = queryDescriptorIndexing(descriptorIndexingFeatures);
+        if (descriptorIndexing_) {
+            enabledExtensions.push_back(VK_KHR_MAINTENANCE3_EXTENSION_NAME);
+            enabledExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
+        }
 
         VkDeviceCreateInfo createInfo = {};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+        createInfo.pNext = descriptorIndexing_ ? &descriptorIndexingFeatures : nullptr;
 
         createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+        createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
         // might not really be necessary anymore because device specific validation layers
         // have been deprecated
@@ -195,8 +246,168 @@ namespace nekographics {
             throw std::runtime_error("failed to create logical device!");
         }
 
+        if (drawIndirectCount) {
+            cmdDrawIndexedIndirectCount_ = reinterpret_cast<PFN_vkCmdDrawIndexedIndirectCountKHR>(
+                vkGetDeviceProcAddr(device_, "vkCmdDrawIndexedIndirectCountKHR"));
+        }
+
         vkGetDeviceQueue(device_, indices.graphicsFamily, 0, &graphicsQueue_);
         vkGetDeviceQueue(device_, indices.presentFamily, 0, &presentQueue_);
+        vkGetDeviceQueue(device_, indices.transferFamily, 0, &transferQueue_);
+
+        dedicatedTransfer_ = indices.transferFamily != indices.graphicsFamily;
+        if (dedicatedTransfer_) {
+            std::cout << "dedicated transfer queue family: " << indices.transferFamily << std::endl;
+        }
+    }
+
+    bool NKDevice::queryDescriptorIndexing(VkPhysicalDeviceDescriptorIndexingFeaturesEXT& enabledFeatures) {
+        //the instance went without VK_KHR_get_physical_device_properties2, so no bindless textures either 
+        if (!hasProperties2_) {
+            return false;
+        }
+
+        auto getFeatures2 = reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+            vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceFeatures2KHR"));
+        auto getProperties2 = reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2KHR>(
+            vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceProperties2KHR"));
+        if (getFeatures2 == nullptr || getProperties2 == nullptr
+            || !hasDeviceExtension(physicalDevice, VK_KHR_MAINTENANCE3_EXTENSION_NAME)
+            || !hasDeviceExtension(physicalDevice, VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+            return false;
+        }
+
+        VkPhysicalDeviceDescriptorIndexingFeaturesEXT supported{};
+        supported.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+        VkPhysicalDeviceFeatures2KHR features2{};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR;
+        features2.pNext = &supported;
+        getFeatures2(physicalDevice, &features2);
+
+        //the instances of one draw may use different materials, so the index isn't uniform 
+        if (!supported.shaderSampledImageArrayNonUniformIndexing
+            || !supported.runtimeDescriptorArray
+            || !supported.descriptorBindingPartiallyBound
+            || !supported.descriptorBindingSampledImageUpdateAfterBind
+            || !supported.descriptorBindingUpdateUnusedWhilePending) {
+            return false;
+        }
+        enabledFeatures.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        enabledFeatures.runtimeDescriptorArray = VK_TRUE;
+        enabledFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+        enabledFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+        enabledFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+
+        VkPhysicalDeviceDescriptorIndexingPropertiesEXT indexingProperties{};
+        indexingProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+        VkPhysicalDeviceProperties2KHR properties2{};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2_KHR;
+        properties2.pNext = &indexingProperties;
+        getProperties2(physicalDevice, &properties2);
+        maxBindlessTextures_ = std::min(
+            indexingProperties.maxPerStageDescriptorUpdateAfterBindSampledImages,
+            indexingProperties.maxDescriptorSetUpdateAfterBindSampledImages);
+        return true;
+    }
+
+    void NKDevice::createAllocator() { allocator_ = std::make_unique<NKAllocator>(device_, physicalDevice); }
+
+    void NKDevice::createUploadManager() { uploadManager_ = std::make_unique<NKUploadManager>(*this); }
+
+    void NKDevice::createGeometryPool() { geometryPool_ = std::make_unique<NKGeometryPool>(*this); }
+
+    void NKDevice::createPipelineRegistry() { pipelineRegistry_ = std::make_unique<NKPipelineRegistry>(*this); }
+
+    void NKDevice::createSamplerCache() { samplerCache_ = std::make_unique<NKSamplerCache>(*this); }
+
+    //the driver rejects or misreads data from another gpu or driver version, so only hand it what it wrote itself
+    static bool isPipelineCacheCompatible(const std::vector<char>& data, const VkPhysicalDeviceProperties& properties) {
+        constexpr size_t headerSize = 4 * sizeof(uint32_t) + VK_UUID_SIZE;
+        if (data.size() < headerSize) {
+            return false;
+        }
+
+        //VkPipelineCacheHeaderVersionOne, little endian as written by the driver
+        uint32_t header[4];
+        std::memcpy(header, data.data(), sizeof(header));
+        const uint8_t* uuid = reinterpret_cast<const uint8_t*>(data.data()) + sizeof(header);
+
+        return header[0] >= headerSize
+            && header[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+            && header[2] == properties.vendorID
+            && header[3] == properties.deviceID
+            && std::memcmp(uuid, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+    void NKDevice::createPipelineCache() {
+        std::vector<char> data;
+        std::ifstream file{ PIPELINE_CACHE_FILE, std::ios::ate | std::ios::binary };
+        if (file.is_open()) {
+            data.resize(static_cast<size_t>(file.tellg()));
+            file.seekg(0);
+            file.read(data.data(), data.size());
+            if (!file || !isPipelineCacheCompatible(data, properties)) {
+                std::cout << "pipeline cache: " << PIPELINE_CACHE_FILE << " is stale or from another gpu, starting empty" << std::endl;
+                data.clear();
+            }
+        }
+
+        VkPipelineCacheCreateInfo cacheInfo{};
+        cacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        cacheInfo.initialDataSize = data.size();
+        cacheInfo.pInitialData = data.empty() ? nullptr : data.data();
+
+        if (vkCreatePipelineCache(device_, &cacheInfo, nullptr, &pipelineCache_) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create pipeline cache!");
+        }
+
+        pipelineCacheStats_.loadedFromDisk = !data.empty();
+        pipelineCacheStats_.loadedBytes = data.size();
+    }
+
+    void NKDevice::savePipelineCache() {
+        size_t size = 0;
+        if (vkGetPipelineCacheData(device_, pipelineCache_, &size, nullptr) != VK_SUCCESS || size == 0) {
+            return;
+        }
+        std::vector<char> data(size);
+        if (vkGetPipelineCacheData(device_, pipelineCache_, &size, data.data()) != VK_SUCCESS) {
+            return;
+        }
+
+        //written next to the old file & swapped in, a crash mid write leaves the last good cache
+        const std::string tempPath = std::string{ PIPELINE_CACHE_FILE } + ".tmp";
+        {
+            std::ofstream file{ tempPath, std::ios::binary | std::ios::trunc };
+            if (!file.is_open() || !file.write(data.data(), size)) {
+                std::cerr << "pipeline cache: failed to write " << tempPath << std::endl;
+                return;
+            }
+        }
+
+        std::error_code error;
+        std::filesystem::rename(tempPath, PIPELINE_CACHE_FILE, error);
+        if (error) {
+            std::cerr << "pipeline cache: failed to replace " << PIPELINE_CACHE_FILE << ", " << error.message() << std::endl;
+        }
+    }
+
+    void NKDevice::recordPipelineCreation(float milliseconds) {
+        std::lock_guard<std::mutex> lock{ pipelineCacheStatsMutex_ };
+        pipelineCacheStats_.pipelinesCreated++;
+        pipelineCacheStats_.creationMs += milliseconds;
+    }
+
+    NKPipelineCacheStats NKDevice::getPipelineCacheStats() {
+        std::lock_guard<std::mutex> lock{ pipelineCacheStatsMutex_ };
+        return pipelineCacheStats_;
+    }
+
+    void NKDevice::printPipelineCacheStats() {
+        NKPipelineCacheStats stats = getPipelineCacheStats();
+        std::cout << "pipelines: " << stats.pipelinesCreated << " created in " << stats.creationMs << " ms, "
+            << (stats.loadedFromDisk ? "warm cache (" + std::to_string(stats.loadedBytes) + " bytes loaded)" : std::string{ "cold cache" })
+            << std::endl;
     }
 
     void NKDevice::createCommandPool() {
@@ -205,23 +416,30 @@ namespace nekographics {
         VkCommandPoolCreateInfo poolInfo = {};
         poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
         poolInfo.queueFamilyIndex = queueFamilyIndices.graphicsFamily;
-        poolInfo.flags =
-            VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;//one shot commands only, reset as a whole once none are open 
 
         if (vkCreateCommandPool(device_, &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
             throw std::runtime_error("failed to create command pool!");
         }
     }
 
-    void NKDevice::createSurface() { window.CreateWindowSurface(instance, &surface_); }
+    void NKDevice::createSurface() {
+        //nothing to present to when rendering offscreen
+        if (headless_) return;
+#ifdef _WIN32
+        window->CreateWindowSurface(instance, &surface_);
+#else
+        throw std::runtime_error("failed to create window surface, only win32 windows are supported!");
+#endif
+    }
 
     bool NKDevice::isDeviceSuitable(VkPhysicalDevice device) {
         QueueFamilyIndices indices = findQueueFamilies(device);
 
         bool extensionsSupported = checkDeviceExtensionSupport(device);
 
-        bool swapChainAdequate = false;
-        if (extensionsSupported) {
+        bool swapChainAdequate = headless_;
+        if (extensionsSupported && !headless_) {
             SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device);
             swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
         }
@@ -285,17 +503,41 @@ namespace nekographics {
         
         std::vector<const char*> extensions;
 
-        extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
-        extensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+        if (!headless_) {
+            extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+#ifdef _WIN32
+            extensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+#endif
+        }
 
         if (enableValidationLayers) {
             extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
             extensions.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
         }
 
+        //feature & property queries with pNext chains on a 1.0 instance, optional: only descriptor indexing needs them 
+        hasProperties2_ = hasInstanceExtension(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        if (hasProperties2_) {
+            extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        }
+
         return extensions;
     }
 
+    bool NKDevice::hasInstanceExtension(const char* extensionName) {
+        uint32_t extensionCount = 0;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+        std::vector<VkExtensionProperties> extensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, extensions.data());
+
+        for (const auto& extension : extensions) {
+            if (std::strcmp(extension.extensionName, extensionName) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     void NKDevice::hasGflwRequiredInstanceExtensions() {
         uint32_t extensionCount = 0;
         vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
@@ -339,6 +581,25 @@ namespace nekographics {
         return requiredExtensions.empty();
     }
 
+    bool NKDevice::hasDeviceExtension(VkPhysicalDevice device, const char* extensionName) {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(
+            device,
+            nullptr,
+            &extensionCount,
+            availableExtensions.data());
+
+        for (const auto& extension : availableExtensions) {
+            if (strcmp(extension.extensionName, extensionName) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
     QueueFamilyIndices NKDevice::findQueueFamilies(VkPhysicalDevice device) {
         QueueFamilyIndices indices;
 
@@ -355,7 +616,13 @@ namespace nekographics {
                 indices.graphicsFamilyHasValue = true;
             }
             VkBool32 presentSupport = false;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            if (headless_) {
+                //offscreen frames never get presented, graphics queue doubles as the present queue
+                presentSupport = indices.graphicsFamilyHasValue && indices.graphicsFamily == static_cast<uint32_t>(i);
+            }
+            else {
+                vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            }
             if (queueFamily.queueCount > 0 && presentSupport) {
                 indices.presentFamily = i;
                 indices.presentFamilyHasValue = true;
@@ -367,6 +634,27 @@ namespace nekographics {
             i++;
         }
 
+        //look for a family that only does transfers (dma engine), copies there run alongside rendering
+        for (uint32_t family = 0; family < queueFamilyCount; ++family) {
+            const auto& queueFamily = queueFamilies[family];
+            if (queueFamily.queueCount == 0 || !(queueFamily.queueFlags & VK_QUEUE_TRANSFER_BIT) ||
+                (queueFamily.queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+                continue;
+            }
+
+            //prefer transfer only over async compute families
+            if (!indices.transferFamilyHasValue || !(queueFamily.queueFlags & VK_QUEUE_COMPUTE_BIT)) {
+                indices.transferFamily = family;
+                indices.transferFamilyHasValue = true;
+            }
+        }
+
+        //no dedicated family, uploads go through the graphics queue
+        if (!indices.transferFamilyHasValue && indices.graphicsFamilyHasValue) {
+            indices.transferFamily = indices.graphicsFamily;
+            indices.transferFamilyHasValue = true;
+        }
+
         return indices;
     }
 
@@ -431,7 +719,7 @@ namespace nekographics {
         VkBufferUsageFlags usage,
         VkMemoryPropertyFlags pProperties,
         VkBuffer& buffer,
-        VkDeviceMemory& bufferMemory) {
+        NKAllocation& bufferAllocation) {
 
         VkBufferCreateInfo bufferInfo{};
         bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -446,27 +734,38 @@ namespace nekographics {
         VkMemoryRequirements memRequirements;
         vkGetBufferMemoryRequirements(device_, buffer, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, pProperties);
+        bufferAllocation = allocator_->allocate(memRequirements, pProperties, true);
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate vertex buffer memory!");
+        if (vkBindBufferMemory(device_, buffer, bufferAllocation.memory, bufferAllocation.offset) != VK_SUCCESS) {
+            throw std::runtime_error("failed to bind vertex buffer memory!");
         }
+    }
 
-        vkBindBufferMemory(device_, buffer, bufferMemory, 0);
+    void NKDevice::destroyBuffer(VkBuffer& buffer, NKAllocation& bufferAllocation) {
+        vkDestroyBuffer(device_, buffer, nullptr);
+        allocator_->free(bufferAllocation);
+        buffer = VK_NULL_HANDLE;
     }
 
     VkCommandBuffer NKDevice::beginSingleTimeCommands() {
-        VkCommandBufferAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-        allocInfo.commandPool = commandPool;
-        allocInfo.commandBufferCount = 1;
-
+        //recycled buffers first, they were reset with the pool 
         VkCommandBuffer commandBuffer;
-        vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer);
+        if (!freeSingleTimeBuffers_.empty()) {
+            commandBuffer = freeSingleTimeBuffers_.back();
+            freeSingleTimeBuffers_.pop_back();
+        }
+        else {
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = commandPool;
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(device_, &allocInfo, &commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate single time command buffer!");
+            }
+        }
+        openSingleTimeBuffers_++;
 
         VkCommandBufferBeginInfo beginInfo{};
         beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
@@ -487,7 +786,13 @@ namespace nekographics {
         vkQueueSubmit(graphicsQueue_, 1, &submitInfo, VK_NULL_HANDLE);
         vkQueueWaitIdle(graphicsQueue_);
 
-        vkFreeCommandBuffers(device_, commandPool, 1, &commandBuffer);
+        //the pool can only be reset when no buffer of it is still being recorded 
+        usedSingleTimeBuffers_.push_back(commandBuffer);
+        if (--openSingleTimeBuffers_ == 0) {
+            vkResetCommandPool(device_, commandPool, 0);
+            freeSingleTimeBuffers_.insert(freeSingleTimeBuffers_.end(), usedSingleTimeBuffers_.begin(), usedSingleTimeBuffers_.end());
+            usedSingleTimeBuffers_.clear();
+        }
     }
 
     void NKDevice::copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size) {
@@ -505,7 +810,7 @@ namespace nekographics {
     void NKDevice::copyBufferToImage(
         VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, uint32_t layerCount,uint32_t mipCount, std::vector<uint32_t> offsets) {
 
-        UNREFERENCED_PARAMETER(layerCount);
+        (void)layerCount;
 
         VkCommandBuffer commandBuffer = beginSingleTimeCommands();
 
@@ -561,7 +866,7 @@ namespace nekographics {
         const VkImageCreateInfo& imageInfo,
         VkMemoryPropertyFlags pProperties,
         VkImage& image,
-        VkDeviceMemory& imageMemory) {
+        NKAllocation& imageAllocation) {
         if (vkCreateImage(device_, &imageInfo, nullptr, &image) != VK_SUCCESS) {
             throw std::runtime_error("failed to create image!");
         }
@@ -569,17 +874,36 @@ namespace nekographics {
         VkMemoryRequirements memRequirements;
         vkGetImageMemoryRequirements(device_, image, &memRequirements);
 
-        VkMemoryAllocateInfo allocInfo{};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, pProperties);
+        //optimal images go in their own blocks, away from buffers (bufferImageGranularity)
+        imageAllocation = allocator_->allocate(memRequirements, pProperties, imageInfo.tiling == VK_IMAGE_TILING_LINEAR);
 
-        if (vkAllocateMemory(device_, &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate image memory!");
-        }
-
-        if (vkBindImageMemory(device_, image, imageMemory, 0) != VK_SUCCESS) {
+        if (vkBindImageMemory(device_, image, imageAllocation.memory, imageAllocation.offset) != VK_SUCCESS) {
             throw std::runtime_error("failed to bind image memory!");
         }
     }
+
+    void NKDevice::destroyImage(VkImage& image, NKAllocation& imageAllocation) {
+        vkDestroyImage(device_, image, nullptr);
+        allocator_->free(imageAllocation);
+        image = VK_NULL_HANDLE;
+    }
+
+    void NKDevice::printAllocatorStats() {
+        NKAllocatorStats stats = allocator_->getStats();
+        std::cout << "memory blocks: " << stats.blockCount << " (" << stats.dedicatedBlockCount << " dedicated)"
+            << ", allocations: " << stats.allocationCount
+            << ", used: " << stats.usedBytes << " / " << stats.blockBytes << " bytes"
+            << ", fragmentation: " << stats.fragmentation << std::endl;
+        for (size_t i = 0; i < stats.heaps.size(); i++) {
+            std::cout << "\theap " << i << ": " << stats.heaps[i].usedBytes << " used, "
+                << stats.heaps[i].blockBytes << " reserved of " << stats.heaps[i].heapSize << std::endl;
+        }
+
+        NKGeometryPoolStats geometry = geometryPool_->getStats();
+        std::cout << "geometry pool: " << geometry.chunkCount << " chunks, " << geometry.rangeCount << " meshes"
+            << " (" << geometry.pendingFrees << " pending frees)"
+            << ", used: " << geometry.usedBytes << " / " << geometry.reservedBytes << " bytes"
+            << ", fragmentation: " << geometry.fragmentation
+            << ", compactions: " << geometry.compactions << std::endl;
+    }
 }
\ No newline at end of file
@@ -1,14 +1,23 @@
 #pragma once
 #define  NOMINMAX
-#include "WindowManager.h"
+#include "vk_allocator.hpp"
+#include "vk_upload.hpp"
+#include "vk_geometrypool.hpp"
 #include <vulkan/vulkan.h>
 
 // std lib headers
+#include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
+struct VkWindow;//WindowManager.h, win32 only
+
 namespace nekographics {
 
+    class NKPipelineRegistry;
+    class NKSamplerCache;
+
     struct SwapChainSupportDetails {
         VkSurfaceCapabilitiesKHR capabilities;
         std::vector<VkSurfaceFormatKHR> formats;
@@ -18,16 +27,29 @@ namespace nekographics {
     struct QueueFamilyIndices {
         uint32_t graphicsFamily;
         uint32_t presentFamily;
+        uint32_t transferFamily;//transfer only family when the gpu has one, otherwise the graphics family
         bool graphicsFamilyHasValue = false;
         bool presentFamilyHasValue = false;
+        bool transferFamilyHasValue = false;
         bool isComplete() { return graphicsFamilyHasValue && presentFamilyHasValue; }
     };
 
+    //how long the pipelines took to create, compare a run without the cache file against one with it
+    struct NKPipelineCacheStats {
+        bool loadedFromDisk = false;//false on the first run, after a driver update or on another gpu
+        size_t loadedBytes = 0;
+        uint32_t pipelinesCreated = 0;
+        float creationMs = 0.f;//summed over every graphics & compute pipeline
+    };
+
     class NKDevice {
     public:
+        static constexpr const char* PIPELINE_CACHE_FILE = "pipeline_cache.bin";//next to the executable's working directory
+
         const bool enableValidationLayers = true;
 
-        NKDevice(VkWindow& window);
+        //a null window is headless, no surface & no swapchain extension so frames can be rendered offscreen
+        NKDevice(VkWindow* window);
         ~NKDevice();
 
         // Not copyable or movable
@@ -36,12 +58,26 @@ namespace nekographics {
         NKDevice(NKDevice&&) = delete;
         NKDevice& operator=(NKDevice&&) = delete;
 
-        VkCommandPool getCommandPool() { return commandPool; }
+        VkCommandPool getCommandPool() { return commandPool; }//one shot commands, frames record from NKFrameCommandPools
         VkDevice device() { return device_; }
         VkPhysicalDevice getPhysicalDevice() { return physicalDevice; }
         VkSurfaceKHR surface() { return surface_; }
         VkQueue graphicsQueue() { return graphicsQueue_; }
         VkQueue presentQueue() { return presentQueue_; }
+        VkQueue transferQueue() { return transferQueue_; }
+        bool hasDedicatedTransferQueue() const { return dedicatedTransfer_; }
+        bool isHeadless() const { return headless_; }
+
+        //optional features for gpu driven rendering, enabled whenever the gpu has them
+        bool supportsMultiDrawIndirect() const { return enabledFeatures_.multiDrawIndirect == VK_TRUE; }
+        bool supportsDrawIndirectFirstInstance() const { return enabledFeatures_.drawIndirectFirstInstance == VK_TRUE; }
+        bool supportsDrawIndirectCount() const { return cmdDrawIndexedIndirectCount_ != nullptr; }
+        //VK_KHR_draw_indirect_count, null when the extension is missing
+        PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount() const { return cmdDrawIndexedIndirectCount_; }
+
+        //VK_EXT_descriptor_indexing, partially bound texture arrays indexed per instance & written while in use
+        bool supportsDescriptorIndexing() const { return descriptorIndexing_; }
+        uint32_t getMaxBindlessTextures() const { return maxBindlessTextures_; }//per stage, 0 without descriptor indexing
 
         SwapChainSupportDetails getSwapChainSupport() { return querySwapChainSupport(physicalDevice); }
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
@@ -49,13 +85,15 @@ namespace nekographics {
         VkFormat findSupportedFormat(
             const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 
-        // Buffer Helper Functions
+        // Buffer Helper Functions, memory comes from the device allocator
         void createBuffer(
             VkDeviceSize size,
             VkBufferUsageFlags usage,
             VkMemoryPropertyFlags properties,
             VkBuffer& buffer,
-            VkDeviceMemory& bufferMemory);
+            NKAllocation& bufferAllocation);
+        void destroyBuffer(VkBuffer& buffer, NKAllocation& bufferAllocation);
+        //blocking one shot commands, the command buffers are recycled instead of allocated & freed per call
         VkCommandBuffer beginSingleTimeCommands();
         void endSingleTimeCommands(VkCommandBuffer commandBuffer);
         void copyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
@@ -66,7 +104,31 @@ namespace nekographics {
             const VkImageCreateInfo& imageInfo,
             VkMemoryPropertyFlags properties,
             VkImage& image,
-            VkDeviceMemory& imageMemory);
+            NKAllocation& imageAllocation);
+        void destroyImage(VkImage& image, NKAllocation& imageAllocation);
+
+        NKAllocator& getAllocator() { return *allocator_; }
+        NKAllocatorStats getAllocatorStats() { return allocator_->getStats(); }
+        void printAllocatorStats();//the geometry pool's too
+
+        //batched staging uploads, prefer this over copyBuffer/copyBufferToImage which stall the queue
+        NKUploadManager& getUploadManager() { return *uploadManager_; }
+
+        //shared vertex & index buffers every model is suballocated from
+        NKGeometryPool& getGeometryPool() { return *geometryPool_; }
+
+        //every pipeline is created through this cache, loaded at startup & written back when the device is destroyed
+        VkPipelineCache pipelineCache() { return pipelineCache_; }
+        void savePipelineCache();
+        void recordPipelineCreation(float milliseconds);//thread safe
+        NKPipelineCacheStats getPipelineCacheStats();
+        void printPipelineCacheStats();
+
+        //shared pipelines & shader modules, systems get their pipelines from here instead of creating their own
+        NKPipelineRegistry& getPipelineRegistry() { return *pipelineRegistry_; }
+
+        //shared samplers, textures & layouts get theirs from here instead of calling vkCreateSampler
+        NKSamplerCache& getSamplerCache() { return *samplerCache_; }
 
         VkPhysicalDeviceProperties properties;
 
@@ -76,7 +138,13 @@ namespace nekographics {
         void createSurface();
         void pickPhysicalDevice();
         void createLogicalDevice();
+        void createAllocator();
         void createCommandPool();
+        void createUploadManager();
+        void createGeometryPool();
+        void createPipelineCache();
+        void createPipelineRegistry();
+        void createSamplerCache();
 
         // helper functions
         bool isDeviceSuitable(VkPhysicalDevice device);
@@ -85,24 +153,48 @@ namespace nekographics {
         QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device);
         void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo);
         void hasGflwRequiredInstanceExtensions();
+        bool hasInstanceExtension(const char* extensionName);
         bool checkDeviceExtensionSupport(VkPhysicalDevice device);
+        bool hasDeviceExtension(VkPhysicalDevice device, const char* extensionName);
+        bool queryDescriptorIndexing(VkPhysicalDeviceDescriptorIndexingFeaturesEXT& enabledFeatures);
         SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device);
 
         VkInstance instance;
         VkDebugUtilsMessengerEXT debugMessenger;
         VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
-        VkWindow& window;
+        VkWindow* window;//null when headless
         VkCommandPool commandPool;
+        std::vector<VkCommandBuffer> freeSingleTimeBuffers_;//reset with the pool, ready to begin
+        std::vector<VkCommandBuffer> usedSingleTimeBuffers_;//submitted, back to free on the next pool reset
+        uint32_t openSingleTimeBuffers_ = 0;//begun & not ended yet
 
         VkDevice device_;
-        VkSurfaceKHR surface_;
+        VkSurfaceKHR surface_ = VK_NULL_HANDLE;
         VkQueue graphicsQueue_;
         VkQueue presentQueue_;
+        VkQueue transferQueue_;
+        bool dedicatedTransfer_ = false;//transfer queue is in a different family from graphics
+        VkPhysicalDeviceFeatures enabledFeatures_{};
+        PFN_vkCmdDrawIndexedIndirectCountKHR cmdDrawIndexedIndirectCount_ = nullptr;
+        bool hasProperties2_ = false;//VK_KHR_get_physical_device_properties2 is enabled on the instance
+        bool descriptorIndexing_ = false;
+        uint32_t maxBindlessTextures_ = 0;
+        std::unique_ptr<NKAllocator> allocator_;//sub allocates every buffer & image
+        std::unique_ptr<NKUploadManager> uploadManager_;//staging ring for resource uploads
+        std::unique_ptr<NKGeometryPool> geometryPool_;//vertex & index mega buffers
+        VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+        NKPipelineCacheStats pipelineCacheStats_{};
+        std::mutex pipelineCacheStatsMutex_;
+        std::unique_ptr<NKPipelineRegistry> pipelineRegistry_;//every pipeline, created through pipelineCache_
+        std::unique_ptr<NKSamplerCache> samplerCache_;//every sampler, keyed by its create info
 
 
         //toggle to enable render doc & validation layer 
         bool enableRenderDoc = true;
 
+        //no window surface, no present queue & no swapchain
+        bool headless_ = false;
+
         std::vector<const char*> validationLayers = { "VK_LAYER_KHRONOS_validation"};
         std::vector<const char*> deviceExtensions = { VK_KHR_SWAPCHAIN_EXTENSION_NAME};
     };
@@ -8,6 +8,9 @@
 
 namespace nekographics {
 
+	class NKFrameCommandPools;
+	class NKJobSystem;
+
 	#define MAX_LIGHTS 10
 
 	struct PointLight {
@@ -31,6 +34,8 @@ namespace nekographics {
 		VkCommandBuffer commandBuffer;//command buffer can be recorded once and reused for multiple frames 
 		NKCamera& camera;
 		VkDescriptorSet globalDescriptorSet;
-		NkGameObject::Map& gameObjects;
+		NKScene& scene;//the entities & their components 
+		NKFrameCommandPools* secondaryPools = nullptr;//set when the render pass only takes secondary command buffers 
+		NKJobSystem* jobSystem = nullptr;//systems split their work over it when set, inline otherwise 
 	};
 }  // namespace lve
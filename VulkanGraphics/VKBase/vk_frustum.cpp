@@ -0,0 +1,163 @@
+#include "vk_frustum.hpp"
+
+// std
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#define NK_FRUSTUM_AVX
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NK_FRUSTUM_SSE
+#endif
+
+namespace nekographics {
+
+    void NKSphereBatch::clear() {
+        x.clear();
+        y.clear();
+        z.clear();
+        radius.clear();
+    }
+
+    void NKSphereBatch::reserve(size_t count) {
+        x.reserve(count);
+        y.reserve(count);
+        z.reserve(count);
+        radius.reserve(count);
+    }
+
+    void NKSphereBatch::add(const glm::vec4& sphere) {
+        x.push_back(sphere.x);
+        y.push_back(sphere.y);
+        z.push_back(sphere.z);
+        radius.push_back(sphere.w);
+    }
+
+    NKFrustum::NKFrustum(const glm::mat4& viewProjection) {
+        //rows of the view projection added & subtracted, with zero to one depth the near plane is row 2 alone
+        const glm::mat4 rows = glm::transpose(viewProjection);
+        planes = {
+            rows[3] + rows[0],//left
+            rows[3] - rows[0],//right
+            rows[3] + rows[1],
+            rows[3] - rows[1],
+            rows[2],//near
+            rows[3] - rows[2] };//far
+
+        for (auto& plane : planes) {
+            plane /= glm::length(glm::vec3(plane));
+        }
+    }
+
+    NKFrustum NKFrustum::fromCamera(const NKCamera& camera) {
+        return NKFrustum(camera.getProjection() * camera.getView());
+    }
+
+    glm::vec4 NKFrustum::transformSphere(const glm::mat4& transform, const glm::vec4& sphere) {
+        glm::vec3 center = glm::vec3(transform * glm::vec4(glm::vec3(sphere), 1.f));
+        float scale = std::max({ glm::length(glm::vec3(transform[0])), glm::length(glm::vec3(transform[1])), glm::length(glm::vec3(transform[2])) });
+        return glm::vec4(center, sphere.w * scale);
+    }
+
+    bool NKFrustum::testSphere(const glm::vec4& sphere) const {
+        for (const auto& plane : planes) {
+            if (glm::dot(glm::vec3(plane), glm::vec3(sphere)) + plane.w < -sphere.w) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool NKFrustum::testBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const {
+        for (const auto& plane : planes) {
+            //the corner furthest along the plane normal
+            glm::vec3 corner{
+                plane.x >= 0.f ? boxMax.x : boxMin.x,
+                plane.y >= 0.f ? boxMax.y : boxMin.y,
+                plane.z >= 0.f ? boxMax.z : boxMin.z };
+            if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.f) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    uint32_t NKFrustum::cullSpheres(const NKSphereBatch& spheres, uint32_t* visibleIndices) const {
+        const uint32_t count = spheres.size();
+        const float* xs = spheres.x.data();
+        const float* ys = spheres.y.data();
+        const float* zs = spheres.z.data();
+        const float* rs = spheres.radius.data();
+
+        uint32_t visibleCount = 0;
+        uint32_t i = 0;
+
+#if defined(NK_FRUSTUM_AVX)
+        __m256 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for (int p = 0; p < 6; ++p) {
+            planeX[p] = _mm256_set1_ps(planes[p].x);
+            planeY[p] = _mm256_set1_ps(planes[p].y);
+            planeZ[p] = _mm256_set1_ps(planes[p].z);
+            planeW[p] = _mm256_set1_ps(planes[p].w);
+        }
+
+        for (; i + 8 <= count; i += 8) {
+            __m256 x = _mm256_loadu_ps(xs + i);
+            __m256 y = _mm256_loadu_ps(ys + i);
+            __m256 z = _mm256_loadu_ps(zs + i);
+            __m256 negRadius = _mm256_sub_ps(_mm256_setzero_ps(), _mm256_loadu_ps(rs + i));
+
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p) {
+                __m256 distance = _mm256_add_ps(
+                    _mm256_add_ps(_mm256_mul_ps(planeX[p], x), _mm256_mul_ps(planeY[p], y)),
+                    _mm256_add_ps(_mm256_mul_ps(planeZ[p], z), planeW[p]));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, negRadius, _CMP_GE_OQ));
+            }
+
+            for (uint32_t mask = static_cast<uint32_t>(_mm256_movemask_ps(inside)); mask != 0; mask &= mask - 1) {
+                visibleIndices[visibleCount++] = i + static_cast<uint32_t>(std::countr_zero(mask));
+            }
+        }
+#elif defined(NK_FRUSTUM_SSE)
+        __m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+        for (int p = 0; p < 6; ++p) {
+            planeX[p] = _mm_set1_ps(planes[p].x);
+            planeY[p] = _mm_set1_ps(planes[p].y);
+            planeZ[p] = _mm_set1_ps(planes[p].z);
+            planeW[p] = _mm_set1_ps(planes[p].w);
+        }
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 x = _mm_loadu_ps(xs + i);
+            __m128 y = _mm_loadu_ps(ys + i);
+            __m128 z = _mm_loadu_ps(zs + i);
+            __m128 negRadius = _mm_sub_ps(_mm_setzero_ps(), _mm_loadu_ps(rs + i));
+
+            __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+            for (int p = 0; p < 6; ++p) {
+                __m128 distance = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(planeX[p], x), _mm_mul_ps(planeY[p], y)),
+                    _mm_add_ps(_mm_mul_ps(planeZ[p], z), planeW[p]));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, negRadius));
+            }
+
+            for (uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(inside)); mask != 0; mask &= mask - 1) {
+                visibleIndices[visibleCount++] = i + static_cast<uint32_t>(std::countr_zero(mask));
+            }
+        }
+#endif
+
+        //whatever doesn't fill a full register
+        for (; i < count; ++i) {
+            if (testSphere(glm::vec4(xs[i], ys[i], zs[i], rs[i]))) {
+                visibleIndices[visibleCount++] = i;
+            }
+        }
+        return visibleCount;
+    }
+
+}  // namespace lve
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "camera.hpp"
+
+// std
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace nekographics {
+
+    //world space bounding spheres laid out one component per array, so the batched test loads 4 or 8 of each at a time
+    struct NKSphereBatch {
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> z;
+        std::vector<float> radius;
+
+        void clear();
+        void reserve(size_t count);
+        void add(const glm::vec4& sphere);//xyz center & w radius
+        uint32_t size() const { return static_cast<uint32_t>(x.size()); }
+    };
+
+    /*
+    The six planes of a view projection, normals pointing inside. The batched sphere test runs 8 spheres
+    per iteration with AVX, 4 with SSE2 and falls back to one at a time on other targets.
+    */
+    class NKFrustum {
+    public:
+        NKFrustum() = default;
+        explicit NKFrustum(const glm::mat4& viewProjection);//zero to one depth
+        static NKFrustum fromCamera(const NKCamera& camera);
+
+        const std::array<glm::vec4, 6>& getPlanes() const { return planes; }
+
+        bool testSphere(const glm::vec4& sphere) const;//false when completely outside
+        bool testBox(const glm::vec3& boxMin, const glm::vec3& boxMax) const;
+
+        /**
+         * Tests every sphere of the batch
+         *
+         * @param visibleIndices Receives the indices of the spheres that are not completely outside, in order. Needs room for spheres.size()
+         * @return The number of visible spheres
+         */
+        uint32_t cullSpheres(const NKSphereBatch& spheres, uint32_t* visibleIndices) const;
+
+        //bounding sphere of a model space sphere under a transform, scaled by the largest axis scale
+        static glm::vec4 transformSphere(const glm::mat4& transform, const glm::vec4& sphere);
+
+    private:
+        std::array<glm::vec4, 6> planes{};
+    };
+
+}  // namespace lve
@@ -0,0 +1,434 @@
+//includes
+#include "vk_geometrypool.hpp"
+#include "vk_device.hpp"
+#include "vk_swapchain.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace nekographics {
+
+    NKGeometryPool::NKGeometryPool(NKDevice& poolDevice, VkDeviceSize vertexChunk, VkDeviceSize indexChunk)
+        : device{ poolDevice }, vertexChunkSize{ vertexChunk } {
+        indexPool.elementSize = 4;
+        indexPool.chunkElements = static_cast<uint32_t>(indexChunk / indexPool.elementSize);
+        indexPool.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    }
+
+    NKGeometryPool::~NKGeometryPool() {
+        for (auto& pool : vertexPools) {
+            for (auto& chunk : pool.chunks) {
+                destroyChunk(*chunk);
+            }
+        }
+        for (auto& chunk : indexPool.chunks) {
+            destroyChunk(*chunk);
+        }
+    }
+
+    NKGeometryPool::Chunk& NKGeometryPool::createChunk(Pool& pool, uint32_t capacity) {
+        auto chunk = std::make_unique<Chunk>();
+        chunk->capacity = capacity;
+        chunk->freeRanges.emplace(0, capacity);
+
+        device.createBuffer(
+            static_cast<VkDeviceSize>(capacity) * pool.elementSize,
+            pool.usage,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            chunk->buffer,
+            chunk->allocation);
+
+        pool.chunks.push_back(std::move(chunk));
+        return *pool.chunks.back();
+    }
+
+    void NKGeometryPool::destroyChunk(Chunk& chunk) {
+        device.destroyBuffer(chunk.buffer, chunk.allocation);
+    }
+
+    uint32_t NKGeometryPool::allocateElements(Pool& pool, uint32_t count, uint32_t& outChunk) {
+        //best fit across every chunk
+        Chunk* bestChunk = nullptr;
+        uint32_t bestChunkIndex = 0;
+        auto best = std::map<uint32_t, uint32_t>::iterator{};
+
+        for (uint32_t c = 0; c < pool.chunks.size(); ++c) {
+            Chunk& chunk = *pool.chunks[c];
+            if (chunk.capacity - chunk.usedElements < count) continue;
+
+            for (auto it = chunk.freeRanges.begin(); it != chunk.freeRanges.end(); ++it) {
+                if (it->second < count) continue;
+                if (bestChunk == nullptr || it->second < best->second) {
+                    bestChunk = &chunk;
+                    bestChunkIndex = c;
+                    best = it;
+                }
+            }
+        }
+
+        //nothing fits, oversized meshes get a chunk of their own
+        if (bestChunk == nullptr) {
+            bestChunkIndex = static_cast<uint32_t>(pool.chunks.size());
+            bestChunk = &createChunk(pool, std::max(pool.chunkElements, count));
+            best = bestChunk->freeRanges.begin();
+        }
+
+        uint32_t offset = best->first;
+        uint32_t rangeCount = best->second;
+        bestChunk->freeRanges.erase(best);
+        if (rangeCount > count) {
+            bestChunk->freeRanges.emplace(offset + count, rangeCount - count);
+        }
+        bestChunk->usedElements += count;
+
+        outChunk = bestChunkIndex;
+        return offset;
+    }
+
+    void NKGeometryPool::freeElements(Pool& pool, uint32_t chunkIndex, uint32_t offset, uint32_t count) {
+        Chunk& chunk = *pool.chunks[chunkIndex];
+        auto inserted = chunk.freeRanges.emplace(offset, count).first;
+
+        //merge with the next range
+        auto next = std::next(inserted);
+        if (next != chunk.freeRanges.end() && inserted->first + inserted->second == next->first) {
+            inserted->second += next->second;
+            chunk.freeRanges.erase(next);
+        }
+
+        //merge with the previous range
+        if (inserted != chunk.freeRanges.begin()) {
+            auto prev = std::prev(inserted);
+            if (prev->first + prev->second == inserted->first) {
+                prev->second += inserted->second;
+                chunk.freeRanges.erase(inserted);
+            }
+        }
+
+        chunk.usedElements -= count;
+    }
+
+    uint32_t NKGeometryPool::indexWords(VkIndexType indexType, uint32_t indexCount) {
+        return indexType == VK_INDEX_TYPE_UINT16 ? (indexCount + 1) / 2 : indexCount;
+    }
+
+    NKGeometryHandle NKGeometryPool::allocate(uint32_t vertexStride, uint32_t vertexCount) {
+        assert(vertexCount > 0 && "allocating an empty mesh");
+
+        //every vertex stride gets its own pool so offsets stay whole vertices
+        uint32_t poolIndex = 0;
+        while (poolIndex < vertexPools.size() && vertexPools[poolIndex].elementSize != vertexStride) {
+            poolIndex++;
+        }
+        if (poolIndex == vertexPools.size()) {
+            Pool pool{};
+            pool.elementSize = vertexStride;
+            pool.chunkElements = static_cast<uint32_t>(vertexChunkSize / vertexStride);
+            pool.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+            vertexPools.push_back(std::move(pool));
+        }
+
+        NKGeometryHandle handle;
+        if (!freeHandles.empty()) {
+            handle = freeHandles.back();
+            freeHandles.pop_back();
+        }
+        else {
+            handle = static_cast<NKGeometryHandle>(slots.size());
+            slots.emplace_back();
+        }
+
+        Slot& slot = slots[handle];
+        slot = Slot{};
+        slot.live = true;
+        slot.range.vertexPool = poolIndex;
+        slot.range.vertexCount = vertexCount;
+        slot.range.vertexOffset = allocateElements(vertexPools[poolIndex], vertexCount, slot.range.vertexChunk);
+        return handle;
+    }
+
+    void NKGeometryPool::allocateIndices(NKGeometryHandle handle, VkIndexType indexType, uint32_t indexCount) {
+        Slot& slot = slots[handle];
+        assert(slot.live && !slot.hasIndices && "indices already allocated");
+        assert(indexCount > 0 && "allocating an empty index list");
+
+        uint32_t wordOffset = allocateElements(indexPool, indexWords(indexType, indexCount), slot.range.indexChunk);
+        slot.hasIndices = true;
+        slot.range.indexType = indexType;
+        slot.range.indexCount = indexCount;
+        slot.range.firstIndex = wordOffset * (4 / indexSize(indexType));//in units of the index type
+    }
+
+    void NKGeometryPool::uploadVertices(NKGeometryHandle handle, const void* data) {
+        const NKGeometryRange& range = slots[handle].range;
+        const Pool& pool = vertexPools[range.vertexPool];
+
+        device.getUploadManager().uploadBuffer(
+            pool.chunks[range.vertexChunk]->buffer,
+            data,
+            static_cast<VkDeviceSize>(range.vertexCount) * pool.elementSize,
+            static_cast<VkDeviceSize>(range.vertexOffset) * pool.elementSize);
+    }
+
+    void NKGeometryPool::uploadIndices(NKGeometryHandle handle, const void* data) {
+        const NKGeometryRange& range = slots[handle].range;
+        uint32_t size = indexSize(range.indexType);
+
+        device.getUploadManager().uploadBuffer(
+            indexPool.chunks[range.indexChunk]->buffer,
+            data,
+            static_cast<VkDeviceSize>(range.indexCount) * size,
+            static_cast<VkDeviceSize>(range.firstIndex) * size);
+    }
+
+    void NKGeometryPool::free(NKGeometryHandle handle) {
+        assert(slots[handle].live && "freeing a range twice");
+        pendingFrees.push_back({ handle, frameCounter + NKSwapChain::MAX_FRAMES_IN_FLIGHT + 1 });
+    }
+
+    void NKGeometryPool::release(NKGeometryHandle handle) {
+        Slot& slot = slots[handle];
+        const NKGeometryRange& range = slot.range;
+
+        Pool& vertexPool = vertexPools[range.vertexPool];
+        freeElements(vertexPool, range.vertexChunk, range.vertexOffset, range.vertexCount);
+        releasedBytes += static_cast<VkDeviceSize>(range.vertexCount) * vertexPool.elementSize;
+        if (slot.hasIndices) {
+            uint32_t words = indexWords(range.indexType, range.indexCount);
+            freeElements(indexPool, range.indexChunk, range.firstIndex / (4 / indexSize(range.indexType)), words);
+            releasedBytes += static_cast<VkDeviceSize>(words) * indexPool.elementSize;
+        }
+
+        slot = Slot{};
+        freeHandles.push_back(handle);
+    }
+
+    void NKGeometryPool::endFrame() {
+        frameCounter++;
+
+        auto ready = std::stable_partition(pendingFrees.begin(), pendingFrees.end(), [this](const PendingFree& pending) {
+            return pending.releaseFrame > frameCounter;
+        });
+        if (ready == pendingFrees.end()) {
+            return;
+        }
+        for (auto it = ready; it != pendingFrees.end(); ++it) {
+            release(it->handle);
+        }
+        pendingFrees.erase(ready, pendingFrees.end());
+
+        //only frames that unloaded something can have made the pools worse 
+        NKGeometryPoolStats stats = getStats();
+        if (static_cast<float>(releasedBytes) > compactThreshold * static_cast<float>(stats.reservedBytes)) {
+            compact();
+        }
+    }
+
+    void NKGeometryPool::bind(VkCommandBuffer commandBuffer, NKGeometryHandle handle, NKGeometryBindState* state) {
+        const Slot& slot = slots[handle];
+        const NKGeometryRange& range = slot.range;
+
+        VkBuffer vertexBuffer = vertexPools[range.vertexPool].chunks[range.vertexChunk]->buffer;
+        if (state == nullptr || state->vertexBuffer != vertexBuffer) {
+            VkDeviceSize offsets[] = { 0 };//the draw picks the range through vertexOffset
+            vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, offsets);
+            if (state) {
+                state->vertexBuffer = vertexBuffer;
+                state->bindCount++;
+            }
+        }
+        else {
+            state->skippedBindCount++;
+        }
+
+        if (slot.hasIndices) {
+            VkBuffer indexBuffer = indexPool.chunks[range.indexChunk]->buffer;
+            if (state == nullptr || state->indexBuffer != indexBuffer || state->indexType != range.indexType) {
+                vkCmdBindIndexBuffer(commandBuffer, indexBuffer, 0, range.indexType);
+                if (state) {
+                    state->indexBuffer = indexBuffer;
+                    state->indexType = range.indexType;
+                    state->bindCount++;
+                }
+            }
+            else {
+                state->skippedBindCount++;
+            }
+        }
+    }
+
+    void NKGeometryPool::compact() {
+        //copies still streaming in have to land before their ranges move
+        device.getUploadManager().waitIdle();
+        vkDeviceWaitIdle(device.device());
+
+        //nothing is in flight anymore, every pending free can go
+        for (const auto& pending : pendingFrees) {
+            release(pending.handle);
+        }
+        pendingFrees.clear();
+
+        for (uint32_t i = 0; i < vertexPools.size(); ++i) {
+            compactPool(vertexPools[i], true, i);
+        }
+        compactPool(indexPool, false, 0);
+        releasedBytes = 0;
+        compactions++;
+    }
+
+    void NKGeometryPool::compactPool(Pool& pool, bool vertices, uint32_t poolIndex) {
+        struct Live {
+            NKGeometryHandle handle;
+            uint32_t chunk;
+            uint32_t offset;
+            uint32_t count;
+            uint32_t newChunk = 0;
+            uint32_t newOffset = 0;
+        };
+
+        std::vector<Live> lives;
+        for (NKGeometryHandle h = 0; h < slots.size(); ++h) {
+            const Slot& slot = slots[h];
+            if (!slot.live) continue;
+
+            if (vertices && slot.range.vertexPool == poolIndex) {
+                lives.push_back({ h, slot.range.vertexChunk, slot.range.vertexOffset, slot.range.vertexCount });
+            }
+            else if (!vertices && slot.hasIndices) {
+                lives.push_back({ h, slot.range.indexChunk, slot.range.firstIndex / (4 / indexSize(slot.range.indexType)),
+                    indexWords(slot.range.indexType, slot.range.indexCount) });
+            }
+        }
+
+        //keep the current order so neighbouring meshes stay neighbours
+        std::sort(lives.begin(), lives.end(), [](const Live& a, const Live& b) {
+            return a.chunk != b.chunk ? a.chunk < b.chunk : a.offset < b.offset;
+        });
+
+        //pack front to back, oversized meshes keep a chunk of their own
+        std::vector<uint32_t> newCapacities;
+        std::vector<uint32_t> newUsed;
+        uint32_t fillChunk = ~0u;//regular sized chunk being filled
+        for (auto& live : lives) {
+            uint32_t target;
+            if (live.count > pool.chunkElements) {
+                target = static_cast<uint32_t>(newCapacities.size());
+                newCapacities.push_back(live.count);
+                newUsed.push_back(0);
+            }
+            else {
+                if (fillChunk == ~0u || newUsed[fillChunk] + live.count > newCapacities[fillChunk]) {
+                    fillChunk = static_cast<uint32_t>(newCapacities.size());
+                    newCapacities.push_back(pool.chunkElements);
+                    newUsed.push_back(0);
+                }
+                target = fillChunk;
+            }
+            live.newChunk = target;
+            live.newOffset = newUsed[target];
+            newUsed[target] += live.count;
+        }
+
+        //already packed, nothing to move
+        bool packed = newCapacities.size() == pool.chunks.size();
+        for (uint32_t c = 0; packed && c < newCapacities.size(); ++c) {
+            packed = pool.chunks[c]->capacity == newCapacities[c] && pool.chunks[c]->usedElements == newUsed[c];
+        }
+        for (const auto& live : lives) {
+            packed = packed && live.chunk == live.newChunk && live.offset == live.newOffset;
+        }
+        if (packed) {
+            return;
+        }
+
+        Pool packedPool{};
+        packedPool.elementSize = pool.elementSize;
+        packedPool.chunkElements = pool.chunkElements;
+        packedPool.usage = pool.usage;
+        for (uint32_t c = 0; c < newCapacities.size(); ++c) {
+            Chunk& chunk = createChunk(packedPool, newCapacities[c]);
+            chunk.freeRanges.clear();
+            if (newUsed[c] < newCapacities[c]) {
+                chunk.freeRanges.emplace(newUsed[c], newCapacities[c] - newUsed[c]);
+            }
+            chunk.usedElements = newUsed[c];
+        }
+
+        //one copy per run of ranges moving between the same pair of chunks
+        if (!lives.empty()) {
+            VkCommandBuffer commandBuffer = device.beginSingleTimeCommands();
+            std::vector<VkBufferCopy> regions;
+            for (size_t i = 0; i < lives.size(); ++i) {
+                const Live& live = lives[i];
+                regions.push_back({
+                    static_cast<VkDeviceSize>(live.offset) * pool.elementSize,
+                    static_cast<VkDeviceSize>(live.newOffset) * pool.elementSize,
+                    static_cast<VkDeviceSize>(live.count) * pool.elementSize });
+
+                bool lastOfRun = i + 1 == lives.size() || lives[i + 1].chunk != live.chunk || lives[i + 1].newChunk != live.newChunk;
+                if (lastOfRun) {
+                    vkCmdCopyBuffer(commandBuffer, pool.chunks[live.chunk]->buffer, packedPool.chunks[live.newChunk]->buffer,
+                        static_cast<uint32_t>(regions.size()), regions.data());
+                    regions.clear();
+                }
+            }
+            device.endSingleTimeCommands(commandBuffer);//waits for the copies
+        }
+
+        for (auto& chunk : pool.chunks) {
+            destroyChunk(*chunk);
+        }
+        pool.chunks = std::move(packedPool.chunks);
+
+        for (const auto& live : lives) {
+            NKGeometryRange& range = slots[live.handle].range;
+            if (vertices) {
+                range.vertexChunk = live.newChunk;
+                range.vertexOffset = live.newOffset;
+            }
+            else {
+                range.indexChunk = live.newChunk;
+                range.firstIndex = live.newOffset * (4 / indexSize(range.indexType));
+            }
+        }
+    }
+
+    NKGeometryPoolStats NKGeometryPool::getStats() const {
+        NKGeometryPoolStats stats{};
+        uint64_t freeBytes = 0;
+        uint64_t largestFreeBytes = 0;
+
+        auto addPool = [&](const Pool& pool) {
+            for (const auto& chunk : pool.chunks) {
+                stats.chunkCount++;
+                stats.reservedBytes += static_cast<VkDeviceSize>(chunk->capacity) * pool.elementSize;
+                stats.usedBytes += static_cast<VkDeviceSize>(chunk->usedElements) * pool.elementSize;
+                for (const auto& range : chunk->freeRanges) {
+                    uint64_t bytes = static_cast<uint64_t>(range.second) * pool.elementSize;
+                    freeBytes += bytes;
+                    largestFreeBytes = std::max(largestFreeBytes, bytes);
+                }
+            }
+        };
+        for (const auto& pool : vertexPools) {
+            addPool(pool);
+        }
+        addPool(indexPool);
+
+        for (const auto& slot : slots) {
+            if (slot.live) stats.rangeCount++;
+        }
+        stats.pendingFrees = static_cast<uint32_t>(pendingFrees.size());
+        stats.rangeCount -= stats.pendingFrees;//freed, only kept alive for the gpu
+
+        if (freeBytes > 0) {
+            stats.fragmentation = 1.f - static_cast<float>(largestFreeBytes) / static_cast<float>(freeBytes);
+        }
+        stats.releasedBytes = releasedBytes;
+        stats.compactions = compactions;
+        return stats;
+    }
+
+}  // namespace lve
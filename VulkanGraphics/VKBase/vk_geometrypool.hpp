@@ -0,0 +1,175 @@
+#pragma once
+
+#include "vk_allocator.hpp"
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace nekographics {
+
+    class NKDevice;
+
+    using NKGeometryHandle = uint32_t;
+    constexpr NKGeometryHandle NK_INVALID_GEOMETRY = ~0u;
+
+    //where one mesh lives inside the pool, offsets are in vertices / indices so they feed vkCmdDrawIndexed directly
+    struct NKGeometryRange {
+        uint32_t vertexPool = 0;//one pool per vertex stride
+        uint32_t vertexChunk = 0;
+        uint32_t vertexOffset = 0;
+        uint32_t vertexCount = 0;
+
+        uint32_t indexChunk = 0;
+        uint32_t firstIndex = 0;
+        uint32_t indexCount = 0;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+    };
+
+    //buffers bound on a command buffer, pass the same state to every bind of a pass to skip redundant binds
+    struct NKGeometryBindState {
+        VkBuffer vertexBuffer = VK_NULL_HANDLE;
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        VkIndexType indexType = VK_INDEX_TYPE_MAX_ENUM;
+
+        uint32_t bindCount = 0;//vertex & index buffer binds recorded
+        uint32_t skippedBindCount = 0;//binds left out because the buffer was already bound
+    };
+
+    struct NKGeometryPoolStats {
+        uint32_t chunkCount = 0;//vertex & index buffers in use
+        uint32_t rangeCount = 0;//live meshes
+        uint32_t pendingFrees = 0;//freed meshes still waiting for the frames that may draw them
+        VkDeviceSize reservedBytes = 0;
+        VkDeviceSize usedBytes = 0;
+        float fragmentation = 0.f;//0 = every chunk's free space is one range, close to 1 = free space is scattered
+        VkDeviceSize releasedBytes = 0;//freed since the last compaction
+        uint32_t compactions = 0;
+    };
+
+    /*
+    Suballocates the vertices & indices of every model out of a few large device local buffers,
+    one set of vertex chunks per vertex stride & one set of index chunks shared by uint16 and
+    uint32 indices. Most of a frame then draws from the same buffers, binds only change when a
+    mesh lives in another chunk.
+
+    Freed ranges are kept until every frame that may still read them has finished. compact()
+    repacks the live ranges into fresh chunks, it waits for the device so call it on unloads,
+    never mid frame. endFrame calls it once the unloaded meshes add up to a share of the reserved
+    bytes. Handles stay valid across compaction, ranges don't so draws fetch them when recording.
+    */
+    class NKGeometryPool {
+    public:
+        static constexpr VkDeviceSize DEFAULT_VERTEX_CHUNK_SIZE = 32ull * 1024 * 1024;
+        static constexpr VkDeviceSize DEFAULT_INDEX_CHUNK_SIZE = 16ull * 1024 * 1024;
+        static constexpr float DEFAULT_COMPACT_THRESHOLD = 0.25f;//released bytes / reserved bytes
+
+        NKGeometryPool(NKDevice& device,
+            VkDeviceSize vertexChunkSize = DEFAULT_VERTEX_CHUNK_SIZE,
+            VkDeviceSize indexChunkSize = DEFAULT_INDEX_CHUNK_SIZE);
+        ~NKGeometryPool();
+
+        NKGeometryPool(const NKGeometryPool&) = delete;
+        NKGeometryPool& operator=(const NKGeometryPool&) = delete;
+
+        /**
+         * Reserves space for a mesh's vertices
+         *
+         * @param vertexStride Size of one vertex in bytes
+         *
+         * @return NKGeometryHandle of the new range
+         */
+        NKGeometryHandle allocate(uint32_t vertexStride, uint32_t vertexCount);
+
+        /**
+         * Reserves space for the indices of a range returned by allocate
+         *
+         * @param indexType VK_INDEX_TYPE_UINT16 or VK_INDEX_TYPE_UINT32, relative to the range's first vertex
+         */
+        void allocateIndices(NKGeometryHandle handle, VkIndexType indexType, uint32_t indexCount);
+
+        //copies through the upload manager, data has to hold vertexCount vertices / indexCount indices
+        void uploadVertices(NKGeometryHandle handle, const void* data);
+        void uploadIndices(NKGeometryHandle handle, const void* data);
+
+        //the range is reused once the frames in flight are done with it
+        void free(NKGeometryHandle handle);
+
+        const NKGeometryRange& getRange(NKGeometryHandle handle) const { return slots[handle].range; }
+
+        /**
+         * Binds the buffers a range lives in
+         *
+         * @param state (Optional) Buffers already bound on the command buffer, binds matching it are skipped
+         */
+        void bind(VkCommandBuffer commandBuffer, NKGeometryHandle handle, NKGeometryBindState* state = nullptr);
+
+        //call once per submitted frame, releases ranges no frame in flight can read anymore & compacts past the threshold
+        void endFrame();
+        void setCompactThreshold(float threshold) { compactThreshold = threshold; }//above 1 only compacts when asked
+
+        //waits for the device & repacks every live range, releasing empty chunks
+        void compact();
+
+        NKGeometryPoolStats getStats() const;
+
+    private:
+        //one large buffer, carved up in elements (vertices, or 4 byte index words)
+        struct Chunk {
+            VkBuffer buffer = VK_NULL_HANDLE;
+            NKAllocation allocation;
+            uint32_t capacity = 0;
+            uint32_t usedElements = 0;
+            std::map<uint32_t, uint32_t> freeRanges;//offset -> count, kept coalesced
+        };
+
+        struct Pool {
+            uint32_t elementSize = 0;
+            uint32_t chunkElements = 0;
+            VkBufferUsageFlags usage = 0;
+            std::vector<std::unique_ptr<Chunk>> chunks;
+        };
+
+        struct Slot {
+            NKGeometryRange range;
+            bool live = false;
+            bool hasIndices = false;
+        };
+
+        struct PendingFree {
+            NKGeometryHandle handle;
+            uint64_t releaseFrame;
+        };
+
+        Chunk& createChunk(Pool& pool, uint32_t capacity);
+        void destroyChunk(Chunk& chunk);
+        uint32_t allocateElements(Pool& pool, uint32_t count, uint32_t& outChunk);//returns the offset
+        void freeElements(Pool& pool, uint32_t chunk, uint32_t offset, uint32_t count);
+        void compactPool(Pool& pool, bool vertices, uint32_t poolIndex);
+        void release(NKGeometryHandle handle);
+
+        //index ranges are counted in 4 byte words so uint16 & uint32 lists can share a buffer
+        static uint32_t indexWords(VkIndexType indexType, uint32_t indexCount);
+        static uint32_t indexSize(VkIndexType indexType) { return indexType == VK_INDEX_TYPE_UINT16 ? 2 : 4; }
+
+        NKDevice& device;
+        VkDeviceSize vertexChunkSize;//split per stride when a vertex pool is created
+
+        std::vector<Pool> vertexPools;
+        Pool indexPool;
+
+        std::vector<Slot> slots;//indexed by handle
+        std::vector<NKGeometryHandle> freeHandles;
+
+        std::vector<PendingFree> pendingFrees;
+        uint64_t frameCounter = 0;
+
+        float compactThreshold = DEFAULT_COMPACT_THRESHOLD;
+        VkDeviceSize releasedBytes = 0;//holes left by unloads since the last compaction
+        uint32_t compactions = 0;
+    };
+
+}  // namespace lve
@@ -0,0 +1,222 @@
+#include "vk_jobsystem.hpp"
+
+// std
+#include <algorithm>
+#include <iostream>
+#include <utility>
+
+namespace nekographics {
+
+    namespace {
+        //which system the current thread works for, a thread can only be a worker of one
+        struct ThreadSlot {
+            const NKJobSystem* system = nullptr;
+            uint32_t index = 0;
+        };
+        thread_local ThreadSlot currentThread;
+    }
+
+    NKJobSystem::NKJobSystem(uint32_t workerCount) {
+        if (workerCount == 0) {
+            workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;//the owning thread is the last core
+        }
+
+        queues.resize(workerCount + 1);
+        for (auto& queue : queues) {
+            queue = std::make_unique<Queue>();
+        }
+
+        //every queue exists before a worker can steal from it
+        for (uint32_t i = 1; i <= workerCount; ++i) {
+            workers.emplace_back([this, i] { workerLoop(i); });
+        }
+    }
+
+    NKJobSystem::~NKJobSystem() {
+        //jobs still queued are dropped, wait on their counters first
+        {
+            std::lock_guard<std::mutex> lock{ sleepMutex };
+            stopping = true;
+        }
+        sleepCondition.notify_all();
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    uint32_t NKJobSystem::getThreadIndex() const {
+        return currentThread.system == this ? currentThread.index : 0;
+    }
+
+    void NKJobSystem::run(Job job, NKJobCounter* counter) {
+        if (counter) {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+        push({ std::move(job), counter });
+    }
+
+    void NKJobSystem::runAfter(NKJobCounter& dependency, Job job, NKJobCounter* counter) {
+        if (counter) {
+            counter->pending.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{ dependency.mutex };
+            if (dependency.pending.load(std::memory_order_acquire) != 0) {
+                dependency.continuations.emplace_back(std::move(job), counter);//queued by the job that finishes it
+                return;
+            }
+        }
+        push({ std::move(job), counter });
+    }
+
+    void NKJobSystem::wait(NKJobCounter& counter) {
+        const uint32_t threadIndex = getThreadIndex();
+        Task task;
+        while (!counter.isDone()) {
+            if (pop(threadIndex, task)) {
+                execute(task);
+            }
+            else {
+                std::this_thread::yield();//the last jobs are running on other threads
+            }
+        }
+
+        //the thread that finished the counter lets go of it before anyone may destroy it
+        std::exception_ptr error;
+        {
+            std::lock_guard<std::mutex> lock{ counter.mutex };
+            error = std::exchange(counter.error, nullptr);
+        }
+        if (!error) {
+            std::lock_guard<std::mutex> lock{ uncountedErrorMutex };
+            error = std::exchange(uncountedError, nullptr);
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    void NKJobSystem::parallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)>& function) {
+        grainSize = std::max(grainSize, 1u);
+        if (count <= grainSize) {
+            if (count > 0) {
+                function(0, count);//not worth a job
+            }
+            return;
+        }
+
+        NKJobCounter counter;
+        for (uint32_t begin = 0; begin < count; begin += grainSize) {
+            const uint32_t end = count - begin > grainSize ? begin + grainSize : count;
+            run([&function, begin, end] { function(begin, end); }, &counter);
+        }
+        wait(counter);//the calling thread pops its own ranges back to front while the workers steal from the front
+    }
+
+    void NKJobSystem::push(Task task) {
+        Queue& queue = *queues[getThreadIndex()];
+        {
+            std::lock_guard<std::mutex> lock{ queue.mutex };
+            queue.tasks.push_back(std::move(task));
+        }
+        queuedTasks.fetch_add(1);
+
+        //a worker going to sleep counts itself before it checks queuedTasks, one of the two sees the other
+        if (sleepingWorkers.load() > 0) {
+            { std::lock_guard<std::mutex> lock{ sleepMutex }; }
+            sleepCondition.notify_one();
+        }
+    }
+
+    bool NKJobSystem::pop(uint32_t threadIndex, Task& task) {
+        if (queuedTasks.load(std::memory_order_relaxed) == 0) {
+            return false;
+        }
+
+        //newest of our own first, it is the one most likely still in the cache
+        {
+            Queue& queue = *queues[threadIndex];
+            std::lock_guard<std::mutex> lock{ queue.mutex };
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.back());
+                queue.tasks.pop_back();
+                queuedTasks.fetch_sub(1);
+                return true;
+            }
+        }
+
+        //steal the oldest of another thread, usually the biggest piece of what it split up
+        const uint32_t queueCount = getThreadCount();
+        for (uint32_t offset = 1; offset < queueCount; ++offset) {
+            Queue& queue = *queues[(threadIndex + offset) % queueCount];
+            std::lock_guard<std::mutex> lock{ queue.mutex };
+            if (!queue.tasks.empty()) {
+                task = std::move(queue.tasks.front());
+                queue.tasks.pop_front();
+                queuedTasks.fetch_sub(1);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void NKJobSystem::execute(Task& task) {
+        std::exception_ptr error;
+        try {
+            task.job();
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        task.job = nullptr;//captures are released before the counter says the job is done
+
+        NKJobCounter* counter = task.counter;
+        if (counter == nullptr) {
+            if (error) {
+                //nobody waits on this job, the next wait of any counter reports it instead 
+                std::cerr << "job without a counter threw, rethrown by the next wait" << std::endl;
+                std::lock_guard<std::mutex> lock{ uncountedErrorMutex };
+                if (!uncountedError) {
+                    uncountedError = error;
+                }
+            }
+            return;
+        }
+
+        //decremented under the lock so runAfter can't append to a counter that already finished
+        std::vector<std::pair<Job, NKJobCounter*>> ready;
+        {
+            std::lock_guard<std::mutex> lock{ counter->mutex };
+            if (error && !counter->error) {
+                counter->error = error;
+            }
+            if (counter->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                ready.swap(counter->continuations);
+            }
+        }
+
+        for (auto& [job, jobCounter] : ready) {
+            push({ std::move(job), jobCounter });
+        }
+    }
+
+    void NKJobSystem::workerLoop(uint32_t threadIndex) {
+        currentThread = { this, threadIndex };
+
+        Task task;
+        while (!stopping.load()) {
+            if (pop(threadIndex, task)) {
+                execute(task);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock{ sleepMutex };
+            sleepingWorkers.fetch_add(1);
+            sleepCondition.wait(lock, [this] { return stopping.load() || queuedTasks.load() > 0; });
+            sleepingWorkers.fetch_sub(1);
+        }
+    }
+
+}  // namespace lve
@@ -0,0 +1,112 @@
+#pragma once
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nekographics {
+
+    class NKJobSystem;
+
+    /*
+    Counts the unfinished jobs of a batch. Jobs queued with runAfter start once it reaches zero,
+    wait() on it runs other jobs until it does & rethrows the first exception a counted job threw.
+    Has to outlive the jobs it counts.
+    */
+    class NKJobCounter {
+    public:
+        NKJobCounter() = default;
+
+        NKJobCounter(const NKJobCounter&) = delete;
+        NKJobCounter& operator=(const NKJobCounter&) = delete;
+
+        bool isDone() const { return pending.load(std::memory_order_acquire) == 0; }
+
+    private:
+        friend class NKJobSystem;
+
+        std::atomic<uint32_t> pending{ 0 };
+        std::mutex mutex;//guards the decrement & the continuations
+        std::vector<std::pair<std::function<void()>, NKJobCounter*>> continuations;//queued when pending reaches zero
+        std::exception_ptr error;
+    };
+
+    /*
+    Work stealing job scheduler. Every thread has its own deque, a thread pushes & pops the back of
+    its deque & steals from the front of the others when it runs dry, so the jobs a thread spawns
+    stay on that thread while there is no one idle. The thread that created the system counts as
+    thread 0 & only runs jobs while it waits on a counter, workers are threads 1 and up.
+    */
+    class NKJobSystem {
+    public:
+        using Job = std::function<void()>;
+
+        //workerCount 0 picks one less than the hardware threads
+        NKJobSystem(uint32_t workerCount = 0);
+        ~NKJobSystem();
+
+        NKJobSystem(const NKJobSystem&) = delete;
+        NKJobSystem& operator=(const NKJobSystem&) = delete;
+
+        //workers plus the calling thread, the range of getThreadIndex
+        uint32_t getThreadCount() const { return static_cast<uint32_t>(queues.size()); }
+
+        //index of the current thread in this system, 0 for the owning thread & threads outside of it
+        uint32_t getThreadIndex() const;
+
+        //counter is incremented now & decremented once the job has run
+        void run(Job job, NKJobCounter* counter = nullptr);
+
+        //queued once dependency has no unfinished jobs left, right away if it has none now
+        void runAfter(NKJobCounter& dependency, Job job, NKJobCounter* counter = nullptr);
+
+        //runs queued jobs on the calling thread until the counter reaches zero, then rethrows the counter's exception,
+        //or else one a job without a counter threw since the last wait
+        void wait(NKJobCounter& counter);
+
+        /**
+         * Splits [0, count) into ranges of grainSize & runs them as jobs, returns when every range is done
+         *
+         * @param grainSize Indices per job, the last one gets what is left
+         * @param function Called with [begin, end) of a range, from any thread of the system
+         */
+        void parallelFor(uint32_t count, uint32_t grainSize, const std::function<void(uint32_t begin, uint32_t end)>& function);
+
+    private:
+        struct Task {
+            Job job;
+            NKJobCounter* counter = nullptr;
+        };
+
+        struct Queue {
+            std::deque<Task> tasks;
+            std::mutex mutex;
+        };
+
+        void push(Task task);
+        bool pop(uint32_t threadIndex, Task& task);//own back first, then the front of the others
+        void execute(Task& task);//also finishes the task's counter
+        void workerLoop(uint32_t threadIndex);
+
+        std::vector<std::unique_ptr<Queue>> queues;//one per thread, 0 is the owning thread's
+        std::vector<std::thread> workers;
+
+        std::atomic<uint32_t> queuedTasks{ 0 };
+        std::atomic<uint32_t> sleepingWorkers{ 0 };
+        std::mutex sleepMutex;
+        std::condition_variable sleepCondition;
+        std::atomic<bool> stopping{ false };
+
+        std::mutex uncountedErrorMutex;
+        std::exception_ptr uncountedError;//first exception of a job without a counter, rethrown by the next wait
+    };
+
+}  // namespace lve
@@ -0,0 +1,124 @@
+#include "vk_material.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace nekographics {
+
+    NKMaterialTable::NKMaterialTable(NKDevice& tableDevice) : device{ tableDevice } {
+        if (!device.supportsDescriptorIndexing()) {
+            throw std::runtime_error("failed to create material table, descriptor indexing is not supported!");
+        }
+        textureCapacity = std::min(MAX_TEXTURES, device.getMaxBindlessTextures());
+        textureInfos.reserve(textureCapacity);
+
+        materialBuffer = std::make_unique<NKBuffer>(
+            device,
+            sizeof(NKMaterial),
+            MAX_MATERIALS,
+            VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+        materialBuffer->map();
+    }
+
+    void NKMaterialTable::addBindings(NKDescriptorSetLayout::Builder& builder) const {
+        builder.addBinding(MATERIAL_BUFFER_BINDING, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT);
+
+        //slots past the last texture are never written, & new ones are written while earlier frames are pending
+        builder.addBinding(TEXTURE_ARRAY_BINDING, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, textureCapacity);
+        builder.setBindingFlags(TEXTURE_ARRAY_BINDING,
+            VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT
+            | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT
+            | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT);
+    }
+
+    void NKMaterialTable::addPoolSizes(NKDescriptorPool::Builder& builder, uint32_t setCount) const {
+        builder.addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, setCount);
+        builder.addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, setCount * textureCapacity);
+    }
+
+    void NKMaterialTable::attach(VkDescriptorSet set) {
+        VkDescriptorBufferInfo bufferInfo = materialBuffer->descriptorInfo();
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = set;
+        write.dstBinding = MATERIAL_BUFFER_BINDING;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        write.descriptorCount = 1;
+        write.pBufferInfo = &bufferInfo;
+        vkUpdateDescriptorSets(device.device(), 1, &write, 0, nullptr);
+
+        writeTextures(set, 0, getTextureCount());
+        sets.push_back(set);
+        changedTextures.emplace_back();
+    }
+
+    uint32_t NKMaterialTable::addTexture(VkImageView imageView, VkSampler sampler) {
+        if (textureInfos.size() >= textureCapacity) {
+            throw std::runtime_error("failed to add texture, the material table is full!");
+        }
+
+        uint32_t index = getTextureCount();
+        textureInfos.push_back({ sampler, imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL });
+
+        //no pending frame can be sampling a slot that was never written
+        for (VkDescriptorSet set : sets) {
+            writeTextures(set, index, 1);
+        }
+        return index;
+    }
+
+    uint32_t NKMaterialTable::addMaterial(const NKMaterial& material) {
+        if (materials.size() >= MAX_MATERIALS) {
+            throw std::runtime_error("failed to add material, the material table is full!");
+        }
+
+        uint32_t index = getMaterialCount();
+        materials.push_back(material);
+        materialBuffer->writeToIndex(&materials.back(), static_cast<int>(index));
+        return index;
+    }
+
+    void NKMaterialTable::setTexture(uint32_t index, VkImageView imageView, VkSampler sampler) {
+        assert(index < getTextureCount() && "Texture index out of range");
+        textureInfos[index] = { sampler, imageView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+
+        //a frame in flight may be sampling the slot, so it is only rewritten per set in updateSet
+        for (auto& changed : changedTextures) {
+            if (std::find(changed.begin(), changed.end(), index) == changed.end()) {
+                changed.push_back(index);
+            }
+        }
+    }
+
+    void NKMaterialTable::updateSet(VkDescriptorSet set) {
+        auto found = std::find(sets.begin(), sets.end(), set);
+        assert(found != sets.end() && "Updating a set that was never attached");
+
+        auto& changed = changedTextures[found - sets.begin()];
+        for (uint32_t index : changed) {
+            writeTextures(set, index, 1);
+        }
+        changed.clear();
+    }
+
+    void NKMaterialTable::writeTextures(VkDescriptorSet set, uint32_t firstTexture, uint32_t textureCount) {
+        if (textureCount == 0) {
+            return;
+        }
+
+        VkWriteDescriptorSet write{};
+        write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        write.dstSet = set;
+        write.dstBinding = TEXTURE_ARRAY_BINDING;
+        write.dstArrayElement = firstTexture;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.descriptorCount = textureCount;
+        write.pImageInfo = textureInfos.data() + firstTexture;
+        vkUpdateDescriptorSets(device.device(), 1, &write, 0, nullptr);
+    }
+
+}  // namespace lve
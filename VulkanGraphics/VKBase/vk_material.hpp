@@ -0,0 +1,78 @@
+#pragma once
+
+#include "vk_device.hpp"
+#include "vk_buffer.hpp"
+#include "vk_descriptors.hpp"
+
+// std
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace nekographics {
+
+    //one entry of the material buffer, matches Material in shaderMaterial.frag (std430)
+    struct NKMaterial {
+        uint32_t normalTexture = 0;//indices into the texture array, from NKMaterialTable::addTexture
+        uint32_t diffuseTexture = 0;
+        uint32_t aoTexture = 0;
+        uint32_t roughnessTexture = 0;
+    };
+
+    /*
+    Every material & texture the fragment shaders can sample, as two bindings of the global set: a storage
+    buffer of NKMaterial & a partially bound array of combined image samplers. Draws carry a material index
+    & the shader looks its textures up from there, so adding textures or materials never touches a set
+    layout or a pipeline. Both are append only: a frame in flight keeps reading the entries it was recorded
+    with while new ones are written behind it, the texture slots through VK_EXT_descriptor_indexing's
+    update after bind. setTexture swaps the image behind a slot, each set picks that up in updateSet once
+    its frame is no longer in flight.
+    */
+    class NKMaterialTable {
+    public:
+        static constexpr uint32_t MATERIAL_BUFFER_BINDING = 1;
+        static constexpr uint32_t TEXTURE_ARRAY_BINDING = 2;
+        static constexpr uint32_t MAX_MATERIALS = 1024;
+        static constexpr uint32_t MAX_TEXTURES = 4096;//lowered to the device limit
+
+        NKMaterialTable(NKDevice& device);
+
+        NKMaterialTable(const NKMaterialTable&) = delete;
+        NKMaterialTable& operator=(const NKMaterialTable&) = delete;
+
+        //the two bindings, the pool the sets come from needs VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT
+        void addBindings(NKDescriptorSetLayout::Builder& builder) const;
+        void addPoolSizes(NKDescriptorPool::Builder& builder, uint32_t setCount) const;
+
+        //writes the table into a set allocated with addBindings' layout, it gets every texture added later too
+        void attach(VkDescriptorSet set);
+
+        //the image has to be in VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL & outlive the table, returns its index
+        uint32_t addTexture(VkImageView imageView, VkSampler sampler);
+        uint32_t addMaterial(const NKMaterial& material);//returns the index draws refer to it by
+
+        //points a slot at another image, the old one is sampled until every attached set went through updateSet
+        void setTexture(uint32_t index, VkImageView imageView, VkSampler sampler);
+        //writes the slots changed since the set's last update, call when the frame using the set is not in flight
+        void updateSet(VkDescriptorSet set);
+
+        uint32_t getTextureCount() const { return static_cast<uint32_t>(textureInfos.size()); }
+        uint32_t getMaterialCount() const { return static_cast<uint32_t>(materials.size()); }
+        const NKMaterial& getMaterial(uint32_t index) const { return materials[index]; }
+        uint32_t getTextureCapacity() const { return textureCapacity; }
+
+    private:
+        void writeTextures(VkDescriptorSet set, uint32_t firstTexture, uint32_t textureCount);
+
+        NKDevice& device;
+        uint32_t textureCapacity;
+
+        std::unique_ptr<NKBuffer> materialBuffer;//host coherent, written in place
+        std::vector<NKMaterial> materials;//what the buffer holds, for the texture streaming
+
+        std::vector<VkDescriptorImageInfo> textureInfos;//by texture index
+        std::vector<VkDescriptorSet> sets;//every attached set
+        std::vector<std::vector<uint32_t>> changedTextures;//per attached set, slots setTexture changed since its updateSet
+    };
+
+}  // namespace lve
@@ -0,0 +1,366 @@
+//includes
+#include "vk_meshoptimizer.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <iostream>
+
+namespace nekographics {
+
+    namespace {
+        //Forsyth's tuning, scores are from "Linear-Speed Vertex Cache Optimisation"
+        constexpr uint32_t FORSYTH_CACHE_SIZE = 32;
+        constexpr float FORSYTH_DECAY_POWER = 1.5f;
+        constexpr float FORSYTH_LAST_TRI_SCORE = 0.75f;
+        constexpr float FORSYTH_VALENCE_BOOST_SCALE = 2.f;
+        constexpr float FORSYTH_VALENCE_BOOST_POWER = 0.5f;
+        constexpr uint32_t FORSYTH_MAX_VALENCE = 32;//valences above share the last table entry
+
+        struct ForsythTables {
+            float cache[FORSYTH_CACHE_SIZE];
+            float valence[FORSYTH_MAX_VALENCE + 1];
+
+            ForsythTables() {
+                for (uint32_t i = 0; i < FORSYTH_CACHE_SIZE; ++i) {
+                    if (i < 3) {
+                        cache[i] = FORSYTH_LAST_TRI_SCORE;//the last triangle's vertices, avoid using them straight away
+                    }
+                    else {
+                        const float scaler = 1.f / static_cast<float>(FORSYTH_CACHE_SIZE - 3);
+                        cache[i] = std::pow(1.f - static_cast<float>(i - 3) * scaler, FORSYTH_DECAY_POWER);
+                    }
+                }
+
+                valence[0] = 0.f;
+                for (uint32_t i = 1; i <= FORSYTH_MAX_VALENCE; ++i) {
+                    valence[i] = FORSYTH_VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i), -FORSYTH_VALENCE_BOOST_POWER);
+                }
+            }
+        };
+
+        float forsythScore(const ForsythTables& tables, int32_t cachePosition, uint32_t valence) {
+            if (valence == 0) {
+                return -1.f;//no triangles left to draw with it
+            }
+            float score = cachePosition >= 0 ? tables.cache[cachePosition] : 0.f;
+            return score + tables.valence[std::min(valence, FORSYTH_MAX_VALENCE)];
+        }
+
+        //fifo cache simulation shared by the stats & the overdraw clustering
+        class FifoCache {
+        public:
+            FifoCache(uint32_t vertexCount, uint32_t size) : timestamps(vertexCount, 0), cacheSize{ size }, time{ size + 1 } {}
+
+            //returns the number of misses of one triangle
+            uint32_t triangle(const uint32_t* tri) {
+                uint32_t misses = 0;
+                for (uint32_t i = 0; i < 3; ++i) {
+                    if (time - timestamps[tri[i]] > cacheSize) {
+                        timestamps[tri[i]] = time++;
+                        misses++;
+                    }
+                }
+                return misses;
+            }
+
+            void reset() {
+                time += cacheSize + 1;//everything currently cached is now too old
+            }
+
+        private:
+            std::vector<uint32_t> timestamps;
+            uint32_t cacheSize;
+            uint32_t time;
+        };
+    }
+
+    NKVertexCacheStats NKMeshOptimizer::analyzeVertexCache(const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize) {
+        NKVertexCacheStats stats{};
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0 || vertexCount == 0) {
+            return stats;
+        }
+
+        FifoCache cache{ vertexCount, cacheSize };
+        std::vector<bool> referenced(vertexCount, false);
+        uint32_t referencedCount = 0;
+        uint64_t misses = 0;
+
+        for (size_t t = 0; t < triangleCount; ++t) {
+            misses += cache.triangle(&indices[t * 3]);
+            for (uint32_t i = 0; i < 3; ++i) {
+                if (!referenced[indices[t * 3 + i]]) {
+                    referenced[indices[t * 3 + i]] = true;
+                    referencedCount++;
+                }
+            }
+        }
+
+        stats.acmr = static_cast<float>(misses) / static_cast<float>(triangleCount);
+        stats.atvr = static_cast<float>(misses) / static_cast<float>(referencedCount);
+        return stats;
+    }
+
+    void NKMeshOptimizer::optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount) {
+        static const ForsythTables tables;
+
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0) {
+            return;
+        }
+
+        //triangles using each vertex, packed one range per vertex, live triangles first
+        std::vector<uint32_t> valence(vertexCount, 0);
+        for (uint32_t index : indices) {
+            assert(index < vertexCount && "index out of range");
+            valence[index]++;
+        }
+
+        std::vector<uint32_t> adjacencyOffset(vertexCount + 1, 0);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            adjacencyOffset[v + 1] = adjacencyOffset[v] + valence[v];
+        }
+
+        std::vector<uint32_t> adjacency(indices.size());
+        {
+            std::vector<uint32_t> fill(adjacencyOffset.begin(), adjacencyOffset.end() - 1);
+            for (size_t t = 0; t < triangleCount; ++t) {
+                for (uint32_t i = 0; i < 3; ++i) {
+                    adjacency[fill[indices[t * 3 + i]]++] = static_cast<uint32_t>(t);
+                }
+            }
+        }
+
+        std::vector<int32_t> cachePosition(vertexCount, -1);
+        std::vector<float> vertexScore(vertexCount);
+        for (uint32_t v = 0; v < vertexCount; ++v) {
+            vertexScore[v] = forsythScore(tables, -1, valence[v]);
+        }
+
+        std::vector<float> triangleScore(triangleCount);
+        std::vector<bool> emitted(triangleCount, false);
+        int64_t best = -1;
+        float bestScore = -1.f;
+        for (size_t t = 0; t < triangleCount; ++t) {
+            triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+            if (triangleScore[t] > bestScore) {
+                bestScore = triangleScore[t];
+                best = static_cast<int64_t>(t);
+            }
+        }
+
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+
+        //lru cache, the 3 extra slots hold vertices pushed out by the newest triangle
+        std::vector<uint32_t> cache;
+        std::vector<uint32_t> nextCache;
+        cache.reserve(FORSYTH_CACHE_SIZE + 3);
+        nextCache.reserve(FORSYTH_CACHE_SIZE + 3);
+
+        size_t fallbackCursor = 0;
+
+        for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount) {
+            if (best < 0) {
+                //nothing in the cache has triangles left, continue with the next unused triangle in file order
+                while (emitted[fallbackCursor]) {
+                    fallbackCursor++;
+                }
+                best = static_cast<int64_t>(fallbackCursor);
+            }
+
+            const uint32_t* tri = &indices[best * 3];
+            output.insert(output.end(), tri, tri + 3);
+            emitted[best] = true;
+
+            //remove the triangle from the live range of its vertices
+            for (uint32_t i = 0; i < 3; ++i) {
+                uint32_t v = tri[i];
+                uint32_t* begin = &adjacency[adjacencyOffset[v]];
+                uint32_t* end = begin + valence[v];
+                uint32_t* found = std::find(begin, end, static_cast<uint32_t>(best));
+                assert(found != end);
+                std::swap(*found, *(end - 1));
+                valence[v]--;
+            }
+
+            //move the triangle's vertices to the front of the cache
+            nextCache.clear();
+            for (uint32_t i = 0; i < 3; ++i) {
+                if (std::find(nextCache.begin(), nextCache.end(), tri[i]) == nextCache.end()) {
+                    nextCache.push_back(tri[i]);
+                }
+            }
+            for (uint32_t v : cache) {
+                if (std::find(nextCache.begin(), nextCache.end(), v) == nextCache.end()) {
+                    nextCache.push_back(v);
+                }
+            }
+
+            //rescore the cached & evicted vertices, then the live triangles around them
+            for (size_t i = 0; i < nextCache.size(); ++i) {
+                uint32_t v = nextCache[i];
+                cachePosition[v] = i < FORSYTH_CACHE_SIZE ? static_cast<int32_t>(i) : -1;
+                vertexScore[v] = forsythScore(tables, cachePosition[v], valence[v]);
+            }
+
+            best = -1;
+            bestScore = -1.f;
+            for (uint32_t v : nextCache) {
+                for (uint32_t a = 0; a < valence[v]; ++a) {
+                    uint32_t t = adjacency[adjacencyOffset[v] + a];
+                    triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+                    if (triangleScore[t] > bestScore) {
+                        bestScore = triangleScore[t];
+                        best = t;
+                    }
+                }
+            }
+
+            if (nextCache.size() > FORSYTH_CACHE_SIZE) {
+                nextCache.resize(FORSYTH_CACHE_SIZE);
+            }
+            cache.swap(nextCache);
+        }
+
+        indices.swap(output);
+    }
+
+    void NKMeshOptimizer::optimizeOverdraw(
+        std::vector<uint32_t>& indices, const glm::vec3* positions, size_t stride, uint32_t vertexCount, float threshold) {
+        size_t triangleCount = indices.size() / 3;
+        if (triangleCount == 0) {
+            return;
+        }
+
+        auto position = [positions, stride](uint32_t v) -> const glm::vec3& {
+            return *reinterpret_cast<const glm::vec3*>(reinterpret_cast<const char*>(positions) + v * stride);
+        };
+
+        //hard boundaries, a triangle missing on all 3 vertices starts a new strip of the cache order
+        std::vector<uint32_t> hardClusters;
+        {
+            FifoCache cache{ vertexCount, ANALYZE_CACHE_SIZE };
+            for (size_t t = 0; t < triangleCount; ++t) {
+                if (cache.triangle(&indices[t * 3]) == 3) {
+                    hardClusters.push_back(static_cast<uint32_t>(t));
+                }
+            }
+            if (hardClusters.empty() || hardClusters[0] != 0) {
+                hardClusters.insert(hardClusters.begin(), 0);
+            }
+        }
+        hardClusters.push_back(static_cast<uint32_t>(triangleCount));
+
+        //soft boundaries, split a hard cluster wherever its running acmr is already within threshold of the whole
+        std::vector<uint32_t> clusters;
+        {
+            FifoCache cache{ vertexCount, ANALYZE_CACHE_SIZE };
+            for (size_t c = 0; c + 1 < hardClusters.size(); ++c) {
+                uint32_t start = hardClusters[c];
+                uint32_t end = hardClusters[c + 1];
+
+                cache.reset();
+                uint32_t clusterMisses = 0;
+                for (uint32_t t = start; t < end; ++t) {
+                    clusterMisses += cache.triangle(&indices[t * 3]);
+                }
+                float clusterThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - start);
+
+                cache.reset();
+                clusters.push_back(start);
+                uint32_t runningMisses = 0;
+                uint32_t runningStart = start;
+                for (uint32_t t = start; t < end; ++t) {
+                    runningMisses += cache.triangle(&indices[t * 3]);
+                    if (t + 1 < end && static_cast<float>(runningMisses) <= clusterThreshold * static_cast<float>(t + 1 - runningStart)) {
+                        clusters.push_back(t + 1);
+                        runningMisses = 0;
+                        runningStart = t + 1;
+                        cache.reset();
+                    }
+                }
+            }
+        }
+        clusters.push_back(static_cast<uint32_t>(triangleCount));
+
+        //draw clusters facing away from the mesh centre first, they are the likely occluders
+        glm::vec3 meshCentroid{ 0.f };
+        for (uint32_t index : indices) {
+            meshCentroid += position(index);
+        }
+        meshCentroid /= static_cast<float>(indices.size());
+
+        struct ClusterOrder {
+            uint32_t cluster;
+            float sortKey;
+        };
+        std::vector<ClusterOrder> order(clusters.size() - 1);
+
+        for (size_t c = 0; c + 1 < clusters.size(); ++c) {
+            glm::vec3 centroid{ 0.f };
+            glm::vec3 normal{ 0.f };
+            float area = 0.f;
+
+            for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t) {
+                const glm::vec3& p0 = position(indices[t * 3]);
+                const glm::vec3& p1 = position(indices[t * 3 + 1]);
+                const glm::vec3& p2 = position(indices[t * 3 + 2]);
+
+                glm::vec3 triNormal = glm::cross(p1 - p0, p2 - p0);//length is twice the area
+                float triArea = glm::length(triNormal);
+
+                centroid += (p0 + p1 + p2) * (triArea / 3.f);
+                normal += triNormal;
+                area += triArea;
+            }
+
+            centroid = area > 0.f ? centroid / area : position(indices[clusters[c] * 3]);
+            float normalLength = glm::length(normal);
+            normal = normalLength > 0.f ? normal / normalLength : glm::vec3{ 0.f };
+
+            order[c] = { static_cast<uint32_t>(c), glm::dot(centroid - meshCentroid, normal) };
+        }
+
+        std::stable_sort(order.begin(), order.end(), [](const ClusterOrder& a, const ClusterOrder& b) {
+            return a.sortKey > b.sortKey;
+        });
+
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+        for (const auto& entry : order) {
+            output.insert(output.end(), indices.begin() + clusters[entry.cluster] * 3, indices.begin() + clusters[entry.cluster + 1] * 3);
+        }
+        indices.swap(output);
+    }
+
+    std::vector<uint32_t> NKMeshOptimizer::optimizeVertexFetch(std::vector<uint32_t>& indices, uint32_t vertexCount) {
+        constexpr uint32_t unassigned = ~0u;
+        std::vector<uint32_t> remap(vertexCount, unassigned);
+        uint32_t next = 0;
+
+        for (uint32_t& index : indices) {
+            if (remap[index] == unassigned) {
+                remap[index] = next++;
+            }
+            index = remap[index];
+        }
+
+        //keep unreferenced vertices so the vertex count does not change
+        for (uint32_t& entry : remap) {
+            if (entry == unassigned) {
+                entry = next++;
+            }
+        }
+        return remap;
+    }
+
+    void NKMeshOptimizer::printStats(const std::string& name, const NKMeshOptimizeStats& stats) {
+        std::cout << name << ": " << stats.triangleCount << " triangles, " << stats.vertexCount << " vertices"
+            << ", acmr " << stats.before.acmr << " -> " << stats.after.acmr
+            << ", atvr " << stats.before.atvr << " -> " << stats.after.atvr << std::endl;
+    }
+
+}  // namespace lve
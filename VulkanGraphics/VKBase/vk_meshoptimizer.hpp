@@ -0,0 +1,104 @@
+#pragma once
+
+// libs
+#include <glm/glm.hpp>
+
+// std lib headers
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nekographics {
+
+    //post transform cache efficiency of an index buffer, lower is better for both
+    struct NKVertexCacheStats {
+        float acmr = 0.f;//average cache miss ratio, vertex shader runs per triangle (0.5 - 3)
+        float atvr = 0.f;//average transformed vertex ratio, vertex shader runs per referenced vertex (1 = ideal)
+    };
+
+    struct NKMeshOptimizeStats {
+        uint32_t triangleCount = 0;
+        uint32_t vertexCount = 0;
+        NKVertexCacheStats before;
+        NKVertexCacheStats after;
+    };
+
+    /*
+    Reorders indexed triangle lists for the gpu, run on the cpu at import time:
+      1. optimizeVertexCache - Forsyth's linear speed vertex cache optimisation
+      2. optimizeOverdraw    - splits the cache ordered list into clusters & draws outward facing
+                               clusters first, keeping most of the cache gains (Sander et al.)
+      3. optimizeVertexFetch - renumbers vertices in first use order so vertex fetches stream
+    optimize() runs all three on a vertex/index pair, vertices only need a glm::vec3 position.
+    */
+    class NKMeshOptimizer {
+    public:
+        static constexpr uint32_t ANALYZE_CACHE_SIZE = 16;//fifo size used for the reported stats
+        static constexpr float DEFAULT_OVERDRAW_THRESHOLD = 1.05f;//allowed acmr increase from the overdraw pass
+
+        /**
+         * Simulates a fifo post transform cache over a triangle list
+         *
+         * @param vertexCount Number of vertices the indices point into
+         * @param cacheSize (Optional) Cache entries to simulate
+         */
+        static NKVertexCacheStats analyzeVertexCache(
+            const std::vector<uint32_t>& indices, uint32_t vertexCount, uint32_t cacheSize = ANALYZE_CACHE_SIZE);
+
+        //reorders the triangles in place for vertex cache locality
+        static void optimizeVertexCache(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+        /**
+         * Reorders clusters of an already cache optimised list to reduce overdraw
+         *
+         * @param positions First position, vertex i is read at positions + i * stride bytes
+         * @param stride Byte stride between positions
+         * @param threshold (Optional) Allowed acmr growth, 1.0 keeps the cache order intact
+         */
+        static void optimizeOverdraw(
+            std::vector<uint32_t>& indices, const glm::vec3* positions, size_t stride, uint32_t vertexCount,
+            float threshold = DEFAULT_OVERDRAW_THRESHOLD);
+
+        /**
+         * Renumbers vertices in the order the indices first use them & rewrites the indices
+         *
+         * @return remap table, old vertex i moves to remap[i], unreferenced vertices go last
+         */
+        static std::vector<uint32_t> optimizeVertexFetch(std::vector<uint32_t>& indices, uint32_t vertexCount);
+
+        //moves every vertex to remap[i]
+        template <typename T>
+        static void remapVertices(std::vector<T>& vertices, const std::vector<uint32_t>& remap) {
+            std::vector<T> remapped(vertices.size());
+            for (size_t i = 0; i < vertices.size(); ++i) {
+                remapped[remap[i]] = vertices[i];
+            }
+            vertices.swap(remapped);
+        }
+
+        //runs the three passes on a triangle list, T needs a glm::vec3 position member
+        template <typename T>
+        static NKMeshOptimizeStats optimize(std::vector<T>& vertices, std::vector<uint32_t>& indices) {
+            NKMeshOptimizeStats stats{};
+            uint32_t vertexCount = static_cast<uint32_t>(vertices.size());
+            stats.triangleCount = static_cast<uint32_t>(indices.size() / 3);
+            stats.vertexCount = vertexCount;
+            stats.before = analyzeVertexCache(indices, vertexCount);
+
+            if (indices.size() < 3 || indices.size() % 3 != 0) {
+                stats.after = stats.before;//not a triangle list, leave it alone
+                return stats;
+            }
+
+            optimizeVertexCache(indices, vertexCount);
+            optimizeOverdraw(indices, &vertices[0].position, sizeof(T), vertexCount);
+            remapVertices(vertices, optimizeVertexFetch(indices, vertexCount));
+
+            stats.after = analyzeVertexCache(indices, vertexCount);
+            return stats;
+        }
+
+        static void printStats(const std::string& name, const NKMeshOptimizeStats& stats);
+    };
+
+}  // namespace lve
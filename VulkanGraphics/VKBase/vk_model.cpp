@@ -1,5 +1,6 @@
 #include "vk_model.hpp"
 #include "NK_utils.hpp"
+#include "vk_frustum.hpp"
 
 
 //libs
@@ -7,6 +8,7 @@
 #include "tinyobjloader/tiny_obj_loader.h"
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
+#include <glm/packing.hpp>
 
 
 // std
@@ -15,6 +17,12 @@
 #include <cstring>
 #include <unordered_map>
 #include <array>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <utility>
 
 namespace std {
     template <>
@@ -29,52 +37,72 @@ namespace std {
 
 namespace nekographics {
 
-    NKModel::NKModel(NKDevice& device, const NKModel::Builder& builder) : m_modelDevice{ device } {
+    NKModel::NKModel(NKDevice& device, const NKModel::Builder& builder) : m_modelDevice{ device }, vertexFormat{ builder.vertexFormat } {
         createVertexBuffers(builder.vertices);
         createIndexBuffers(builder.indices);
+        computeBounds(builder.vertices);
+        uploadTicket = device.getUploadManager().lastTicket();
     }
 
-    NKModel::NKModel(NKDevice& device, const NKModel::AssimpBuilder& builder) : m_modelDevice{ device } {
+    NKModel::NKModel(NKDevice& device, const NKModel::AssimpBuilder& builder) : m_modelDevice{ device }, vertexFormat{ builder.vertexFormat } {
         //createVertexBuffers(builder.meshes.data()->vertices);
         //createIndexBuffers(builder.meshes.data()->indices);
 
-        if (builder.meshes.size() > 1) {
+        //a single mesh placed at the origin is the only case the node hierarchy can be dropped 
+        const auto& meshInstances = builder.sceneGraph.getMeshInstances();
+        bool flat = builder.meshes.size() == 1 && meshInstances.size() == 1
+            && builder.sceneGraph.getWorld(meshInstances[0].node) == glm::mat4(1.f);
+
+        if (!flat) {
             hasChildModels = true;
+            sceneGraph = builder.sceneGraph;
             for (uint32_t i = 0; i < builder.meshes.size(); ++i) {
                 Builder builderTmp{};
                 //copying the builder 
                 builderTmp.vertices = builder.meshes[i].vertices;
                 builderTmp.indices = builder.meshes[i].indices;
+                builderTmp.vertexFormat = builder.vertexFormat;
                 childModels.emplace_back(std::make_unique<NKModel>(device, builderTmp)); //emplace back the child models using the original nk model builder 
             }
+            computeChildBounds();
         }
         else {
             createVertexBuffers(builder.meshes.data()->vertices);
             createIndexBuffers(builder.meshes.data()->indices);
+            computeBounds(builder.meshes.data()->vertices);
         }
 
+        uploadTicket = device.getUploadManager().lastTicket();//tickets only grow, covers every child 
     }
 
     NKModel::~NKModel() {
-
+        if (geometry != NK_INVALID_GEOMETRY) {
+            m_modelDevice.getGeometryPool().free(geometry);//reused once the frames in flight are done 
+        }
     }
 
     std::unique_ptr<NKModel> NKModel::createModelFromFile(
-        NKDevice& device, const std::string& filepath) {
+        NKDevice& device, const std::string& filepath, VertexFormat vertexFormat, bool optimizeMesh) {
         Builder builder{};
+        builder.vertexFormat = vertexFormat;
+        builder.optimizeMesh = optimizeMesh;
         builder.loadModel(filepath);
         return std::make_unique<NKModel>(device, builder);
     }
 
-    std::unique_ptr<NKModel> NKModel::processMesh(NKDevice& device, xprim_geom::mesh pMesh){
+    std::unique_ptr<NKModel> NKModel::processMesh(NKDevice& device, xprim_geom::mesh pMesh, VertexFormat vertexFormat, bool optimizeMesh){
         Builder builder{};
+        builder.vertexFormat = vertexFormat;
+        builder.optimizeMesh = optimizeMesh;
         builder.loadMesh(pMesh);
         return std::make_unique<NKModel>(device, builder);
     }
 
     std::unique_ptr<NKModel> NKModel::createAssimpModelFromFile(
-        NKDevice& device, const std::string& filepath) {
+        NKDevice& device, const std::string& filepath, VertexFormat vertexFormat, bool optimizeMesh) {
         AssimpBuilder builder{};
+        builder.vertexFormat = vertexFormat;
+        builder.optimizeMesh = optimizeMesh;
         builder.loadAssimpModel(filepath);
         return std::make_unique<NKModel>(device, builder);
     }
@@ -82,29 +110,25 @@ namespace nekographics {
     void NKModel::createVertexBuffers(const std::vector<Vertex>& vertices) {
         vertexCount = static_cast<uint32_t>(vertices.size());//getting the vertex count 
         assert(vertexCount >= 3 && "Vertex count must be at least 3");
-        VkDeviceSize bufferSize = sizeof(vertices[0]) * vertexCount;//getting the buffer size 
-        uint32_t vertexSize = sizeof(vertices[0]);//getting the vertex size 
-
-        //creating the staging buffer 
-        NKBuffer stagingBuffer{
-            m_modelDevice,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        stagingBuffer.map();//mapping the memory
-        stagingBuffer.writeToBuffer((void*)vertices.data());//sending the memory cpy to the gpu 
-
-        vertexBuffer = std::make_unique<NKBuffer>(
-            m_modelDevice,
-            vertexSize,
-            vertexCount,
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-        m_modelDevice.copyBuffer(stagingBuffer.getBuffer(), vertexBuffer->getBuffer(), bufferSize);
+
+        //quantize on the cpu, the gpu only ever sees the packed layout 
+        std::vector<PackedVertex> packedVertices;
+        if (vertexFormat == VertexFormat::Packed) {
+            packedVertices.reserve(vertices.size());
+            for (const auto& vertex : vertices) {
+                packedVertices.push_back(PackedVertex::pack(vertex));
+            }
+        }
+
+        uint32_t vertexSize = vertexFormat == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);//getting the vertex size 
+        const void* vertexData = vertexFormat == VertexFormat::Packed ? static_cast<const void*>(packedVertices.data()) : static_cast<const void*>(vertices.data());
+
+        //suballocated from the shared vertex buffers of this stride 
+        NKGeometryPool& geometryPool = m_modelDevice.getGeometryPool();
+        geometry = geometryPool.allocate(vertexSize, vertexCount);
+
+        //staged through the upload ring, the copy is batched with the rest of the load 
+        geometryPool.uploadVertices(geometry, vertexData);
     }
 
 
@@ -117,50 +141,82 @@ namespace nekographics {
             return;
         }
 
-        VkDeviceSize bufferSize = sizeof(indices[0]) * indexCount;
-        uint32_t indexSize = sizeof(indices[0]);
-
-        //setting up the stagging buffer 
-        NKBuffer stagingBuffer{
-            m_modelDevice,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
-            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
-        };
-
-        stagingBuffer.map();//map the buffer on the cpu to the gpu 
-        stagingBuffer.writeToBuffer((void*)indices.data());//copy the information into the gpu
-
-        //creating the actual index buffer 
-        indexBuffer = std::make_unique<NKBuffer>(
-            m_modelDevice,
-            indexSize,
-            indexCount,
-            VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-
-        m_modelDevice.copyBuffer(stagingBuffer.getBuffer(), indexBuffer->getBuffer(), bufferSize);//copy buffer data to the device, optimal memory 
+        //every index fits in 16 bits when the mesh has at most 65536 vertices, halves the index memory & fetch bandwidth
+        //primitive restart is off in every pipeline so 0xFFFF is still a valid index
+        std::vector<uint16_t> shortIndices;
+        const void* indexData = indices.data();
+        indexType = VK_INDEX_TYPE_UINT32;
+
+        if (vertexCount <= MAX_UINT16_INDEXED_VERTICES) {
+            shortIndices.assign(indices.begin(), indices.end());
+            indexData = shortIndices.data();
+            indexType = VK_INDEX_TYPE_UINT16;
+        }
+
+        //indices stay relative to the model's first vertex, the draw adds vertexOffset 
+        NKGeometryPool& geometryPool = m_modelDevice.getGeometryPool();
+        geometryPool.allocateIndices(geometry, indexType, indexCount);
+        geometryPool.uploadIndices(geometry, indexData);//batched copy to the device, optimal memory 
     }
 
-    void NKModel::draw(VkCommandBuffer commandBuffer) {
+    void NKModel::draw(VkCommandBuffer commandBuffer, uint32_t instanceCount, uint32_t firstInstance) {
+        const NKGeometryRange& range = getGeometryRange();
         if (hasIndexBuffer) {
-            vkCmdDrawIndexed(commandBuffer, indexCount, 1, 0, 0, 0);
+            vkCmdDrawIndexed(commandBuffer, indexCount, instanceCount, range.firstIndex, static_cast<int32_t>(range.vertexOffset), firstInstance);
         }
         else {
-            vkCmdDraw(commandBuffer, vertexCount, 1, 0, 0);// the last 2 zeros because we aren't using any offsets in our data 
+            vkCmdDraw(commandBuffer, vertexCount, instanceCount, range.vertexOffset, firstInstance);
         }
     }
 
-    void NKModel::bind(VkCommandBuffer commandBuffer) {
-        //binding the buffers 
-        VkBuffer buffers[] = { vertexBuffer->getBuffer() };
-        VkDeviceSize offsets[] = { 0 };
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, buffers, offsets);
+    void NKModel::computeBounds(const std::vector<Vertex>& vertices) {
+        boundsMin = glm::vec3{ std::numeric_limits<float>::max() };
+        boundsMax = glm::vec3{ -std::numeric_limits<float>::max() };
+        for (const auto& vertex : vertices) {
+            boundsMin = glm::min(boundsMin, vertex.position);
+            boundsMax = glm::max(boundsMax, vertex.position);
+        }
 
-        if (hasIndexBuffer) {
-            vkCmdBindIndexBuffer(commandBuffer, indexBuffer->getBuffer(), 0, VK_INDEX_TYPE_UINT32);
+        //centered on the box, the radius reaches the furthest vertex so it is tighter than the box's corner 
+        glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+        float radiusSquared = 0.f;
+        for (const auto& vertex : vertices) {
+            glm::vec3 offset = vertex.position - center;
+            radiusSquared = std::max(radiusSquared, glm::dot(offset, offset));
         }
+        boundingSphere = glm::vec4{ center, std::sqrt(radiusSquared) };
+    }
+
+    void NKModel::computeChildBounds() {
+        //every placement of every child, the boxes' corners go through the node's world matrix 
+        boundsMin = glm::vec3{ std::numeric_limits<float>::max() };
+        boundsMax = glm::vec3{ -std::numeric_limits<float>::max() };
+        for (const auto& instance : sceneGraph.getMeshInstances()) {
+            const NKModel& child = *childModels[instance.mesh];
+            const glm::mat4& world = sceneGraph.getWorld(instance.node);
+            for (uint32_t corner = 0; corner < 8; ++corner) {
+                glm::vec3 position{
+                    (corner & 1) ? child.boundsMax.x : child.boundsMin.x,
+                    (corner & 2) ? child.boundsMax.y : child.boundsMin.y,
+                    (corner & 4) ? child.boundsMax.z : child.boundsMin.z };
+                position = glm::vec3(world * glm::vec4(position, 1.f));
+                boundsMin = glm::min(boundsMin, position);
+                boundsMax = glm::max(boundsMax, position);
+            }
+        }
+
+        glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+        float radius = 0.f;
+        for (const auto& instance : sceneGraph.getMeshInstances()) {
+            glm::vec4 sphere = NKFrustum::transformSphere(sceneGraph.getWorld(instance.node), childModels[instance.mesh]->boundingSphere);
+            radius = std::max(radius, glm::length(glm::vec3{ sphere } - center) + sphere.w);
+        }
+        boundingSphere = glm::vec4{ center, radius };
+    }
+
+    void NKModel::bind(VkCommandBuffer commandBuffer, NKGeometryBindState* bindState) {
+        //binding the shared buffers the model lives in 
+        m_modelDevice.getGeometryPool().bind(commandBuffer, geometry, bindState);
     }
 
     std::vector<VkVertexInputBindingDescription> NKModel::Vertex::getBindingDescriptions() {
@@ -186,6 +242,58 @@ namespace nekographics {
         return attributeDescriptions;
     }
 
+    //octahedral mapping of a unit vector onto [-1,1]^2
+    static glm::vec2 octahedralEncode(glm::vec3 v) {
+        float length = glm::abs(v.x) + glm::abs(v.y) + glm::abs(v.z);
+        if (length <= 0.f) {
+            return glm::vec2{ 0.f };//missing vector, decodes to +z 
+        }
+        v /= length;
+
+        glm::vec2 encoded{ v.x, v.y };
+        if (v.z < 0.f) {
+            //fold the lower hemisphere over the diagonals 
+            encoded = (1.f - glm::abs(glm::vec2{ v.y, v.x })) *
+                glm::vec2{ v.x >= 0.f ? 1.f : -1.f, v.y >= 0.f ? 1.f : -1.f };
+        }
+        return encoded;
+    }
+
+    NKModel::PackedVertex NKModel::PackedVertex::pack(const Vertex& vertex) {
+        PackedVertex packed{};
+        packed.position = vertex.position;
+        packed.normal = glm::packSnorm2x16(octahedralEncode(vertex.normal));
+
+        //shaders rebuild the bitangent as sign * cross(tangent, normal) 
+        float bitangentSign = glm::dot(glm::cross(vertex.tangent, vertex.normal), vertex.bitangent) < 0.f ? -1.f : 1.f;
+        packed.tangent = glm::packSnorm4x8(glm::vec4{ octahedralEncode(vertex.tangent), bitangentSign, 0.f });
+
+        packed.uv = glm::packHalf2x16(vertex.uv);
+        packed.color = glm::packUnorm4x8(glm::vec4{ glm::clamp(vertex.color, 0.f, 1.f), 1.f });
+        return packed;
+    }
+
+    std::vector<VkVertexInputBindingDescription> NKModel::PackedVertex::getBindingDescriptions() {
+        std::vector<VkVertexInputBindingDescription> bindingDescriptions(1);
+        bindingDescriptions[0].binding = 0;
+        bindingDescriptions[0].stride = sizeof(PackedVertex);
+        bindingDescriptions[0].inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+        return bindingDescriptions;
+    }
+
+    std::vector<VkVertexInputAttributeDescription> NKModel::PackedVertex::getAttributeDescriptions() {
+        std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
+
+        //every format here is mandatory for vertex buffers 
+        attributeDescriptions.push_back({ 0, 0, VK_FORMAT_R32G32B32_SFLOAT, offsetof(PackedVertex, position) });
+        attributeDescriptions.push_back({ 1, 0, VK_FORMAT_R16G16_SNORM,     offsetof(PackedVertex, normal) });
+        attributeDescriptions.push_back({ 2, 0, VK_FORMAT_R8G8B8A8_SNORM,   offsetof(PackedVertex, tangent) });
+        attributeDescriptions.push_back({ 3, 0, VK_FORMAT_R16G16_SFLOAT,    offsetof(PackedVertex, uv) });
+        attributeDescriptions.push_back({ 4, 0, VK_FORMAT_R8G8B8A8_UNORM,   offsetof(PackedVertex, color) });
+
+        return attributeDescriptions;
+    }
+
 
 
     void NKModel::Builder::loadModel(const std::string& filepath) {
@@ -245,6 +353,10 @@ namespace nekographics {
                 indices.push_back(uniqueVertices[vertex]);//push back the indices 
             }
         }
+
+        if (optimizeMesh) {
+            optimize(filepath);
+        }
     }
 
     void NKModel::Builder::loadMesh(xprim_geom::mesh pMesh) {
@@ -329,13 +441,22 @@ namespace nekographics {
             vertices[i].position = { pMesh.m_Vertices[i].m_Position.m_X,pMesh.m_Vertices[i].m_Position.m_Y,pMesh.m_Vertices[i].m_Position.m_Z };
             vertices[i].uv = { pMesh.m_Vertices[i].m_Texcoord.m_X,pMesh.m_Vertices[i].m_Texcoord.m_Y};
         }
+
+        if (optimizeMesh) {
+            optimize("xprim_geom mesh");
+        }
+    }
+
+    void NKModel::Builder::optimize(const std::string& name) {
+        optimizeStats = NKMeshOptimizer::optimize(vertices, indices);//cache order, overdraw, then fetch order 
+        NKMeshOptimizer::printStats(name, optimizeStats);
     }
 
     //helper function for assimpmodel
 
     NKModel::Mesh  NKModel::AssimpBuilder::processMesh(aiMesh* mesh, const aiScene* scene) {
 
-        UNREFERENCED_PARAMETER(scene);
+        (void)scene;
 
         // Data to fill
         std::vector<Vertex>			Vertices;
@@ -402,17 +523,48 @@ namespace nekographics {
             for (auto j = 0u; j < Face.mNumIndices; ++j)
                 Indices.push_back(Face.mIndices[j]);
         }
+
+        if (optimizeMesh) {
+            optimizeStats.push_back(NKMeshOptimizer::optimize(Vertices, Indices));
+            NKMeshOptimizer::printStats(mesh->mName.C_Str(), optimizeStats.back());
+        }
         return Mesh(Vertices, Indices);
     }
 
-    void NKModel::AssimpBuilder::processNode(aiNode* node, const aiScene* scene) {
-        for (unsigned int i = 0; i < node->mNumMeshes; i++) {
-            aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-            meshes.push_back(processMesh(mesh, scene));
+    void NKModel::AssimpBuilder::processNodes(const aiScene* scene) {
+        //every mesh once, the nodes refer to them by index so repeated parts share their vertices 
+        for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+            meshes.push_back(processMesh(scene->mMeshes[i], scene));
         }
-        for (unsigned int i = 0; i < node->mNumChildren; i++) {
-            processNode(node->mChildren[i], scene);
+
+        //processMesh negates y, conjugating every node matrix with the same flip keeps them in that space 
+        glm::mat4 flipY{ 1.f };
+        flipY[1][1] = -1.f;
+
+        //a queue gives breadth first order, each node is added after its parent 
+        std::queue<std::pair<const aiNode*, uint32_t>> pending;
+        pending.push({ scene->mRootNode, NKSceneGraph::NO_PARENT });
+        while (!pending.empty()) {
+            auto [node, parent] = pending.front();
+            pending.pop();
+
+            //aiMatrix4x4 is row major 
+            const aiMatrix4x4& m = node->mTransformation;
+            glm::mat4 local{
+                { m.a1, m.b1, m.c1, m.d1 },
+                { m.a2, m.b2, m.c2, m.d2 },
+                { m.a3, m.b3, m.c3, m.d3 },
+                { m.a4, m.b4, m.c4, m.d4 } };
+            uint32_t index = sceneGraph.addNode(parent, flipY * local * flipY);
+
+            for (unsigned int i = 0; i < node->mNumMeshes; i++) {
+                sceneGraph.addMeshInstance(index, node->mMeshes[i]);
+            }
+            for (unsigned int i = 0; i < node->mNumChildren; i++) {
+                pending.push({ node->mChildren[i], index });
+            }
         }
+        sceneGraph.update();
     }
 
     void NKModel::AssimpBuilder::loadAssimpModel(const std::string& filepath) {
@@ -427,14 +579,13 @@ namespace nekographics {
             | aiProcess_JoinIdenticalVertices      // join identical vertices/ optimize indexing
             | aiProcess_RemoveRedundantMaterials   // remove redundant materials
             | aiProcess_FindInvalidData            // detect invalid model data, such as invalid normal vectors
-            | aiProcess_PreTransformVertices       // pre-transform all vertices
             | aiProcess_FlipUVs                    // flip the V to match the Vulkans way of doing UVs
         );
         if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-            std::cout << "ERROR::ASSIMP:: " << importer.GetErrorString() << std::endl;
-            return;
+            //the loader hands this to whoever waits on the model's future 
+            throw std::runtime_error(std::string("failed to load model ") + filepath + ": " + importer.GetErrorString());
         }
-        processNode(scene->mRootNode, scene);
+        processNodes(scene);
     }
 
 
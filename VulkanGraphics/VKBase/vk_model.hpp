@@ -2,6 +2,8 @@
 
 #include "vk_device.hpp"
 #include "vk_buffer.hpp"
+#include "vk_meshoptimizer.hpp"
+#include "vk_scenegraph.hpp"
 #include "../meshes/xprim_geom.h"
 
 // libs
@@ -20,6 +22,15 @@
 namespace nekographics {
     class NKModel {
     public:
+        //meshes with up to this many vertices get a uint16 index buffer
+        static constexpr uint32_t MAX_UINT16_INDEXED_VERTICES = 65536;
+
+        //layout of the vertex buffer, picked per model
+        enum class VertexFormat {
+            Full,   //Vertex, 68 bytes of float32
+            Packed  //PackedVertex, 28 bytes, decoded in the *Packed.vert shaders
+        };
+
         //vertex 
         struct Vertex {
             glm::vec3 position{};
@@ -38,6 +49,27 @@ namespace nekographics {
             }
         };
 
+        /*
+        Quantized vertex, the bitangent is rebuilt in the shader from normal, tangent & a sign
+          position : R32G32B32_SFLOAT
+          normal   : R16G16_SNORM   octahedral
+          tangent  : R8G8B8A8_SNORM octahedral xy, z = bitangent sign
+          uv       : R16G16_SFLOAT
+          color    : R8G8B8A8_UNORM
+        */
+        struct PackedVertex {
+            glm::vec3 position{};
+            uint32_t normal = 0;
+            uint32_t tangent = 0;
+            uint32_t uv = 0;
+            uint32_t color = 0;
+
+            static PackedVertex pack(const Vertex& vertex);
+
+            static std::vector<VkVertexInputBindingDescription> getBindingDescriptions();
+            static std::vector<VkVertexInputAttributeDescription> getAttributeDescriptions();
+        };
+
         // mesh
         class Mesh {
         public:
@@ -53,17 +85,25 @@ namespace nekographics {
         struct Builder {
             std::vector<Vertex> vertices{};
             std::vector<uint32_t> indices{};
+            VertexFormat vertexFormat = VertexFormat::Full;
+            bool optimizeMesh = false;//reorder triangles & vertices for the gpu after loading
+            NKMeshOptimizeStats optimizeStats{};//filled in when optimizeMesh is set
 
             void loadModel(const std::string& filepath);
             void loadMesh(xprim_geom::mesh pMesh);
+            void optimize(const std::string& name);
             //void loadAssimpModel(const std::string& filepath);
         };
 
         struct AssimpBuilder {
-            std::vector<Mesh> meshes{};
+            std::vector<Mesh> meshes{};//one per aiMesh, meshes reused by several nodes are loaded once
+            NKSceneGraph sceneGraph{};//the node hierarchy of the file, placing the meshes
+            VertexFormat vertexFormat = VertexFormat::Full;
+            bool optimizeMesh = false;//reorder every mesh for the gpu after loading
+            std::vector<NKMeshOptimizeStats> optimizeStats{};//one per mesh when optimizeMesh is set
 
             Mesh processMesh(aiMesh* mesh, const aiScene* scene);
-            void processNode(aiNode* node, const aiScene* scene);
+            void processNodes(const aiScene* scene);//breadth first, parents before children
             void loadAssimpModel(const std::string& filepath);;
         };
 
@@ -75,38 +115,68 @@ namespace nekographics {
         NKModel& operator=(const NKModel&) = delete;
 
         static std::unique_ptr<NKModel> createModelFromFile(
-            NKDevice& device, const std::string& filepath);
+            NKDevice& device, const std::string& filepath, VertexFormat vertexFormat = VertexFormat::Full, bool optimizeMesh = false);
 
         static std::unique_ptr<NKModel> createAssimpModelFromFile(
-            NKDevice& device, const std::string& filepath);
+            NKDevice& device, const std::string& filepath, VertexFormat vertexFormat = VertexFormat::Full, bool optimizeMesh = false);
+
+        static std::unique_ptr<NKModel> processMesh(NKDevice& device, xprim_geom::mesh pMesh, VertexFormat vertexFormat = VertexFormat::Full, bool optimizeMesh = false);//processing the custom mesh 
+
 
-        static std::unique_ptr<NKModel> processMesh(NKDevice& device, xprim_geom::mesh pMesh);//processing the custom mesh 
+        //pass one bind state to every bind of a pass to skip rebinding the shared buffers
+        void bind(VkCommandBuffer commandBuffer, NKGeometryBindState* bindState = nullptr);
+        //firstInstance offsets gl_InstanceIndex, used to index per instance data
+        void draw(VkCommandBuffer commandBuffer, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
 
+        //where the vertices & indices live in the device's geometry pool, empty for models with children
+        NKGeometryHandle getGeometry() const { return geometry; }
+        const NKGeometryRange& getGeometryRange() const { return m_modelDevice.getGeometryPool().getRange(geometry); }
 
-        void bind(VkCommandBuffer commandBuffer);
-        void draw(VkCommandBuffer commandBuffer);
+        //pipelines have to be created with the matching vertex input descriptions
+        VertexFormat getVertexFormat() const { return vertexFormat; }
 
-        //getting child models 
+        //VK_INDEX_TYPE_UINT16 for small meshes, picked when the index buffer is created
+        VkIndexType getIndexType() const { return indexType; }
+        bool getHasIndexBuffer() const { return hasIndexBuffer; }
+
+        //object space bounds of the vertices, models with children cover every child 
+        const glm::vec3& getBoundsMin() const { return boundsMin; }
+        const glm::vec3& getBoundsMax() const { return boundsMax; }
+        const glm::vec4& getBoundingSphere() const { return boundingSphere; }//xyz center, w radius 
+
+        //false while the vertex/index uploads are still streaming in, skip drawing until then
+        bool isReady() const { return m_modelDevice.getUploadManager().isComplete(uploadTicket); }
+
+        //getting child models, the unique meshes of the file. The scene graph's mesh instances place them 
         bool getHasChildModels() const { return hasChildModels; }
         std::vector<std::unique_ptr<NKModel>>& getChildModels() { return childModels; }
+        const NKSceneGraph& getSceneGraph() const { return sceneGraph; }
 
     private:
         void createVertexBuffers(const std::vector<Vertex>& vertices);
         void createIndexBuffers(const std::vector<uint32_t>& indices);
+        void computeBounds(const std::vector<Vertex>& vertices);
+        void computeChildBounds();
 
         NKDevice& m_modelDevice;//reference to the device 
 
-        //vertex buffer 
-        std::unique_ptr<NKBuffer> vertexBuffer;
+        //vertices & indices, suballocated from the geometry pool 
+        NKGeometryHandle geometry = NK_INVALID_GEOMETRY;
+        VertexFormat vertexFormat = VertexFormat::Full;
         uint32_t vertexCount;
 
-        //index buffer 
         bool hasIndexBuffer = false;
-        std::unique_ptr<NKBuffer> indexBuffer;
         uint32_t indexCount;
+        VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+
+        glm::vec3 boundsMin{ 0.f };
+        glm::vec3 boundsMax{ 0.f };
+        glm::vec4 boundingSphere{ 0.f };
 
+        uint64_t uploadTicket = 0;//upload batch holding this model & its children
 
         bool hasChildModels = false;
         std::vector<std::unique_ptr<NKModel>> childModels;//stores all the child models 
+        NKSceneGraph sceneGraph;//empty for models without children 
     };
 }
@@ -0,0 +1,129 @@
+//includes
+#include "vk_modelloader.hpp"
+
+// std
+#include <algorithm>
+
+namespace nekographics {
+
+    NKModelLoader::NKModelLoader(NKDevice& loaderDevice, uint32_t workerCount) : device{ loaderDevice } {
+        if (workerCount == 0) {
+            workerCount = std::max(2u, std::thread::hardware_concurrency()) - 1;//leave the main thread a core
+        }
+
+        for (uint32_t i = 0; i < workerCount; ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    NKModelLoader::~NKModelLoader() {
+        {
+            std::lock_guard<std::mutex> lock{ jobMutex };
+            stopping = true;
+        }
+        jobCondition.notify_all();
+
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    NKModelFuture NKModelLoader::loadAssimpModel(const std::string& filepath, NKModel::VertexFormat vertexFormat, bool optimizeMesh) {
+        return enqueue([this, filepath, vertexFormat, optimizeMesh] {
+            auto builder = std::make_shared<NKModel::AssimpBuilder>();
+            builder->vertexFormat = vertexFormat;
+            builder->optimizeMesh = optimizeMesh;//runs on the worker with the parse 
+            builder->loadAssimpModel(filepath);
+            return std::function<std::unique_ptr<NKModel>()>{ [this, builder] { return std::make_unique<NKModel>(device, *builder); } };
+        });
+    }
+
+    NKModelFuture NKModelLoader::loadObjModel(const std::string& filepath, NKModel::VertexFormat vertexFormat, bool optimizeMesh) {
+        return enqueue([this, filepath, vertexFormat, optimizeMesh] {
+            auto builder = std::make_shared<NKModel::Builder>();
+            builder->vertexFormat = vertexFormat;
+            builder->optimizeMesh = optimizeMesh;//runs on the worker with the parse 
+            builder->loadModel(filepath);
+            return std::function<std::unique_ptr<NKModel>()>{ [this, builder] { return std::make_unique<NKModel>(device, *builder); } };
+        });
+    }
+
+    NKModelFuture NKModelLoader::enqueue(std::function<std::function<std::unique_ptr<NKModel>()>()> parse) {
+        auto load = std::make_shared<Load>();
+        NKModelFuture future = load->promise.get_future().share();
+        pendingLoads++;
+
+        {
+            std::lock_guard<std::mutex> lock{ jobMutex };
+            jobs.emplace_back([this, load, parse = std::move(parse)] {
+                //parse errors are handed back through the future
+                try {
+                    load->create = parse();
+                }
+                catch (...) {
+                    load->error = std::current_exception();
+                }
+
+                {
+                    std::lock_guard<std::mutex> parsedLock{ parsedMutex };
+                    parsed.push_back(load);
+                }
+                parsedCondition.notify_all();
+            });
+        }
+        jobCondition.notify_one();
+
+        return future;
+    }
+
+    void NKModelLoader::workerLoop() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lock{ jobMutex };
+                jobCondition.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping) {
+                    return;
+                }
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            job();
+        }
+    }
+
+    void NKModelLoader::update() {
+        std::vector<std::shared_ptr<Load>> finished;
+        {
+            std::lock_guard<std::mutex> lock{ parsedMutex };
+            finished.swap(parsed);
+        }
+
+        //buffer creation & staging stay on this thread, the upload manager is not thread safe
+        for (auto& load : finished) {
+            if (load->error) {
+                load->promise.set_exception(load->error);
+            }
+            else {
+                try {
+                    load->promise.set_value(std::shared_ptr<NKModel>{ load->create() });
+                }
+                catch (...) {
+                    load->promise.set_exception(std::current_exception());
+                }
+            }
+            pendingLoads--;
+        }
+    }
+
+    void NKModelLoader::waitAll() {
+        while (pendingLoads.load() > 0) {
+            {
+                std::unique_lock<std::mutex> lock{ parsedMutex };
+                parsedCondition.wait(lock, [this] { return !parsed.empty(); });
+            }
+            update();
+        }
+    }
+
+}  // namespace lve
@@ -0,0 +1,75 @@
+#pragma once
+
+#include "vk_model.hpp"
+
+// std
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace nekographics {
+
+    using NKModelFuture = std::shared_future<std::shared_ptr<NKModel>>;
+
+    /*
+    Loads models in the background. File parsing & vertex conversion run on worker threads,
+    update() on the main thread turns every finished parse into an NKModel whose buffers go
+    through the batched upload path, then fulfils the future. Nothing blocks on the gpu.
+    */
+    class NKModelLoader {
+    public:
+        //workerCount 0 picks one less than the hardware threads
+        NKModelLoader(NKDevice& device, uint32_t workerCount = 0);
+        ~NKModelLoader();
+
+        NKModelLoader(const NKModelLoader&) = delete;
+        NKModelLoader& operator=(const NKModelLoader&) = delete;
+
+        //assimp formats (fbx, gltf, ...)
+        NKModelFuture loadAssimpModel(const std::string& filepath, NKModel::VertexFormat vertexFormat = NKModel::VertexFormat::Full, bool optimizeMesh = false);
+
+        //tinyobj
+        NKModelFuture loadObjModel(const std::string& filepath, NKModel::VertexFormat vertexFormat = NKModel::VertexFormat::Full, bool optimizeMesh = false);
+
+        //creates the models of every finished parse, call once per frame from the main thread
+        void update();
+
+        //blocks until every queued file is parsed & created
+        void waitAll();
+
+        //files queued or being parsed, plus parsed ones waiting for update()
+        uint32_t pendingCount() const { return pendingLoads.load(); }
+
+    private:
+        struct Load {
+            std::promise<std::shared_ptr<NKModel>> promise;
+            std::function<std::unique_ptr<NKModel>()> create;//set by the worker, run on the main thread
+            std::exception_ptr error;
+        };
+
+        NKModelFuture enqueue(std::function<std::function<std::unique_ptr<NKModel>()>()> parse);
+        void workerLoop();
+
+        NKDevice& device;
+
+        std::vector<std::thread> workers;
+        std::deque<std::function<void()>> jobs;
+        std::mutex jobMutex;
+        std::condition_variable jobCondition;
+        bool stopping = false;
+
+        std::vector<std::shared_ptr<Load>> parsed;//finished on a worker, waiting for update()
+        std::mutex parsedMutex;
+        std::condition_variable parsedCondition;
+
+        std::atomic<uint32_t> pendingLoads{ 0 };
+    };
+
+}  // namespace lve
@@ -1,5 +1,6 @@
 #include "vk_pipeline.hpp"
 #include "vk_model.hpp"
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <assert.h>
@@ -12,7 +13,23 @@ namespace nekographics {
         const std::string& fragFilepath,
         const PipelineConfigInfo& configInfo)
         : m_vkdevice{ device } {
-        createGraphicsPipeline(vertFilepath, fragFilepath, configInfo);//creating the pipeline 
+        auto vertCode = readFile(vertFilepath);
+        auto fragCode = readFile(fragFilepath);
+
+        //creating the shader module 
+        createShaderModule(vertCode, &vertShaderModule);
+        createShaderModule(fragCode, &fragShaderModule);
+
+        createGraphicsPipeline(configInfo);//creating the pipeline 
+    }
+
+    NKPipeline::NKPipeline(
+        NKDevice& device,
+        VkShaderModule vertModule,
+        VkShaderModule fragModule,
+        const PipelineConfigInfo& configInfo)
+        : m_vkdevice{ device }, vertShaderModule{ vertModule }, fragShaderModule{ fragModule }, ownsShaderModules{ false } {
+        createGraphicsPipeline(configInfo);
     }
 
     std::vector<char> NKPipeline::readFile(const std::string& filename) {
@@ -33,10 +50,7 @@ namespace nekographics {
         return buffer;
     }
 
-    void NKPipeline::createGraphicsPipeline(
-        const std::string& vertFilepath,
-        const std::string& fragFilepath,
-        const PipelineConfigInfo& configInfo) {
+    void NKPipeline::createGraphicsPipeline(const PipelineConfigInfo& configInfo) {
         assert(
             configInfo.pipelineLayout != VK_NULL_HANDLE &&
             "Cannot create graphics pipeline: no pipelineLayout provided in configInfo");
@@ -44,14 +58,6 @@ namespace nekographics {
             configInfo.renderPass != VK_NULL_HANDLE &&
             "Cannot create graphics pipeline: no renderPass provided in configInfo");
 
-        auto vertCode = readFile(vertFilepath);
-        auto fragCode = readFile(fragFilepath);
-
-
-        //creating the shader module 
-        createShaderModule(vertCode, &vertShaderModule);
-        createShaderModule(fragCode, &fragShaderModule);
-
         //for the vertex shader 
         VkPipelineShaderStageCreateInfo shaderStages[2];
         shaderStages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -71,8 +77,9 @@ namespace nekographics {
         shaderStages[1].pNext = nullptr;//customize shader functionality 
         shaderStages[1].pSpecializationInfo = nullptr;
 
-        auto bindingDescriptions = NKModel::Vertex::getBindingDescriptions();
-        auto attributeDescriptions = NKModel::Vertex::getAttributeDescriptions();
+        //vertex layout comes from the config so packed vertices & vertexless pipelines work 
+        auto& bindingDescriptions = configInfo.bindingDescriptions;
+        auto& attributeDescriptions = configInfo.attributeDescriptions;
 
         //creating out vertex input state object
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
@@ -105,16 +112,19 @@ namespace nekographics {
         pipelineInfo.basePipelineIndex = -1;
         pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-        //creating the graphics pipeline 
+        //creating the graphics pipeline, a warm cache skips the shader compilation 
+        auto startTime = std::chrono::high_resolution_clock::now();
         if (vkCreateGraphicsPipelines(
             m_vkdevice.device(),
-            VK_NULL_HANDLE,
+            m_vkdevice.pipelineCache(),
             1,
             &pipelineInfo,
             nullptr,
             &graphicsPipeline) != VK_SUCCESS) {
             throw std::runtime_error("failed to create graphics pipeline");
         }
+        m_vkdevice.recordPipelineCreation(std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - startTime).count());
     }
 
     void NKPipeline::createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule) {
@@ -131,8 +141,10 @@ namespace nekographics {
 
     NKPipeline::~NKPipeline() {
         //destroying the shader module & pipeline 
-        vkDestroyShaderModule(m_vkdevice.device(), fragShaderModule, nullptr);
-        vkDestroyShaderModule(m_vkdevice.device(), vertShaderModule, nullptr);
+        if (ownsShaderModules) {
+            vkDestroyShaderModule(m_vkdevice.device(), fragShaderModule, nullptr);
+            vkDestroyShaderModule(m_vkdevice.device(), vertShaderModule, nullptr);
+        }
         vkDestroyPipeline(m_vkdevice.device(), graphicsPipeline, nullptr);
     }
 
@@ -230,4 +242,72 @@ namespace nekographics {
         configInfo.bindingDescriptions = NKModel::Vertex::getBindingDescriptions();
         configInfo.attributeDescriptions = NKModel::Vertex::getAttributeDescriptions();
     }
+
+    NKComputePipeline::NKComputePipeline(
+        NKDevice& device,
+        const std::string& compFilepath,
+        VkPipelineLayout pipelineLayout)
+        : m_vkdevice{ device } {
+        auto compCode = NKPipeline::readFile(compFilepath);
+
+        VkShaderModuleCreateInfo moduleInfo{};
+        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        moduleInfo.codeSize = compCode.size();
+        moduleInfo.pCode = reinterpret_cast<const uint32_t*>(compCode.data());
+
+        if (vkCreateShaderModule(m_vkdevice.device(), &moduleInfo, nullptr, &compShaderModule) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create shader module");
+        }
+
+        createComputePipeline(pipelineLayout);
+    }
+
+    NKComputePipeline::NKComputePipeline(
+        NKDevice& device,
+        VkShaderModule compModule,
+        VkPipelineLayout pipelineLayout)
+        : m_vkdevice{ device }, compShaderModule{ compModule }, ownsShaderModule{ false } {
+        createComputePipeline(pipelineLayout);
+    }
+
+    void NKComputePipeline::createComputePipeline(VkPipelineLayout pipelineLayout) {
+        assert(
+            pipelineLayout != VK_NULL_HANDLE &&
+            "Cannot create compute pipeline: no pipelineLayout provided");
+
+        //a compute pipeline is just the one shader stage & its layout 
+        VkComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+        pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+        pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+        pipelineInfo.stage.module = compShaderModule;
+        pipelineInfo.stage.pName = "main";//the entry function
+        pipelineInfo.layout = pipelineLayout;
+        pipelineInfo.basePipelineIndex = -1;
+        pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+
+        auto startTime = std::chrono::high_resolution_clock::now();
+        if (vkCreateComputePipelines(
+            m_vkdevice.device(),
+            m_vkdevice.pipelineCache(),
+            1,
+            &pipelineInfo,
+            nullptr,
+            &computePipeline) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create compute pipeline");
+        }
+        m_vkdevice.recordPipelineCreation(std::chrono::duration<float, std::chrono::milliseconds::period>(
+            std::chrono::high_resolution_clock::now() - startTime).count());
+    }
+
+    NKComputePipeline::~NKComputePipeline() {
+        if (ownsShaderModule) {
+            vkDestroyShaderModule(m_vkdevice.device(), compShaderModule, nullptr);
+        }
+        vkDestroyPipeline(m_vkdevice.device(), computePipeline, nullptr);
+    }
+
+    void NKComputePipeline::bind(VkCommandBuffer commandBuffer) {
+        vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, computePipeline);
+    }
 }
@@ -46,6 +46,13 @@ namespace nekographics {
 			const std::string& fragFilepath, 
 			const PipelineConfigInfo& configInfo);
 
+		//shader modules shared through NKPipelineRegistry, they stay owned by the caller 
+		NKPipeline(
+			NKDevice& device,
+			VkShaderModule vertShaderModule,
+			VkShaderModule fragShaderModule,
+			const PipelineConfigInfo& configInfo);
+
 		~NKPipeline();
 
 		NKPipeline(const NKPipeline&) = delete;
@@ -56,9 +63,12 @@ namespace nekographics {
 		static void defaultPipelineConfigInfo(PipelineConfigInfo& configInfo);//the default pipeline config info
 
 	private:
+		friend class NKComputePipeline;//shares the shader file loading 
+		friend class NKPipelineRegistry;
+
 		static std::vector<char> readFile(const std::string& filepath);
 
-		void createGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath,const PipelineConfigInfo& configInfo);
+		void createGraphicsPipeline(const PipelineConfigInfo& configInfo);
 
 		void createShaderModule(const std::vector<char>& code, VkShaderModule* shaderModule);
 
@@ -66,5 +76,36 @@ namespace nekographics {
 		VkPipeline graphicsPipeline;
 		VkShaderModule vertShaderModule;
 		VkShaderModule fragShaderModule;
+		bool ownsShaderModules = true;//false when they came from the registry 
+	};
+
+	//a single compute shader, the layout belongs to the system dispatching it 
+	class NKComputePipeline {
+	public:
+		NKComputePipeline(
+			NKDevice& device,
+			const std::string& compFilepath,
+			VkPipelineLayout pipelineLayout);
+
+		//shader module shared through NKPipelineRegistry, it stays owned by the caller 
+		NKComputePipeline(
+			NKDevice& device,
+			VkShaderModule compShaderModule,
+			VkPipelineLayout pipelineLayout);
+
+		~NKComputePipeline();
+
+		NKComputePipeline(const NKComputePipeline&) = delete;
+		NKComputePipeline& operator=(const NKComputePipeline&) = delete;
+
+		void bind(VkCommandBuffer commandBuffer);
+
+	private:
+		void createComputePipeline(VkPipelineLayout pipelineLayout);
+
+		NKDevice& m_vkdevice;
+		VkPipeline computePipeline;
+		VkShaderModule compShaderModule;
+		bool ownsShaderModule = true;
 	};
 }  // namespace lve
@@ -0,0 +1,222 @@
+#include "vk_pipelineregistry.hpp"
+#include "vk_jobsystem.hpp"
+
+// std
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace nekographics {
+
+    namespace {
+        //plain vulkan structs without pNext chains, appended byte for byte
+        template <typename T>
+        void appendState(std::string& key, const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>, "Only plain state goes into a pipeline key");
+            key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        void appendStates(std::string& key, const std::vector<T>& values) {
+            appendState(key, static_cast<uint32_t>(values.size()));
+            for (const auto& value : values) {
+                appendState(key, value);
+            }
+        }
+    }
+
+    NKPipelineRegistry::NKPipelineRegistry(NKDevice& registryDevice) : device{ registryDevice } {}
+
+    NKPipelineRegistry::~NKPipelineRegistry() {
+        graphicsPipelines.clear();
+        computePipelines.clear();
+        for (auto& [file, shaderModule] : shaderModules) {
+            vkDestroyShaderModule(device.device(), shaderModule, nullptr);
+        }
+    }
+
+    std::string NKPipelineRegistry::makeGraphicsKey(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo) {
+        //the shader files, then every field of the config vkCreateGraphicsPipelines reads
+        std::string key;
+        key.reserve(512);
+        key.append(vertFilepath).push_back('\0');
+        key.append(fragFilepath).push_back('\0');
+
+        appendStates(key, configInfo.bindingDescriptions);
+        appendStates(key, configInfo.attributeDescriptions);
+
+        appendState(key, configInfo.inputAssemblyInfo.topology);
+        appendState(key, configInfo.inputAssemblyInfo.primitiveRestartEnable);
+
+        appendState(key, configInfo.viewportInfo.viewportCount);
+        appendState(key, configInfo.viewportInfo.scissorCount);
+
+        const auto& rasterization = configInfo.rasterizationInfo;
+        appendState(key, rasterization.depthClampEnable);
+        appendState(key, rasterization.rasterizerDiscardEnable);
+        appendState(key, rasterization.polygonMode);
+        appendState(key, rasterization.cullMode);
+        appendState(key, rasterization.frontFace);
+        appendState(key, rasterization.depthBiasEnable);
+        appendState(key, rasterization.depthBiasConstantFactor);
+        appendState(key, rasterization.depthBiasClamp);
+        appendState(key, rasterization.depthBiasSlopeFactor);
+        appendState(key, rasterization.lineWidth);
+
+        const auto& multisample = configInfo.multisampleInfo;
+        appendState(key, multisample.rasterizationSamples);
+        appendState(key, multisample.sampleShadingEnable);
+        appendState(key, multisample.minSampleShading);
+        appendState(key, multisample.alphaToCoverageEnable);
+        appendState(key, multisample.alphaToOneEnable);
+
+        //pAttachments points at colorBlendAttachment
+        const auto& colorBlend = configInfo.colorBlendInfo;
+        appendState(key, colorBlend.logicOpEnable);
+        appendState(key, colorBlend.logicOp);
+        appendState(key, colorBlend.blendConstants);
+        appendState(key, colorBlend.attachmentCount);
+        for (uint32_t i = 0; i < colorBlend.attachmentCount; ++i) {
+            appendState(key, colorBlend.pAttachments[i]);
+        }
+
+        const auto& depthStencil = configInfo.depthStencilInfo;
+        appendState(key, depthStencil.depthTestEnable);
+        appendState(key, depthStencil.depthWriteEnable);
+        appendState(key, depthStencil.depthCompareOp);
+        appendState(key, depthStencil.depthBoundsTestEnable);
+        appendState(key, depthStencil.stencilTestEnable);
+        appendState(key, depthStencil.front);
+        appendState(key, depthStencil.back);
+        appendState(key, depthStencil.minDepthBounds);
+        appendState(key, depthStencil.maxDepthBounds);
+
+        appendStates(key, configInfo.dynamicStateEnables);
+
+        appendState(key, configInfo.pipelineLayout);
+        appendState(key, configInfo.renderPass);
+        appendState(key, configInfo.subpass);
+        return key;
+    }
+
+    VkShaderModule NKPipelineRegistry::getShaderModule(const std::string& filepath) {
+        auto found = shaderModules.find(filepath);
+        if (found != shaderModules.end()) {
+            return found->second;
+        }
+
+        auto code = NKPipeline::readFile(filepath);
+
+        VkShaderModuleCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        createInfo.codeSize = code.size();
+        createInfo.pCode = reinterpret_cast<const uint32_t*>(code.data());
+
+        VkShaderModule shaderModule;
+        if (vkCreateShaderModule(device.device(), &createInfo, nullptr, &shaderModule) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create shader module");
+        }
+        shaderModules.emplace(filepath, shaderModule);
+        return shaderModule;
+    }
+
+    NKPipeline* NKPipelineRegistry::getGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo) {
+        std::string key = makeGraphicsKey(vertFilepath, fragFilepath, configInfo);
+
+        std::lock_guard<std::mutex> lock{ mutex };
+        auto found = graphicsPipelines.find(key);
+        if (found != graphicsPipelines.end()) {
+            return found->second.pipeline.get();
+        }
+
+        auto pipeline = std::make_unique<NKPipeline>(device, getShaderModule(vertFilepath), getShaderModule(fragFilepath), configInfo);
+        NKPipeline* result = pipeline.get();
+        graphicsPipelines.emplace(std::move(key), Entry<NKPipeline>{ std::move(pipeline), configInfo.pipelineLayout });
+        return result;
+    }
+
+    NKComputePipeline* NKPipelineRegistry::getComputePipeline(const std::string& compFilepath, VkPipelineLayout pipelineLayout) {
+        std::string key = compFilepath;
+        key.push_back('\0');
+        appendState(key, pipelineLayout);
+
+        std::lock_guard<std::mutex> lock{ mutex };
+        auto found = computePipelines.find(key);
+        if (found != computePipelines.end()) {
+            return found->second.pipeline.get();
+        }
+
+        auto pipeline = std::make_unique<NKComputePipeline>(device, getShaderModule(compFilepath), pipelineLayout);
+        NKComputePipeline* result = pipeline.get();
+        computePipelines.emplace(std::move(key), Entry<NKComputePipeline>{ std::move(pipeline), pipelineLayout });
+        return result;
+    }
+
+    void NKPipelineRegistry::precompile(const std::vector<NKGraphicsPipelineDesc>& pipelines, NKJobSystem* jobSystem) {
+        struct Pending {
+            std::string key;
+            const NKGraphicsPipelineDesc* desc;
+            VkShaderModule vertShaderModule;
+            VkShaderModule fragShaderModule;
+            std::unique_ptr<NKPipeline> pipeline;
+        };
+
+        //the misses & their shader modules, file loading stays on this thread
+        std::vector<Pending> pending;
+        {
+            std::lock_guard<std::mutex> lock{ mutex };
+            for (const auto& desc : pipelines) {
+                assert(desc.configInfo != nullptr && "Declared pipeline without a config");
+                std::string key = makeGraphicsKey(desc.vertFilepath, desc.fragFilepath, *desc.configInfo);
+                if (graphicsPipelines.count(key) != 0) continue;
+
+                bool declaredTwice = false;
+                for (const auto& other : pending) {
+                    declaredTwice = declaredTwice || other.key == key;
+                }
+                if (declaredTwice) continue;
+
+                pending.push_back({ std::move(key), &desc, getShaderModule(desc.vertFilepath), getShaderModule(desc.fragFilepath), nullptr });
+            }
+        }
+
+        //the driver compiles, the pipeline cache is internally synchronized so the creations can overlap
+        auto compile = [&pending, this](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                Pending& item = pending[i];
+                item.pipeline = std::make_unique<NKPipeline>(device, item.vertShaderModule, item.fragShaderModule, *item.desc->configInfo);
+            }
+        };
+        if (jobSystem) {
+            jobSystem->parallelFor(static_cast<uint32_t>(pending.size()), 1, compile);
+        }
+        else {
+            compile(0, static_cast<uint32_t>(pending.size()));
+        }
+
+        //a system may have created one of them meanwhile, the first one in wins
+        std::lock_guard<std::mutex> lock{ mutex };
+        for (auto& item : pending) {
+            VkPipelineLayout layout = item.desc->configInfo->pipelineLayout;
+            graphicsPipelines.emplace(std::move(item.key), Entry<NKPipeline>{ std::move(item.pipeline), layout });
+        }
+    }
+
+    void NKPipelineRegistry::releaseLayout(VkPipelineLayout pipelineLayout) {
+        std::lock_guard<std::mutex> lock{ mutex };
+        std::erase_if(graphicsPipelines, [pipelineLayout](const auto& entry) { return entry.second.layout == pipelineLayout; });
+        std::erase_if(computePipelines, [pipelineLayout](const auto& entry) { return entry.second.layout == pipelineLayout; });
+    }
+
+    uint32_t NKPipelineRegistry::getPipelineCount() {
+        std::lock_guard<std::mutex> lock{ mutex };
+        return static_cast<uint32_t>(graphicsPipelines.size() + computePipelines.size());
+    }
+
+    uint32_t NKPipelineRegistry::getShaderModuleCount() {
+        std::lock_guard<std::mutex> lock{ mutex };
+        return static_cast<uint32_t>(shaderModules.size());
+    }
+
+}  // namespace lve
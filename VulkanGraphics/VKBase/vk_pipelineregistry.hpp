@@ -0,0 +1,68 @@
+#pragma once
+
+#include "vk_pipeline.hpp"
+
+// std
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace nekographics {
+
+    class NKJobSystem;
+
+    //one pipeline a system will ask for, compiled ahead of time by NKPipelineRegistry::precompile
+    struct NKGraphicsPipelineDesc {
+        std::string vertFilepath;
+        std::string fragFilepath;
+        const PipelineConfigInfo* configInfo = nullptr;//only read during precompile
+    };
+
+    /*
+    Every pipeline of the device, keyed by the shader files & the PipelineConfigInfo state that ends up in
+    the VkPipeline. Asking for the same shaders & state again returns the pipeline created the first time,
+    whichever system asks. Shader modules are loaded once per file & shared by every pipeline using them.
+    The pipelines live until the layout they were created with is released.
+    */
+    class NKPipelineRegistry {
+    public:
+        NKPipelineRegistry(NKDevice& device);
+        ~NKPipelineRegistry();
+
+        NKPipelineRegistry(const NKPipelineRegistry&) = delete;
+        NKPipelineRegistry& operator=(const NKPipelineRegistry&) = delete;
+
+        //thread safe, creates the pipeline on a miss
+        NKPipeline* getGraphicsPipeline(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
+        NKComputePipeline* getComputePipeline(const std::string& compFilepath, VkPipelineLayout pipelineLayout);
+
+        //creates the missing pipelines of the set, split over the job system's threads when one is given
+        void precompile(const std::vector<NKGraphicsPipelineDesc>& pipelines, NKJobSystem* jobSystem = nullptr);
+
+        //destroys every pipeline created with the layout, call before destroying it so a reused handle never hits
+        void releaseLayout(VkPipelineLayout pipelineLayout);
+
+        uint32_t getPipelineCount();
+        uint32_t getShaderModuleCount();
+
+    private:
+        template <typename Pipeline>
+        struct Entry {
+            std::unique_ptr<Pipeline> pipeline;
+            VkPipelineLayout layout;
+        };
+
+        static std::string makeGraphicsKey(const std::string& vertFilepath, const std::string& fragFilepath, const PipelineConfigInfo& configInfo);
+        VkShaderModule getShaderModule(const std::string& filepath);//call with the mutex held
+
+        NKDevice& device;
+
+        std::mutex mutex;
+        std::unordered_map<std::string, VkShaderModule> shaderModules;//by file
+        std::unordered_map<std::string, Entry<NKPipeline>> graphicsPipelines;//by makeGraphicsKey
+        std::unordered_map<std::string, Entry<NKComputePipeline>> computePipelines;//by file & layout
+    };
+
+}  // namespace lve
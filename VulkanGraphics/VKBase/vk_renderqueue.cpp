@@ -0,0 +1,79 @@
+#include "vk_renderqueue.hpp"
+
+// std
+#include <array>
+#include <cstring>
+
+namespace nekographics {
+
+    namespace {
+        uint64_t field(uint32_t value, uint32_t bits) {
+            return static_cast<uint64_t>(value & ((1u << bits) - 1u));
+        }
+    }
+
+    uint64_t NKSortKey::make(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t geometry, uint32_t mesh, float viewDepth) {
+        uint64_t key = field(pass, PASS_BITS);
+        key = key << PIPELINE_BITS | field(pipeline, PIPELINE_BITS);
+        key = key << MATERIAL_BITS | field(material, MATERIAL_BITS);
+        key = key << GEOMETRY_BITS | field(geometry, GEOMETRY_BITS);
+        key = key << MESH_BITS | field(mesh, MESH_BITS);
+        key = key << DEPTH_BITS | quantizeDepth(viewDepth);
+        return key;
+    }
+
+    uint64_t NKSortKey::makeWide(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t geometry, uint32_t mesh) {
+        static_assert(MESH_BITS + DEPTH_BITS == 32, "A wide mesh fills the mesh & depth fields");
+        uint64_t key = field(pass, PASS_BITS);
+        key = key << PIPELINE_BITS | field(pipeline, PIPELINE_BITS);
+        key = key << MATERIAL_BITS | field(material, MATERIAL_BITS);
+        key = key << GEOMETRY_BITS | field(geometry, GEOMETRY_BITS);
+        key = key << (MESH_BITS + DEPTH_BITS) | mesh;
+        return key;
+    }
+
+    uint16_t NKSortKey::quantizeDepth(float viewDepth) {
+        if (!(viewDepth > 0.f)) {
+            return 0;//behind the camera or nan
+        }
+        uint32_t bits;
+        std::memcpy(&bits, &viewDepth, sizeof(bits));
+        return static_cast<uint16_t>(bits >> 16);
+    }
+
+    void NKRenderQueue::sort() {
+        const size_t count = entries.size();
+        if (count < 2) {
+            return;
+        }
+
+        //every byte's histogram in one read of the keys
+        std::array<std::array<uint32_t, 256>, 8> histograms{};
+        for (const auto& entry : entries) {
+            for (uint32_t byte = 0; byte < 8; ++byte) {
+                histograms[byte][(entry.key >> (byte * 8)) & 0xFF]++;
+            }
+        }
+
+        scratch.resize(count);
+        for (uint32_t byte = 0; byte < 8; ++byte) {
+            auto& histogram = histograms[byte];
+            if (histogram[(entries[0].key >> (byte * 8)) & 0xFF] == count) {
+                continue;//every key has the same byte here
+            }
+
+            uint32_t offset = 0;
+            for (auto& bucket : histogram) {
+                uint32_t bucketCount = bucket;
+                bucket = offset;
+                offset += bucketCount;
+            }
+
+            for (const auto& entry : entries) {
+                scratch[histogram[(entry.key >> (byte * 8)) & 0xFF]++] = entry;
+            }
+            entries.swap(scratch);
+        }
+    }
+
+}  // namespace lve
@@ -0,0 +1,62 @@
+#pragma once
+
+// std
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace nekographics {
+
+    /*
+    Draw order packed into 64 bits, the fields sort from the top down:
+      pass     :  4 bits  63..60
+      pipeline :  8 bits  59..52
+      material :  8 bits  51..44  descriptor set the draw needs
+      geometry : 12 bits  43..32  vertex buffer the mesh lives in
+      mesh     : 16 bits  31..16
+      depth    : 16 bits  15..0   front to back
+    Fields wider than their bits are masked. Sharing the bits of pipeline, material or geometry only
+    costs redundant binds, the mesh has to be unique though: items of one mesh are only adjacent, &
+    so only instanced together, while no other mesh sorts in between. Pass a dense per frame rank,
+    not a handle, & makeWide once there are more meshes than the field holds.
+    */
+    struct NKSortKey {
+        static constexpr uint32_t PASS_BITS = 4;
+        static constexpr uint32_t PIPELINE_BITS = 8;
+        static constexpr uint32_t MATERIAL_BITS = 8;
+        static constexpr uint32_t GEOMETRY_BITS = 12;
+        static constexpr uint32_t MESH_BITS = 16;
+        static constexpr uint32_t DEPTH_BITS = 16;
+
+        static uint64_t make(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t geometry, uint32_t mesh, float viewDepth);
+        //the mesh takes the mesh & depth fields, no depth order but room for any mesh rank
+        static uint64_t makeWide(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t geometry, uint32_t mesh);
+
+        //positive floats order like their bits, the top 16 keep the exponent & 7 bits of mantissa. Behind the camera is 0
+        static uint16_t quantizeDepth(float viewDepth);
+    };
+
+    //the draws of a frame as key & item index pairs, sorted without comparisons
+    class NKRenderQueue {
+    public:
+        struct Entry {
+            uint64_t key;
+            uint32_t item;//index into whatever the caller gathered the draws in
+        };
+
+        void clear() { entries.clear(); }
+        void reserve(size_t count) { entries.reserve(count); }
+        void push(uint64_t key, uint32_t item) { entries.push_back({ key, item }); }
+
+        //stable LSD radix sort, a byte per pass. Bytes every key has in common are skipped, unused fields cost nothing
+        void sort();
+
+        const std::vector<Entry>& getEntries() const { return entries; }
+        size_t size() const { return entries.size(); }
+
+    private:
+        std::vector<Entry> entries;
+        std::vector<Entry> scratch;//kept to skip the allocation
+    };
+
+}  // namespace lve
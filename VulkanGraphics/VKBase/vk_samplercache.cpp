@@ -0,0 +1,98 @@
+#include "vk_samplercache.hpp"
+#include "vk_device.hpp"
+
+// std
+#include <cassert>
+#include <stdexcept>
+#include <type_traits>
+
+namespace nekographics {
+
+    namespace {
+        template <typename T>
+        void appendState(std::string& key, const T& value) {
+            static_assert(std::is_trivially_copyable_v<T>, "Only plain state goes into a sampler key");
+            key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+    }
+
+    NKSamplerCache::NKSamplerCache(NKDevice& cacheDevice) : device{ cacheDevice } {}
+
+    NKSamplerCache::~NKSamplerCache() {
+        for (auto& [key, sampler] : samplers) {
+            vkDestroySampler(device.device(), sampler, nullptr);
+        }
+    }
+
+    std::string NKSamplerCache::makeKey(const VkSamplerCreateInfo& samplerInfo) {
+        //field by field, the padding between them is not guaranteed to be zeroed
+        std::string key;
+        key.reserve(64);
+        appendState(key, samplerInfo.flags);
+        appendState(key, samplerInfo.magFilter);
+        appendState(key, samplerInfo.minFilter);
+        appendState(key, samplerInfo.mipmapMode);
+        appendState(key, samplerInfo.addressModeU);
+        appendState(key, samplerInfo.addressModeV);
+        appendState(key, samplerInfo.addressModeW);
+        appendState(key, samplerInfo.mipLodBias);
+        appendState(key, samplerInfo.anisotropyEnable);
+        appendState(key, samplerInfo.maxAnisotropy);
+        appendState(key, samplerInfo.compareEnable);
+        appendState(key, samplerInfo.compareOp);
+        appendState(key, samplerInfo.minLod);
+        appendState(key, samplerInfo.maxLod);
+        appendState(key, samplerInfo.borderColor);
+        appendState(key, samplerInfo.unnormalizedCoordinates);
+        return key;
+    }
+
+    VkSampler NKSamplerCache::getSampler(const VkSamplerCreateInfo& samplerInfo) {
+        assert(samplerInfo.pNext == nullptr && "Sampler with a pNext chain can't be cached");
+        std::string key = makeKey(samplerInfo);
+
+        std::lock_guard<std::mutex> lock{ mutex };
+        ++requestCount;
+        auto found = samplers.find(key);
+        if (found != samplers.end()) {
+            return found->second;
+        }
+
+        VkSampler sampler;
+        if (vkCreateSampler(device.device(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create texture sampler!");
+        }
+        samplers.emplace(std::move(key), sampler);
+        return sampler;
+    }
+
+    VkSampler NKSamplerCache::getTextureSampler() {
+        VkSamplerCreateInfo samplerInfo{};
+        samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+        samplerInfo.magFilter = VK_FILTER_LINEAR;
+        samplerInfo.minFilter = VK_FILTER_LINEAR;
+        samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+        samplerInfo.anisotropyEnable = VK_TRUE;
+        samplerInfo.maxAnisotropy = device.properties.limits.maxSamplerAnisotropy;
+        samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+        samplerInfo.unnormalizedCoordinates = VK_FALSE;
+        samplerInfo.compareEnable = VK_FALSE;
+        samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
+        samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+        samplerInfo.maxLod = 1000;
+        return getSampler(samplerInfo);
+    }
+
+    uint32_t NKSamplerCache::getSamplerCount() {
+        std::lock_guard<std::mutex> lock{ mutex };
+        return static_cast<uint32_t>(samplers.size());
+    }
+
+    uint32_t NKSamplerCache::getRequestCount() {
+        std::lock_guard<std::mutex> lock{ mutex };
+        return requestCount;
+    }
+
+}  // namespace lve
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+// std
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace nekographics {
+
+    class NKDevice;
+
+    /*
+    Every sampler of the device, keyed by the VkSamplerCreateInfo it was created from. Samplers carry no
+    image, so every texture filtered the same way shares one instead of each creating its own, which keeps
+    the count far from maxSamplerAllocationCount & lets layouts bake them in as immutable samplers.
+    The samplers live as long as the device, callers never destroy them.
+    */
+    class NKSamplerCache {
+    public:
+        NKSamplerCache(NKDevice& device);
+        ~NKSamplerCache();
+
+        NKSamplerCache(const NKSamplerCache&) = delete;
+        NKSamplerCache& operator=(const NKSamplerCache&) = delete;
+
+        //thread safe, creates the sampler on a miss. pNext chains are not part of the key so they are not allowed
+        VkSampler getSampler(const VkSamplerCreateInfo& samplerInfo);
+
+        //linear, repeat & the device's max anisotropy, what the mip mapped textures are sampled with
+        VkSampler getTextureSampler();
+
+        uint32_t getSamplerCount();
+        uint32_t getRequestCount();//every getSampler call, hits included
+
+    private:
+        static std::string makeKey(const VkSamplerCreateInfo& samplerInfo);
+
+        NKDevice& device;
+        std::mutex mutex;
+        std::unordered_map<std::string, VkSampler> samplers;
+        uint32_t requestCount = 0;
+    };
+
+}  // namespace lve
@@ -0,0 +1,52 @@
+#include "vk_scenegraph.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+
+namespace nekographics {
+
+    uint32_t NKSceneGraph::addNode(uint32_t parent, const glm::mat4& local) {
+        uint32_t node = getNodeCount();
+        assert((parent == NO_PARENT || parent < node) && "Parents have to be added before their children");
+
+        parents.push_back(parent);
+        locals.push_back(local);
+        worlds.emplace_back(1.f);
+        worldNormals.emplace_back(1.f);
+        dirty.push_back(1);
+        firstDirty = std::min(firstDirty, node);
+        return node;
+    }
+
+    void NKSceneGraph::addMeshInstance(uint32_t node, uint32_t mesh) {
+        assert(node < getNodeCount() && "Mesh instance of a missing node");
+        meshInstances.push_back({ mesh, node });
+    }
+
+    void NKSceneGraph::setLocal(uint32_t node, const glm::mat4& local) {
+        locals[node] = local;
+        dirty[node] = 1;
+        firstDirty = std::min(firstDirty, node);
+    }
+
+    void NKSceneGraph::update() {
+        const uint32_t nodeCount = getNodeCount();
+
+        //a child is dirty when its parent is, the parent was already visited so the flag is up to date
+        for (uint32_t node = firstDirty; node < nodeCount; ++node) {
+            const uint32_t parent = parents[node];
+            if (parent != NO_PARENT && dirty[parent]) {
+                dirty[node] = 1;
+            }
+            if (!dirty[node]) continue;
+
+            worlds[node] = parent != NO_PARENT ? worlds[parent] * locals[node] : locals[node];
+            worldNormals[node] = glm::transpose(glm::inverse(glm::mat3(worlds[node])));
+        }
+
+        std::fill(dirty.begin() + firstDirty, dirty.end(), uint8_t{ 0 });
+        firstDirty = nodeCount;
+    }
+
+}  // namespace lve
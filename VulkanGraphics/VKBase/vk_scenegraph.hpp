@@ -0,0 +1,55 @@
+#pragma once
+
+// libs
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+
+// std
+#include <cstdint>
+#include <vector>
+
+namespace nekographics {
+
+    /*
+    Node hierarchy of a model stored breadth first, every parent sits before its children so the world
+    matrices are propagated with one forward pass over the arrays. Nodes reference meshes by index,
+    a mesh used by several nodes is stored once & drawn once per node.
+    */
+    class NKSceneGraph {
+    public:
+        static constexpr uint32_t NO_PARENT = ~0u;
+
+        //one draw of a mesh, placed by the world matrix of its node
+        struct MeshInstance {
+            uint32_t mesh;
+            uint32_t node;
+        };
+
+        //the parent has to be added first, which breadth first order guarantees. Returns the node index
+        uint32_t addNode(uint32_t parent, const glm::mat4& local);
+        void addMeshInstance(uint32_t node, uint32_t mesh);
+
+        //marks the node & everything below it, the world matrices change on the next update
+        void setLocal(uint32_t node, const glm::mat4& local);
+        void update();
+
+        uint32_t getNodeCount() const { return static_cast<uint32_t>(parents.size()); }
+        uint32_t getParent(uint32_t node) const { return parents[node]; }
+        const glm::mat4& getLocal(uint32_t node) const { return locals[node]; }
+        const glm::mat4& getWorld(uint32_t node) const { return worlds[node]; }//relative to the model, not the entity
+        const glm::mat3& getWorldNormal(uint32_t node) const { return worldNormals[node]; }
+        const std::vector<MeshInstance>& getMeshInstances() const { return meshInstances; }
+
+    private:
+        std::vector<uint32_t> parents;
+        std::vector<glm::mat4> locals;
+        std::vector<glm::mat4> worlds;
+        std::vector<glm::mat3> worldNormals;
+        std::vector<uint8_t> dirty;
+        uint32_t firstDirty = 0;//nothing before it changed since the last update
+
+        std::vector<MeshInstance> meshInstances;
+    };
+
+}  // namespace lve
@@ -0,0 +1,97 @@
+#include "vk_simdmath.hpp"
+
+// std
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define NK_SIMDMATH_SSE
+#endif
+
+namespace nekographics {
+
+    //pi/2 split in three so the reduction keeps its precision (Cody & Waite)
+    static constexpr float TWO_OVER_PI = 0.636619772367581f;
+    static constexpr float HALF_PI_HI = 1.5703125f;
+    static constexpr float HALF_PI_MID = 4.837512969970703125e-4f;
+    static constexpr float HALF_PI_LO = 7.54978995489188216e-8f;
+
+    //taylor coefficients, enough on [-pi/4, pi/4]
+    static constexpr float SIN_C1 = -1.66666667e-1f;
+    static constexpr float SIN_C2 = 8.33333333e-3f;
+    static constexpr float SIN_C3 = -1.98412698e-4f;
+    static constexpr float SIN_C4 = 2.75573192e-6f;
+    static constexpr float COS_C1 = -5.0e-1f;
+    static constexpr float COS_C2 = 4.16666667e-2f;
+    static constexpr float COS_C3 = -1.38888889e-3f;
+    static constexpr float COS_C4 = 2.48015873e-5f;
+
+    static void sinCosScalar(float angle, float& sine, float& cosine) {
+        const float quadrant = std::nearbyint(angle * TWO_OVER_PI);
+        const float r = ((angle - quadrant * HALF_PI_HI) - quadrant * HALF_PI_MID) - quadrant * HALF_PI_LO;
+        const float r2 = r * r;
+
+        const float s = r + r * r2 * (SIN_C1 + r2 * (SIN_C2 + r2 * (SIN_C3 + r2 * SIN_C4)));
+        const float c = 1.f + r2 * (COS_C1 + r2 * (COS_C2 + r2 * (COS_C3 + r2 * COS_C4)));
+
+        //quadrant 0: (s, c), 1: (c, -s), 2: (-s, -c), 3: (-c, s)
+        const int32_t q = static_cast<int32_t>(quadrant);
+        const bool swap = (q & 1) != 0;
+        sine = swap ? c : s;
+        cosine = swap ? s : c;
+        if ((q & 2) != 0) sine = -sine;
+        if (((q + 1) & 2) != 0) cosine = -cosine;
+    }
+
+    void sinCosBatch(const float* angles, float* sines, float* cosines, size_t count) {
+        size_t i = 0;
+
+#if defined(NK_SIMDMATH_SSE)
+        const __m128 twoOverPi = _mm_set1_ps(TWO_OVER_PI);
+        const __m128 signBit = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int32_t>(0x80000000u)));
+        const __m128i one = _mm_set1_epi32(1);
+        const __m128i two = _mm_set1_epi32(2);
+
+        for (; i + 4 <= count; i += 4) {
+            __m128 angle = _mm_loadu_ps(angles + i);
+
+            //rounds to nearest with the default rounding mode
+            __m128i q = _mm_cvtps_epi32(_mm_mul_ps(angle, twoOverPi));
+            __m128 quadrant = _mm_cvtepi32_ps(q);
+            __m128 r = _mm_sub_ps(angle, _mm_mul_ps(quadrant, _mm_set1_ps(HALF_PI_HI)));
+            r = _mm_sub_ps(r, _mm_mul_ps(quadrant, _mm_set1_ps(HALF_PI_MID)));
+            r = _mm_sub_ps(r, _mm_mul_ps(quadrant, _mm_set1_ps(HALF_PI_LO)));
+            __m128 r2 = _mm_mul_ps(r, r);
+
+            __m128 s = _mm_add_ps(_mm_set1_ps(SIN_C3), _mm_mul_ps(r2, _mm_set1_ps(SIN_C4)));
+            s = _mm_add_ps(_mm_set1_ps(SIN_C2), _mm_mul_ps(r2, s));
+            s = _mm_add_ps(_mm_set1_ps(SIN_C1), _mm_mul_ps(r2, s));
+            s = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), s));
+
+            __m128 c = _mm_add_ps(_mm_set1_ps(COS_C3), _mm_mul_ps(r2, _mm_set1_ps(COS_C4)));
+            c = _mm_add_ps(_mm_set1_ps(COS_C2), _mm_mul_ps(r2, c));
+            c = _mm_add_ps(_mm_set1_ps(COS_C1), _mm_mul_ps(r2, c));
+            c = _mm_add_ps(_mm_set1_ps(1.f), _mm_mul_ps(r2, c));
+
+            //odd quadrants swap sine & cosine, then the signs follow bit 1 of q & of q + 1
+            __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+            __m128 sine = _mm_or_ps(_mm_and_ps(swap, c), _mm_andnot_ps(swap, s));
+            __m128 cosine = _mm_or_ps(_mm_and_ps(swap, s), _mm_andnot_ps(swap, c));
+
+            __m128 sineFlip = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, two), two));
+            __m128 cosineFlip = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), two));
+            sine = _mm_xor_ps(sine, _mm_and_ps(sineFlip, signBit));
+            cosine = _mm_xor_ps(cosine, _mm_and_ps(cosineFlip, signBit));
+
+            _mm_storeu_ps(sines + i, sine);
+            _mm_storeu_ps(cosines + i, cosine);
+        }
+#endif
+
+        for (; i < count; ++i) {
+            sinCosScalar(angles[i], sines[i], cosines[i]);
+        }
+    }
+
+}  // namespace lve
@@ -0,0 +1,16 @@
+#pragma once
+
+// std
+#include <cstddef>
+
+namespace nekographics {
+
+    /*
+    Sine & cosine of a whole array, 4 angles per iteration with SSE2 (scalar elsewhere, same polynomial so
+    every lane gets the same result). The angle is reduced to [-pi/4, pi/4] & approximated with degree 8/9
+    polynomials, around 1e-7 absolute error for angles within a few thousand radians.
+    The arrays may not overlap.
+    */
+    void sinCosBatch(const float* angles, float* sines, float* cosines, size_t count);
+
+}  // namespace lve
@@ -4,6 +4,7 @@
 
 // std
 #include <array>
+#include <cassert>
 #include <cstdlib>
 #include <cstring>
 #include <iostream>
@@ -28,7 +29,12 @@ namespace nekographics {
     }
 
     void NKSwapChain::init() {
-        createSwapChain();
+        if (device.isHeadless()) {
+            createOffscreenImages();//no surface to present to, render into our own images 
+        }
+        else {
+            createSwapChain();
+        }
         createImageViews();
         createRenderPass();//render pass discribes structure & format of a frame buffer object & attachment, sort of like a blue print 
         createDepthResources();
@@ -47,10 +53,18 @@ namespace nekographics {
             swapChain = nullptr;
         }
 
+        //offscreen images are owned by us rather than the swap chain
+        for (size_t i = 0; i < offscreenImageAllocations.size(); i++) {
+            device.destroyImage(swapChainImages[i], offscreenImageAllocations[i]);
+        }
+
+        for (size_t i = 0; i < readbackBuffers.size(); i++) {
+            device.destroyBuffer(readbackBuffers[i], readbackBufferAllocations[i]);
+        }
+
         for (int i = 0; i < depthImages.size(); i++) {
             vkDestroyImageView(device.device(), depthImageViews[i], nullptr);
-            vkDestroyImage(device.device(), depthImages[i], nullptr);
-            vkFreeMemory(device.device(), depthImageMemorys[i], nullptr);
+            device.destroyImage(depthImages[i], depthImageAllocations[i]);
         }
 
         for (auto framebuffer : swapChainFramebuffers) {
@@ -76,6 +90,12 @@ namespace nekographics {
             VK_TRUE,
             std::numeric_limits<uint64_t>::max());
 
+        //offscreen images rotate with the frames in flight 
+        if (device.isHeadless()) {
+            *imageIndex = static_cast<uint32_t>(currentFrame);
+            return VK_SUCCESS;
+        }
+
         VkResult result = vkAcquireNextImageKHR(
             device.device(),
             swapChain,
@@ -96,6 +116,21 @@ namespace nekographics {
         VkSubmitInfo submitInfo = {};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
+        //headless, nothing to acquire or present so the fence is the only sync needed
+        if (device.isHeadless()) {
+            submitInfo.commandBufferCount = 1;
+            submitInfo.pCommandBuffers = buffers;
+
+            vkResetFences(device.device(), 1, &inFlightFences[currentFrame]);
+            if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, inFlightFences[currentFrame]) !=
+                VK_SUCCESS) {
+                throw std::runtime_error("failed to submit draw command buffer!");
+            }
+
+            currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+            return VK_SUCCESS;
+        }
+
         VkSemaphore waitSemaphores[] = { imageAvailableSemaphores[currentFrame] };
         VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
         submitInfo.waitSemaphoreCount = 1;
@@ -196,6 +231,146 @@ namespace nekographics {
         swapChainExtent = extent;
     }
 
+    void NKSwapChain::createOffscreenImages() {
+        //one color target per frame in flight, same format the surface path prefers
+        swapChainImageFormat = VK_FORMAT_B8G8R8A8_SRGB;
+        swapChainExtent = windowExtent;
+
+        swapChainImages.resize(MAX_FRAMES_IN_FLIGHT);
+        offscreenImageAllocations.resize(MAX_FRAMES_IN_FLIGHT);
+
+        for (size_t i = 0; i < swapChainImages.size(); i++) {
+            VkImageCreateInfo imageInfo{};
+            imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+            imageInfo.imageType = VK_IMAGE_TYPE_2D;
+            imageInfo.extent.width = swapChainExtent.width;
+            imageInfo.extent.height = swapChainExtent.height;
+            imageInfo.extent.depth = 1;
+            imageInfo.mipLevels = 1;
+            imageInfo.arrayLayers = 1;
+            imageInfo.format = swapChainImageFormat;
+            imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+            imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+            imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+            imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+            imageInfo.flags = 0;
+
+            device.createImageWithInfo(
+                imageInfo,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                swapChainImages[i],
+                offscreenImageAllocations[i]);
+        }
+    }
+
+    void NKSwapChain::createReadbackBuffers() {
+        VkDeviceSize imageSize = static_cast<VkDeviceSize>(swapChainExtent.width) * swapChainExtent.height * 4;
+
+        readbackBuffers.resize(imageCount());
+        readbackBufferAllocations.resize(imageCount());
+        readbackRecorded.resize(imageCount(), false);
+
+        for (size_t i = 0; i < imageCount(); i++) {
+            device.createBuffer(
+                imageSize,
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                readbackBuffers[i],
+                readbackBufferAllocations[i]);
+        }
+    }
+
+    void NKSwapChain::recordReadback(VkCommandBuffer commandBuffer, uint32_t imageIndex) {
+        assert(device.isHeadless() && "Readback is only supported for offscreen rendering");
+
+        //buffers are only created once someone actually asks for the pixels 
+        if (readbackBuffers.empty()) {
+            createReadbackBuffers();
+        }
+
+        //render pass already left the image in transfer src layout, wait for the color writes to land
+        VkImageMemoryBarrier imageBarrier{};
+        imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        imageBarrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+        imageBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        imageBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imageBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+        imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        imageBarrier.image = swapChainImages[imageIndex];
+        imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        imageBarrier.subresourceRange.baseMipLevel = 0;
+        imageBarrier.subresourceRange.levelCount = 1;
+        imageBarrier.subresourceRange.baseArrayLayer = 0;
+        imageBarrier.subresourceRange.layerCount = 1;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &imageBarrier);
+
+        VkBufferImageCopy region{};
+        region.bufferOffset = 0;
+        region.bufferRowLength = 0;
+        region.bufferImageHeight = 0;
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        region.imageSubresource.mipLevel = 0;
+        region.imageSubresource.baseArrayLayer = 0;
+        region.imageSubresource.layerCount = 1;
+        region.imageOffset = { 0, 0, 0 };
+        region.imageExtent = { swapChainExtent.width, swapChainExtent.height, 1 };
+
+        vkCmdCopyImageToBuffer(
+            commandBuffer,
+            swapChainImages[imageIndex],
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+            readbackBuffers[imageIndex],
+            1,
+            &region);
+
+        //make the copy visible to the host once the fence signals 
+        VkBufferMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.buffer = readbackBuffers[imageIndex];
+        barrier.offset = 0;
+        barrier.size = VK_WHOLE_SIZE;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TRANSFER_BIT,
+            VK_PIPELINE_STAGE_HOST_BIT,
+            0,
+            0, nullptr,
+            1, &barrier,
+            0, nullptr);
+
+        readbackRecorded[imageIndex] = true;
+    }
+
+    bool NKSwapChain::readbackImage(uint32_t imageIndex, std::vector<uint8_t>& pixels) {
+        if (imageIndex >= readbackRecorded.size() || !readbackRecorded[imageIndex]) {
+            return false;
+        }
+
+        //offscreen image index matches the frame index, so its fence covers the copy 
+        vkWaitForFences(device.device(), 1, &inFlightFences[imageIndex], VK_TRUE, UINT64_MAX);
+
+        size_t imageSize = static_cast<size_t>(swapChainExtent.width) * swapChainExtent.height * 4;
+        pixels.resize(imageSize);
+        device.getAllocator().invalidate(readbackBufferAllocations[imageIndex]);
+        memcpy(pixels.data(), readbackBufferAllocations[imageIndex].mapped, imageSize);
+        return true;
+    }
+
     void NKSwapChain::createImageViews() {
         swapChainImageViews.resize(swapChainImages.size());
         for (size_t i = 0; i < swapChainImages.size(); i++) {
@@ -218,11 +393,18 @@ namespace nekographics {
     }
 
     void NKSwapChain::createRenderPass() {
+        VkFormat depthFormat = findDepthFormat();
+
+        //the depth pyramid samples the depth attachment after the render pass when the format allows it 
+        VkFormatProperties depthProperties;
+        vkGetPhysicalDeviceFormatProperties(device.getPhysicalDevice(), depthFormat, &depthProperties);
+        depthSampleable = (depthProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0;
+
         VkAttachmentDescription depthAttachment{};
-        depthAttachment.format = findDepthFormat();
+        depthAttachment.format = depthFormat;
         depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
         depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-        depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        depthAttachment.storeOp = depthSampleable ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
         depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -240,7 +422,9 @@ namespace nekographics {
         colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
         colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
         colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-        colorAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+        //offscreen images are left ready to be copied out instead of presented 
+        colorAttachment.finalLayout =
+            device.isHeadless() ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
 
         VkAttachmentReference colorAttachmentRef = {};
         colorAttachmentRef.attachment = 0;
@@ -310,7 +494,7 @@ namespace nekographics {
         VkExtent2D swapChainExtentTmp = getSwapChainExtent();
 
         depthImages.resize(imageCount());
-        depthImageMemorys.resize(imageCount());
+        depthImageAllocations.resize(imageCount());
         depthImageViews.resize(imageCount());
 
         for (int i = 0; i < depthImages.size(); i++) {
@@ -325,7 +509,7 @@ namespace nekographics {
             imageInfo.format = depthFormat;
             imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
             imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+            imageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | (depthSampleable ? VK_IMAGE_USAGE_SAMPLED_BIT : 0);
             imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
             imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
             imageInfo.flags = 0;
@@ -334,7 +518,7 @@ namespace nekographics {
                 imageInfo,
                 VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
                 depthImages[i],
-                depthImageMemorys[i]);
+                depthImageAllocations[i]);
 
             VkImageViewCreateInfo viewInfo{};
             viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
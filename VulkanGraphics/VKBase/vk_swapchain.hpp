@@ -43,9 +43,34 @@ namespace nekographics {
         }
         VkFormat findDepthFormat();
 
+        //the depth attachments are kept after the render pass & can be sampled when the format allows it
+        bool isDepthSampleable() const { return depthSampleable; }
+        VkFormat getDepthFormat() const { return swapChainDepthFormat; }
+        VkImage getDepthImage(int index) { return depthImages[index]; }
+        VkImageView getDepthImageView(int index) { return depthImageViews[index]; }
+
         VkResult acquireNextImage(uint32_t* imageIndex);
         VkResult submitCommandBuffers(const VkCommandBuffer* buffers, uint32_t* imageIndex);
 
+        /**
+         * Records a copy of an offscreen color image into its host visible readback buffer
+         * Only valid for headless devices, must be recorded after the render pass has ended
+         *
+         * @param commandBuffer The command buffer of the frame that rendered the image
+         * @param imageIndex Index of the offscreen image to copy
+         */
+        void recordReadback(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+        /**
+         * Waits for the frame that last rendered to the image, then copies the readback buffer out
+         *
+         * @param imageIndex Index of the offscreen image to read
+         * @param pixels Output, tightly packed 4 bytes per pixel in getSwapChainImageFormat()
+         *
+         * @return false if no readback was recorded for this image
+         */
+        bool readbackImage(uint32_t imageIndex, std::vector<uint8_t>& pixels);
+
         bool compareSwapFormats(const NKSwapChain& pswapChain) const {
             return pswapChain.swapChainDepthFormat == swapChainDepthFormat &&
                 pswapChain.swapChainImageFormat == swapChainImageFormat;
@@ -54,6 +79,8 @@ namespace nekographics {
     private:
         void init();
         void createSwapChain();
+        void createOffscreenImages();
+        void createReadbackBuffers();
         void createImageViews();
         void createDepthResources();
         void createRenderPass();
@@ -69,21 +96,28 @@ namespace nekographics {
 
         VkFormat swapChainImageFormat;//keeping track of the image format 
         VkFormat swapChainDepthFormat;//keeping track of the depth format 
+        bool depthSampleable = false;//depth format supports sampling, the depth pyramid reads it 
         VkExtent2D swapChainExtent;
 
         std::vector<VkFramebuffer> swapChainFramebuffers;//stores all the framebuffer objects, color/depth
         VkRenderPass renderPass;
 
         std::vector<VkImage> depthImages;
-        std::vector<VkDeviceMemory> depthImageMemorys;
+        std::vector<NKAllocation> depthImageAllocations;
         std::vector<VkImageView> depthImageViews;
         std::vector<VkImage> swapChainImages;
         std::vector<VkImageView> swapChainImageViews;
 
+        //headless only, device local color targets that stand in for the swap chain images
+        std::vector<NKAllocation> offscreenImageAllocations;
+        std::vector<VkBuffer> readbackBuffers;
+        std::vector<NKAllocation> readbackBufferAllocations;
+        std::vector<bool> readbackRecorded;
+
         NKDevice& device;
         VkExtent2D windowExtent;
 
-        VkSwapchainKHR swapChain;
+        VkSwapchainKHR swapChain = VK_NULL_HANDLE;
         std::shared_ptr<NKSwapChain> oldSwapChain;//pointer to the old swapchain
 
         std::vector<VkSemaphore> imageAvailableSemaphores;
@@ -1,5 +1,6 @@
 //includes 
 #include "vk_texture.hpp"
+#include "vk_samplercache.hpp"
 
 //libs
 #define TINYDDSLOADER_IMPLEMENTATION
@@ -12,6 +13,56 @@ using namespace tinyddsloader;
 
 namespace nekographics {
 
+	namespace {
+		//getting the format of the dds 
+		VkFormat getDDSFormat(const DDSFile& dds) {
+			// https://www.khronos.org/registry/vulkan/specs/1.0/xhtml/vkspec.html 
+			// VK Interpretation of Numeric Format
+			// UNORM   - The components are unsigned normalized values in the range [0,1]
+			// SNORM   - The components are signed normalized values in the range [-1,1]
+			// USCALED - The components are unsigned integer values that get converted to floating-point in the range [0,2n-1]
+			// SSCALED - The components are signed integer values that get converted to floating-point in the range [-2n-1,2n-1-1]
+			// UINT    - The components are unsigned integer values in the range [0,2n-1]
+			// SINT    - The components are signed integer values in the range [-2n-1,2n-1-1]
+			// UFLOAT  - The components are unsigned floating-point numbers (used by packed, shared exponent, and some compressed formats)
+			// SFLOAT  - The components are signed floating-point numbers
+			// SRGB    - The R, G, and B components are unsigned normalized values that represent values using sRGB nonlinear encoding, 
+			//           while the A component (if one exists) is a regular unsigned normalized value
+			switch (dds.GetFormat()) {
+			case DDSFile::DXGIFormat::BC1_UNorm:
+				return VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
+			case DDSFile::DXGIFormat::BC1_UNorm_SRGB:
+				return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+			case DDSFile::DXGIFormat::BC2_UNorm:
+				return VK_FORMAT_BC2_UNORM_BLOCK;
+			case DDSFile::DXGIFormat::BC2_UNorm_SRGB:
+				return VK_FORMAT_BC2_SRGB_BLOCK;
+			case DDSFile::DXGIFormat::BC3_UNorm:
+				return VK_FORMAT_BC3_UNORM_BLOCK;
+			case DDSFile::DXGIFormat::BC3_UNorm_SRGB:
+				return VK_FORMAT_BC3_SRGB_BLOCK;
+			case DDSFile::DXGIFormat::R8G8B8A8_UNorm:
+				return VK_FORMAT_R8G8B8A8_UNORM;
+			case DDSFile::DXGIFormat::R8G8B8A8_UNorm_SRGB:
+				return VK_FORMAT_R8G8B8A8_SRGB;
+			case DDSFile::DXGIFormat::R8G8B8A8_SNorm:
+				return VK_FORMAT_R8G8B8A8_SNORM;
+			case DDSFile::DXGIFormat::B8G8R8A8_UNorm:
+				return VK_FORMAT_B8G8R8A8_UNORM;
+			case DDSFile::DXGIFormat::B8G8R8A8_UNorm_SRGB:
+				return VK_FORMAT_B8G8R8A8_SRGB;
+			case DDSFile::DXGIFormat::B8G8R8A8_Typeless:
+				return VK_FORMAT_B8G8R8A8_SNORM;
+			case DDSFile::DXGIFormat::BC5_UNorm:
+				return VK_FORMAT_BC5_UNORM_BLOCK;
+			case DDSFile::DXGIFormat::BC5_SNorm:
+				return VK_FORMAT_BC5_SNORM_BLOCK;
+			default:
+				return VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
+			}
+		}
+	}
+
 	VkImageView NKTexture::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipCount) {
 		// Create image view
 	   // Textures are not directly accessed by the shaders and
@@ -51,57 +102,7 @@ namespace nekographics {
 		return imageView;
 	}
 
-	void NKTexture::transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipCount) {
-		UNREFERENCED_PARAMETER(format);
-		VkCommandBuffer commandBuffer = m_vkDevice.beginSingleTimeCommands();
-
-		VkImageMemoryBarrier barrier{};
-		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-		barrier.oldLayout = oldLayout;
-		barrier.newLayout = newLayout;
-		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-		barrier.image = image;
-		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		barrier.subresourceRange.baseMipLevel = 0;
-		barrier.subresourceRange.levelCount = mipCount;
-		barrier.subresourceRange.baseArrayLayer = 0;
-		barrier.subresourceRange.layerCount = 1;
-
-		VkPipelineStageFlags sourceStage;
-		VkPipelineStageFlags destinationStage;
-
-		if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
-			barrier.srcAccessMask = 0;
-			barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-
-			sourceStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
-			destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-		}
-		else if (oldLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL) {
-			barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-			barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-			sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
-			destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-		}
-		else {
-			throw std::invalid_argument("unsupported layout transition!");
-		}
-
-		vkCmdPipelineBarrier(
-			commandBuffer,
-			sourceStage, destinationStage,
-			0,
-			0, nullptr,
-			0, nullptr,
-			1, &barrier
-		);
-
-		m_vkDevice.endSingleTimeCommands(commandBuffer);
-	}
-
-	void NKTexture::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t mipCount) {
+	void NKTexture::createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, NKAllocation& imageAllocation, uint32_t mipCount) {
 		VkImageCreateInfo imageInfo{};
 		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
 		imageInfo.imageType = VK_IMAGE_TYPE_2D;
@@ -117,23 +118,8 @@ namespace nekographics {
 		imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
 		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 
-		if (vkCreateImage(m_vkDevice.device(), &imageInfo, nullptr, &image) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create image!");
-		}
-
-		VkMemoryRequirements memRequirements;
-		vkGetImageMemoryRequirements(m_vkDevice.device(), image, &memRequirements);
-
-		VkMemoryAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-		allocInfo.allocationSize = memRequirements.size;
-		allocInfo.memoryTypeIndex = m_vkDevice.findMemoryType(memRequirements.memoryTypeBits, properties);
-
-		if (vkAllocateMemory(m_vkDevice.device(), &allocInfo, nullptr, &imageMemory) != VK_SUCCESS) {
-			throw std::runtime_error("failed to allocate image memory!");
-		}
-
-		vkBindImageMemory(m_vkDevice.device(), image, imageMemory, 0);
+		//sub allocated through the device allocator 
+		m_vkDevice.createImageWithInfo(imageInfo, properties, image, imageAllocation);
 	}
 
 	void NKTexture::createTextureImageSTB(const std::string& texturePath) {
@@ -145,28 +131,20 @@ namespace nekographics {
 			throw std::runtime_error("failed to load texture image!");
 		}
 
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-		m_vkDevice.createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+		NKUploadManager& uploadManager = m_vkDevice.getUploadManager();
+		NKStagingSpan staging = uploadManager.stage(imageSize);//space in the staging ring 
 
-		void* data;
-		vkMapMemory(m_vkDevice.device(), stagingBufferMemory, 0, imageSize, 0, &data);
-		memcpy(data, pixels, static_cast<size_t>(imageSize));
-		vkUnmapMemory(m_vkDevice.device(), stagingBufferMemory);
+		memcpy(staging.mapped, pixels, static_cast<size_t>(imageSize));
 
 		stbi_image_free(pixels);
 
-		createImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, 1);
-
-		transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-		m_vkDevice.copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1);
-		transitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		createImage(texWidth, texHeight, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageAllocation, 1);
 
-		vkDestroyBuffer(m_vkDevice.device(), stagingBuffer, nullptr);
-		vkFreeMemory(m_vkDevice.device(), stagingBufferMemory, nullptr);
+		//layout transitions & copy are batched with the other uploads 
+		uploadManager.copyBufferToImage(staging, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1, { static_cast<uint32_t>(imageSize) });
 
 		//storing into a vector 
-		textureImageMemoryVec.emplace_back(textureImageMemory);
+		textureImageAllocationVec.emplace_back(textureImageAllocation);
 		textureImageVec.emplace_back(textureImage);
 
 		//createTextureImageView();
@@ -179,28 +157,8 @@ namespace nekographics {
 	}
 
 	void NKTexture::createTextureSampler() {
-		VkPhysicalDeviceProperties properties{};
-		vkGetPhysicalDeviceProperties(m_vkDevice.getPhysicalDevice(), &properties);
-
-		VkSamplerCreateInfo samplerInfo{};
-		samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
-		samplerInfo.magFilter = VK_FILTER_LINEAR;
-		samplerInfo.minFilter = VK_FILTER_LINEAR;
-		samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
-		samplerInfo.anisotropyEnable = VK_TRUE;
-		samplerInfo.maxAnisotropy = properties.limits.maxSamplerAnisotropy;
-		samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-		samplerInfo.unnormalizedCoordinates = VK_FALSE;
-		samplerInfo.compareEnable = VK_FALSE;
-		samplerInfo.compareOp = VK_COMPARE_OP_NEVER;
-		samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-		samplerInfo.maxLod = 1000;
-
-		if (vkCreateSampler(m_vkDevice.device(), &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS) {
-			throw std::runtime_error("failed to create texture sampler!");
-		}
+		//every texture shares the same sampler, owned by the device's cache 
+		textureSampler = m_vkDevice.getSamplerCache().getTextureSampler();
 
 		//storing into vec 
 		textureSamplerVec.emplace_back(textureSampler);
@@ -211,19 +169,41 @@ namespace nekographics {
 	}
 
 	NKTexture::~NKTexture(){
-		for (auto& x : textureSamplerVec) {
-			vkDestroySampler(m_vkDevice.device(), x, nullptr);
-		}
 		for (auto& x : textureImageViewVec) {
 			vkDestroyImageView(m_vkDevice.device(), x, nullptr);
 		}
-		for (auto& x : textureImageVec) {
-			vkDestroyImage(m_vkDevice.device(), x, nullptr);
+		for (size_t i = 0; i < textureImageVec.size(); ++i) {
+			m_vkDevice.destroyImage(textureImageVec[i], textureImageAllocationVec[i]);
 		}
-		for (auto& x : textureImageMemoryVec) {
-			vkFreeMemory(m_vkDevice.device(), x, nullptr);
+
+	}
+
+	NKDDSImage NKTexture::readDDS(const std::string& texturePath) {
+		DDSFile dds;
+		if (dds.Load(texturePath.c_str()) != tinyddsloader::Result::Success) {
+			throw std::runtime_error("failed to load texture image!");
+		}
+		if (dds.GetTextureDimension() != DDSFile::TextureDimension::Texture2D) {
+			throw std::runtime_error("failed to load texture image, only 2d textures are supported!");
+		}
+
+		NKDDSImage image;
+		image.format = getDDSFormat(dds);
+		image.mips.reserve(dds.GetMipCount());
+
+		uint32_t offset = 0;
+		for (uint32_t iMip = 0; iMip < dds.GetMipCount(); ++iMip) {
+			auto View = dds.GetImageData(iMip, 0);
+			image.mips.push_back({ View->m_width, View->m_height, offset, View->m_memSlicePitch });
+			offset += View->m_memSlicePitch;
 		}
 
+		//one copy out of the loader's memory, it is freed with dds 
+		image.data.resize(offset);
+		for (uint32_t iMip = 0; iMip < dds.GetMipCount(); ++iMip) {
+			std::memcpy(&image.data[image.mips[iMip].offset], dds.GetImageData(iMip, 0)->m_mem, image.mips[iMip].size);
+		}
+		return image;
 	}
 
 	void NKTexture::createTextureImageDDSMIPMAPS(const std::string& texturePath) {
@@ -244,66 +224,7 @@ namespace nekographics {
 
 
 		//getting basic information about the texture 
-		VkFormat ddsVKFormat;//stores the vk format 
-		//getting the format of the dds 
-		// https://www.khronos.org/registry/vulkan/specs/1.0/xhtml/vkspec.html 
-		// VK Interpretation of Numeric Format
-		// UNORM   - The components are unsigned normalized values in the range [0,1]
-		// SNORM   - The components are signed normalized values in the range [-1,1]
-		// USCALED - The components are unsigned integer values that get converted to floating-point in the range [0,2n-1]
-		// SSCALED - The components are signed integer values that get converted to floating-point in the range [-2n-1,2n-1-1]
-		// UINT    - The components are unsigned integer values in the range [0,2n-1]
-		// SINT    - The components are signed integer values in the range [-2n-1,2n-1-1]
-		// UFLOAT  - The components are unsigned floating-point numbers (used by packed, shared exponent, and some compressed formats)
-		// SFLOAT  - The components are signed floating-point numbers
-		// SRGB    - The R, G, and B components are unsigned normalized values that represent values using sRGB nonlinear encoding, 
-		//           while the A component (if one exists) is a regular unsigned normalized value
-		switch (dds.GetFormat()) {
-		case DDSFile::DXGIFormat::BC1_UNorm:
-			ddsVKFormat = VK_FORMAT_BC1_RGBA_UNORM_BLOCK;
-			break;
-		case DDSFile::DXGIFormat::BC1_UNorm_SRGB:
-			ddsVKFormat = VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
-			break;
-		case DDSFile::DXGIFormat::BC2_UNorm:
-			ddsVKFormat = VK_FORMAT_BC2_UNORM_BLOCK;
-			break;
-		case DDSFile::DXGIFormat::BC2_UNorm_SRGB:
-			ddsVKFormat = VK_FORMAT_BC2_SRGB_BLOCK;
-			break;
-		case DDSFile::DXGIFormat::BC3_UNorm:
-			ddsVKFormat = VK_FORMAT_BC3_UNORM_BLOCK;
-			break;
-		case DDSFile::DXGIFormat::BC3_UNorm_SRGB:
-			ddsVKFormat = VK_FORMAT_BC3_SRGB_BLOCK;
-			break;
-		case DDSFile::DXGIFormat::R8G8B8A8_UNorm:
-			ddsVKFormat = VK_FORMAT_R8G8B8A8_UNORM;
-			break;
-		case DDSFile::DXGIFormat::R8G8B8A8_UNorm_SRGB:
-			ddsVKFormat = VK_FORMAT_R8G8B8A8_SRGB;
-			break;
-		case DDSFile::DXGIFormat::R8G8B8A8_SNorm:
-			ddsVKFormat = VK_FORMAT_R8G8B8A8_SNORM;
-			break;
-		case DDSFile::DXGIFormat::B8G8R8A8_UNorm:
-			ddsVKFormat = VK_FORMAT_B8G8R8A8_UNORM;
-			break;
-		case DDSFile::DXGIFormat::B8G8R8A8_UNorm_SRGB:
-			ddsVKFormat = VK_FORMAT_B8G8R8A8_SRGB;
-			break;
-		case DDSFile::DXGIFormat::B8G8R8A8_Typeless:
-			ddsVKFormat = VK_FORMAT_B8G8R8A8_SNORM;
-			break;
-		case DDSFile::DXGIFormat::BC5_UNorm:
-			ddsVKFormat = VK_FORMAT_BC5_UNORM_BLOCK;
-			break;
-		case DDSFile::DXGIFormat::BC5_SNorm:
-			ddsVKFormat = VK_FORMAT_BC5_SNORM_BLOCK;
-			break;
-		default:
-			ddsVKFormat = VK_FORMAT_BC1_RGBA_SRGB_BLOCK;
-		}
+		VkFormat ddsVKFormat = getDDSFormat(dds);//stores the vk format 
 
 		const auto TotalByteSize = [&]
 		{
@@ -330,14 +251,12 @@ namespace nekographics {
 		////
 		VkDeviceSize imageSize = TotalByteSize;//getting the image size of the entire mipmaps and layers 
 
-		VkBuffer stagingBuffer;
-		VkDeviceMemory stagingBufferMemory;
-		m_vkDevice.createBuffer(imageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, stagingBuffer, stagingBufferMemory);
+		NKUploadManager& uploadManager = m_vkDevice.getUploadManager();
+		NKStagingSpan staging = uploadManager.stage(imageSize);//space in the staging ring 
 
 		std::vector<uint32_t> offsetVector;//stores the offsets 
 
-		void* data;
-		vkMapMemory(m_vkDevice.device(), stagingBufferMemory, 0, imageSize, 0, &data);
+		void* data = staging.mapped;
 		{
 			auto pMemory = reinterpret_cast<std::byte*>(data);
 			int  Offset = 0;
@@ -353,24 +272,19 @@ namespace nekographics {
 				offsetVector.emplace_back(ByteSize);
 			}
 		}
-		vkUnmapMemory(m_vkDevice.device(), stagingBufferMemory);
 
 		int texWidth, texHeight;
 		//setting the width and the height of the image 
 		texWidth = dds.GetWidth();
 		texHeight = dds.GetHeight();
 
-		createImage(texWidth, texHeight, ddsVKFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageMemory, dds.GetMipCount());
-
-		transitionImageLayout(textureImage, ddsVKFormat, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, dds.GetMipCount());
-		m_vkDevice.copyBufferToImage(stagingBuffer, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), 1, dds.GetMipCount(), offsetVector);
-		transitionImageLayout(textureImage, ddsVKFormat, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, dds.GetMipCount());
+		createImage(texWidth, texHeight, ddsVKFormat, VK_IMAGE_TILING_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, textureImage, textureImageAllocation, dds.GetMipCount());
 
-		vkDestroyBuffer(m_vkDevice.device(), stagingBuffer, nullptr);
-		vkFreeMemory(m_vkDevice.device(), stagingBufferMemory, nullptr);
+		//layout transitions & copy of every mip are batched with the other uploads 
+		uploadManager.copyBufferToImage(staging, textureImage, static_cast<uint32_t>(texWidth), static_cast<uint32_t>(texHeight), dds.GetMipCount(), offsetVector);
 
 		//storing into a vector 
-		textureImageMemoryVec.emplace_back(textureImageMemory);
+		textureImageAllocationVec.emplace_back(textureImageAllocation);
 		textureImageVec.emplace_back(textureImage);
 
 		createTextureImageView(ddsVKFormat, dds.GetMipCount());
@@ -1,9 +1,23 @@
 #pragma once
-#include "WindowManager.h"
 #include "vk_device.hpp"
 #include <iostream>
+#include <cstddef>
 
 namespace nekographics {
+	//a dds file read into memory, mips biggest first & tightly packed the way NKUploadManager copies them 
+	struct NKDDSImage {
+		struct Mip {
+			uint32_t width;
+			uint32_t height;
+			uint32_t offset;//into data 
+			uint32_t size;
+		};
+
+		VkFormat format = VK_FORMAT_UNDEFINED;
+		std::vector<Mip> mips;
+		std::vector<std::byte> data;
+	};
+
 	class NKTexture {
 	public:
 		NKTexture(NKDevice& device);
@@ -13,18 +27,20 @@ namespace nekographics {
 		void createTextureImageSTB(const std::string& filepath);
 		void createTextureImageDDSMIPMAPS(const std::string& filepath);
 
+		//the file's mips without creating anything on the gpu, for callers that upload only some of them 
+		static NKDDSImage readDDS(const std::string& filepath);
+
 		std::vector<VkImage> textureImageVec;
-		std::vector<VkDeviceMemory> textureImageMemoryVec;
+		std::vector<NKAllocation> textureImageAllocationVec;
 		std::vector<VkImageView> textureImageViewVec;
-		std::vector<VkSampler> textureSamplerVec;
+		std::vector<VkSampler> textureSamplerVec;//shared through the sampler cache, not owned 
 		std::vector<VkDescriptorImageInfo> imageInfoVec;
 
 	private:
 		//creating of iamges 
 		void createTextureImageView(VkFormat format, uint32_t mipCount = 1);
 		void createTextureSampler();
-		void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, VkDeviceMemory& imageMemory, uint32_t mipCount);
-		void transitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipCount = 1);
+		void createImage(uint32_t width, uint32_t height, VkFormat format, VkImageTiling tiling, VkImageUsageFlags usage, VkMemoryPropertyFlags properties, VkImage& image, NKAllocation& imageAllocation, uint32_t mipCount);
 		VkImageView createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipCount = 1);
 
 
@@ -32,7 +48,7 @@ namespace nekographics {
 
 		//for image
 		VkImage textureImage;
-		VkDeviceMemory textureImageMemory;
+		NKAllocation textureImageAllocation;
 		VkImageView textureImageView;
 		VkSampler textureSampler;
 	};
@@ -0,0 +1,311 @@
+#include "vk_texturestreamer.hpp"
+#include "vk_samplercache.hpp"
+#include "vk_swapchain.hpp"
+
+// std
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace nekographics {
+
+    NKTextureStreamer::NKTextureStreamer(NKDevice& streamerDevice, NKMaterialTable& materialTable, VkDeviceSize budgetBytes)
+        : device{ streamerDevice }, materials{ materialTable }, budget{ budgetBytes } {
+        sampler = device.getSamplerCache().getTextureSampler();
+    }
+
+    NKTextureStreamer::~NKTextureStreamer() {
+        device.getUploadManager().waitIdle();//pending images may still be copied into
+        for (auto& texture : textures) {
+            destroyImage(texture.current);
+            if (texture.hasPending) {
+                destroyImage(texture.pending);
+            }
+        }
+        for (auto& old : retired) {
+            destroyImage(old.image);
+        }
+    }
+
+    uint32_t NKTextureStreamer::loadTexture(const std::string& filepath) {
+        StreamedTexture texture;
+        texture.file = NKTexture::readDDS(filepath);
+
+        //the finest mip that is small enough, or the last one when the file stops before that
+        const auto& mips = texture.file.mips;
+        texture.tailMip = static_cast<uint32_t>(mips.size()) - 1;
+        for (uint32_t mip = 0; mip < mips.size(); ++mip) {
+            if (std::max(mips[mip].width, mips[mip].height) <= MIP_TAIL_SIZE) {
+                texture.tailMip = mip;
+                break;
+            }
+        }
+
+        //the tail goes straight in, the slot is written before the copy is done like every loaded texture
+        streamTo(texture, texture.tailMip);
+        texture.current = texture.pending;
+        texture.residentMip = texture.tailMip;
+        texture.hasPending = false;
+        texture.requestedMip = texture.tailMip;
+
+        texture.tableIndex = materials.addTexture(texture.current.view, sampler);
+        if (texture.tableIndex >= tableToTexture.size()) {
+            tableToTexture.resize(static_cast<size_t>(texture.tableIndex) + 1, INVALID_TEXTURE);
+        }
+        tableToTexture[texture.tableIndex] = static_cast<uint32_t>(textures.size());
+
+        stats.fullBytes += getMipBytes(texture, 0);
+        uint32_t index = texture.tableIndex;
+        textures.push_back(std::move(texture));
+        return index;
+    }
+
+    NKTextureStreamer::StreamedTexture* NKTextureStreamer::findTexture(uint32_t texture) {
+        if (texture >= tableToTexture.size() || tableToTexture[texture] == INVALID_TEXTURE) {
+            return nullptr;
+        }
+        return &textures[tableToTexture[texture]];
+    }
+
+    const NKTextureStreamer::StreamedTexture* NKTextureStreamer::findTexture(uint32_t texture) const {
+        if (texture >= tableToTexture.size() || tableToTexture[texture] == INVALID_TEXTURE) {
+            return nullptr;
+        }
+        return &textures[tableToTexture[texture]];
+    }
+
+    void NKTextureStreamer::requestMip(uint32_t texture, uint32_t mip) {
+        StreamedTexture* streamed = findTexture(texture);
+        if (streamed == nullptr) {
+            return;
+        }
+        //the tail is always resident, coarser requests are the same as asking for it
+        streamed->requestedMip = std::min(streamed->requestedMip, std::min(mip, streamed->tailMip));
+        streamed->lastRequestFrame = frame;
+    }
+
+    void NKTextureStreamer::requestScreenSize(uint32_t texture, float screenPixels) {
+        const StreamedTexture* streamed = findTexture(texture);
+        if (streamed == nullptr) {
+            return;
+        }
+
+        //mip n has 2^n times fewer texels along each side than mip 0
+        const auto& top = streamed->file.mips[0];
+        float texels = static_cast<float>(std::max(top.width, top.height));
+        float mip = screenPixels > 1.f ? std::floor(std::log2(texels / screenPixels)) : static_cast<float>(streamed->tailMip);
+        requestMip(texture, static_cast<uint32_t>(std::max(mip, 0.f)));
+    }
+
+    void NKTextureStreamer::requestMaterial(uint32_t material, float screenPixels) {
+        if (material >= materials.getMaterialCount()) {
+            return;
+        }
+        const NKMaterial& data = materials.getMaterial(material);
+        requestScreenSize(data.normalTexture, screenPixels);
+        requestScreenSize(data.diffuseTexture, screenPixels);
+        requestScreenSize(data.aoTexture, screenPixels);
+        requestScreenSize(data.roughnessTexture, screenPixels);
+    }
+
+    void NKTextureStreamer::update(VkDescriptorSet frameSet) {
+        NKUploadManager& uploadManager = device.getUploadManager();
+
+        //finished copies take over the slot, the images they replace wait out the frames still using them
+        for (auto& texture : textures) {
+            if (!texture.hasPending || !uploadManager.isComplete(texture.pendingTicket)) continue;
+
+            if (texture.pendingMip < texture.residentMip) {
+                stats.mipsStreamedIn += texture.residentMip - texture.pendingMip;
+            }
+            else {
+                stats.mipsEvicted += texture.pendingMip - texture.residentMip;
+            }
+            retireImage(texture.current);
+            texture.current = texture.pending;
+            texture.pending = {};
+            texture.residentMip = texture.pendingMip;
+            texture.hasPending = false;
+            materials.setTexture(texture.tableIndex, texture.current.view, sampler);
+        }
+        materials.updateSet(frameSet);
+
+        //each update rewrites one set, once all of them went past an image nothing in flight samples it
+        for (auto& old : retired) {
+            if (--old.updatesLeft == 0) {
+                destroyImage(old.image);
+            }
+        }
+        std::erase_if(retired, [](const RetiredImage& old) { return old.updatesLeft == 0; });
+
+        //a lowered budget
+        if (residentBytes > budget) {
+            evictFor(0);
+        }
+
+        //the textures missing the most mips first
+        candidates.clear();
+        for (uint32_t i = 0; i < textures.size(); ++i) {
+            if (!textures[i].hasPending && textures[i].requestedMip < textures[i].targetMip) {
+                candidates.push_back(i);
+            }
+        }
+        std::stable_sort(candidates.begin(), candidates.end(), [this](uint32_t a, uint32_t b) {
+            return textures[a].targetMip - textures[a].requestedMip > textures[b].targetMip - textures[b].requestedMip;
+        });
+
+        VkDeviceSize uploaded = 0;
+        for (uint32_t i : candidates) {
+            if (uploaded >= frameUploadLimit) break;
+
+            //the finest mip that fits, coarser ones still get the texture closer
+            StreamedTexture& texture = textures[i];
+            const VkDeviceSize targetBytes = getMipBytes(texture, texture.targetMip);
+            uint32_t mip = texture.requestedMip;
+            while (mip < texture.targetMip && residentBytes + getMipBytes(texture, mip) - targetBytes > budget
+                && !evictFor(getMipBytes(texture, mip) - targetBytes)) {
+                ++mip;
+            }
+
+            if (mip != texture.requestedMip) {
+                ++stats.budgetMisses;
+            }
+            if (mip < texture.targetMip) {
+                streamTo(texture, mip);
+                uploaded += getMipBytes(texture, mip);
+            }
+        }
+
+        for (auto& texture : textures) {
+            texture.requestedMip = texture.tailMip;
+        }
+        ++frame;
+    }
+
+    bool NKTextureStreamer::evictFor(VkDeviceSize bytes) {
+        //only textures nobody asked for this frame, the ones asked for longest ago first
+        evictions.clear();
+        VkDeviceSize evictableBytes = 0;
+        for (uint32_t i = 0; i < textures.size(); ++i) {
+            const StreamedTexture& texture = textures[i];
+            if (texture.hasPending || texture.targetMip == texture.tailMip || texture.lastRequestFrame == frame) continue;
+            evictions.push_back(i);
+            evictableBytes += getMipBytes(texture, texture.targetMip) - getMipBytes(texture, texture.tailMip);
+        }
+        if (residentBytes - std::min(evictableBytes, residentBytes) + bytes > budget) {
+            return false;//evicting everything would not be enough, keep what we have
+        }
+
+        std::sort(evictions.begin(), evictions.end(), [this](uint32_t a, uint32_t b) {
+            return textures[a].lastRequestFrame < textures[b].lastRequestFrame;
+        });
+        for (uint32_t i : evictions) {
+            if (residentBytes + bytes <= budget) break;
+            streamTo(textures[i], textures[i].tailMip);
+        }
+        return residentBytes + bytes <= budget;
+    }
+
+    VkDeviceSize NKTextureStreamer::getMipBytes(const StreamedTexture& texture, uint32_t firstMip) const {
+        //the mips are packed biggest first, everything from firstMip on is one range
+        const auto& mips = texture.file.mips;
+        return texture.file.data.size() - mips[firstMip].offset;
+    }
+
+    NKTextureStreamer::Image NKTextureStreamer::createImage(const StreamedTexture& texture, uint32_t firstMip) {
+        const auto& mip = texture.file.mips[firstMip];
+        const uint32_t mipCount = static_cast<uint32_t>(texture.file.mips.size()) - firstMip;
+
+        VkImageCreateInfo imageInfo{};
+        imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+        imageInfo.imageType = VK_IMAGE_TYPE_2D;
+        imageInfo.extent.width = mip.width;
+        imageInfo.extent.height = mip.height;
+        imageInfo.extent.depth = 1;
+        imageInfo.mipLevels = mipCount;
+        imageInfo.arrayLayers = 1;
+        imageInfo.format = texture.file.format;
+        imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+        imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        imageInfo.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+        imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+        imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+        Image image;
+        device.createImageWithInfo(imageInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, image.image, image.allocation);
+
+        VkImageViewCreateInfo viewInfo{};
+        viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+        viewInfo.image = image.image;
+        viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        viewInfo.format = texture.file.format;
+        viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        viewInfo.subresourceRange.baseMipLevel = 0;
+        viewInfo.subresourceRange.levelCount = mipCount;
+        viewInfo.subresourceRange.baseArrayLayer = 0;
+        viewInfo.subresourceRange.layerCount = 1;
+
+        if (vkCreateImageView(device.device(), &viewInfo, nullptr, &image.view) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create texture image view!");
+        }
+        return image;
+    }
+
+    void NKTextureStreamer::destroyImage(Image& image) {
+        vkDestroyImageView(device.device(), image.view, nullptr);
+        device.destroyImage(image.image, image.allocation);
+        image = {};
+    }
+
+    void NKTextureStreamer::retireImage(Image& image) {
+        retired.push_back({ image, static_cast<uint32_t>(NKSwapChain::MAX_FRAMES_IN_FLIGHT) });
+        image = {};
+    }
+
+    void NKTextureStreamer::streamTo(StreamedTexture& texture, uint32_t firstMip) {
+        assert(!texture.hasPending && "Texture already has a copy in flight");
+
+        Image image = createImage(texture, firstMip);
+
+        //everything from firstMip on is contiguous in the file, one staging copy
+        const auto& mips = texture.file.mips;
+        const VkDeviceSize size = getMipBytes(texture, firstMip);
+        NKUploadManager& uploadManager = device.getUploadManager();
+        NKStagingSpan staging = uploadManager.stage(size);
+        std::memcpy(staging.mapped, &texture.file.data[mips[firstMip].offset], static_cast<size_t>(size));
+
+        std::vector<uint32_t> mipSizes;
+        for (uint32_t mip = firstMip; mip < mips.size(); ++mip) {
+            mipSizes.push_back(mips[mip].size);
+        }
+        uploadManager.copyBufferToImage(staging, image.image, mips[firstMip].width, mips[firstMip].height, static_cast<uint32_t>(mipSizes.size()), mipSizes);
+
+        //loads start with nothing resident, their target mip is still 0
+        if (texture.current.image != VK_NULL_HANDLE) {
+            residentBytes -= getMipBytes(texture, texture.targetMip);
+        }
+        residentBytes += size;
+        stats.bytesUploaded += size;
+
+        texture.pending = image;
+        texture.pendingMip = firstMip;
+        texture.pendingTicket = uploadManager.lastTicket();
+        texture.hasPending = true;
+        texture.targetMip = firstMip;
+    }
+
+    uint32_t NKTextureStreamer::getResidentMip(uint32_t texture) const {
+        const StreamedTexture* streamed = findTexture(texture);
+        return streamed != nullptr ? streamed->residentMip : 0;
+    }
+
+    NKTextureStreamingStats NKTextureStreamer::getStats() const {
+        NKTextureStreamingStats result = stats;
+        result.textures = static_cast<uint32_t>(textures.size());
+        result.residentBytes = residentBytes;
+        return result;
+    }
+
+}  // namespace lve
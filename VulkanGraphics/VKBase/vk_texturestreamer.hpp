@@ -0,0 +1,128 @@
+#pragma once
+
+#include "vk_device.hpp"
+#include "vk_material.hpp"
+#include "vk_texture.hpp"
+
+// std
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nekographics {
+
+    struct NKTextureStreamingStats {
+        uint32_t textures = 0;
+        VkDeviceSize residentBytes = 0;//images the textures have or are streaming in, counted against the budget
+        VkDeviceSize fullBytes = 0;//what every mip of every texture would take
+        uint32_t mipsStreamedIn = 0;
+        uint32_t mipsEvicted = 0;
+        uint64_t bytesUploaded = 0;//loads included
+        uint32_t budgetMisses = 0;//requests left coarser than asked because the budget was full
+    };
+
+    /*
+    Textures whose mips are resident on demand. A load uploads the mip tail only, the mips up to
+    MIP_TAIL_SIZE texels, & keeps the file's mips in memory. Every frame the caller requests the finest
+    mip each texture needs, update() then streams the missing mips in through the batched upload path:
+    the texture gets a new image holding the requested mip & every coarser one, its material table slot
+    is switched over once the copy is done & the old image is destroyed when no frame in flight can still
+    sample it. When the new images would exceed the budget, the least recently requested textures drop
+    back to their mip tail first. Main thread only.
+    */
+    class NKTextureStreamer {
+    public:
+        static constexpr uint32_t MIP_TAIL_SIZE = 128;//longest side of the finest mip uploaded at load
+        static constexpr VkDeviceSize DEFAULT_BUDGET = 256ull * 1024 * 1024;
+        static constexpr VkDeviceSize DEFAULT_FRAME_UPLOAD = 16ull * 1024 * 1024;//streamed bytes started per update, at least one texture
+        static constexpr uint32_t INVALID_TEXTURE = ~0u;
+
+        NKTextureStreamer(NKDevice& device, NKMaterialTable& materials, VkDeviceSize budget = DEFAULT_BUDGET);
+        ~NKTextureStreamer();
+
+        NKTextureStreamer(const NKTextureStreamer&) = delete;
+        NKTextureStreamer& operator=(const NKTextureStreamer&) = delete;
+
+        //reads the dds & uploads its mip tail, returns the index in the material table. Like NKTexture the upload
+        //has to be done before a frame samples it, the requests below take that same index
+        uint32_t loadTexture(const std::string& filepath);
+
+        //finest mip the texture is needed at this frame, the finest of every request wins
+        void requestMip(uint32_t texture, uint32_t mip);
+        //the texture stretched once over screenPixels, the mip whose texels are about a pixel each
+        void requestScreenSize(uint32_t texture, float screenPixels);
+        //every texture of the material
+        void requestMaterial(uint32_t material, float screenPixels);
+
+        //once per frame before recording, frameSet is the global set of the frame being recorded
+        void update(VkDescriptorSet frameSet);
+
+        void setBudget(VkDeviceSize bytes) { budget = bytes; }//textures over it are evicted by the next update
+        VkDeviceSize getBudget() const { return budget; }
+        void setFrameUploadLimit(VkDeviceSize bytes) { frameUploadLimit = bytes; }
+
+        uint32_t getResidentMip(uint32_t texture) const;//finest mip the shaders can sample right now
+        NKTextureStreamingStats getStats() const;
+
+    private:
+        struct Image {
+            VkImage image = VK_NULL_HANDLE;
+            NKAllocation allocation;
+            VkImageView view = VK_NULL_HANDLE;
+        };
+
+        struct StreamedTexture {
+            NKDDSImage file;
+            uint32_t tableIndex = 0;
+            uint32_t tailMip = 0;//first mip of the tail, never evicted
+
+            Image current;//what the material table points at, holds residentMip & every coarser mip
+            uint32_t residentMip = 0;
+
+            Image pending;//copy in flight, swapped in once its ticket completes
+            uint32_t pendingMip = 0;
+            uint64_t pendingTicket = 0;
+            bool hasPending = false;
+
+            uint32_t targetMip = 0;//residentMip, or pendingMip while one is in flight
+            uint32_t requestedMip = 0;//finest mip asked for since the last update
+            uint64_t lastRequestFrame = 0;
+        };
+
+        struct RetiredImage {
+            Image image;
+            uint32_t updatesLeft;//destroyed once every global set was rewritten without it
+        };
+
+        //null for material table slots this streamer didn't load
+        StreamedTexture* findTexture(uint32_t texture);
+        const StreamedTexture* findTexture(uint32_t texture) const;
+
+        VkDeviceSize getMipBytes(const StreamedTexture& texture, uint32_t firstMip) const;//firstMip & every coarser one
+        Image createImage(const StreamedTexture& texture, uint32_t firstMip);
+        void destroyImage(Image& image);
+        void retireImage(Image& image);
+
+        //creates the image & records the copy, the texture points at it once the upload completes
+        void streamTo(StreamedTexture& texture, uint32_t firstMip);
+        bool evictFor(VkDeviceSize bytes);//drops the least recently requested textures to their tail, true if bytes now fit
+
+        NKDevice& device;
+        NKMaterialTable& materials;
+        VkSampler sampler;//from the device's sampler cache
+
+        VkDeviceSize budget;
+        VkDeviceSize frameUploadLimit = DEFAULT_FRAME_UPLOAD;
+        VkDeviceSize residentBytes = 0;//every texture's targetMip image
+        uint64_t frame = 1;//requests are tagged with it, bumped at the end of every update
+
+        std::vector<StreamedTexture> textures;//in load order
+        std::vector<uint32_t> tableToTexture;//material table index -> textures, INVALID_TEXTURE for textures added elsewhere
+        std::vector<RetiredImage> retired;
+        std::vector<uint32_t> candidates;//update scratch
+        std::vector<uint32_t> evictions;//evictFor scratch
+
+        NKTextureStreamingStats stats;
+    };
+
+}  // namespace lve
@@ -0,0 +1,496 @@
+//includes
+#include "vk_upload.hpp"
+#include "vk_device.hpp"
+
+// std
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace nekographics {
+
+    static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment) {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    NKUploadManager::NKUploadManager(NKDevice& uploadDevice, VkDeviceSize size) : device{ uploadDevice }, ringSize{ size } {
+        QueueFamilyIndices queueFamilyIndices = device.findPhysicalQueueFamilies();
+        dedicatedTransfer = device.hasDedicatedTransferQueue();
+        transferFamily = queueFamilyIndices.transferFamily;
+        graphicsFamily = queueFamilyIndices.graphicsFamily;
+
+        VkCommandPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = transferFamily;
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+            throw std::runtime_error("failed to create upload command pool!");
+        }
+
+        //the ownership acquire has to be recorded for the graphics family
+        if (dedicatedTransfer) {
+            poolInfo.queueFamilyIndex = graphicsFamily;
+            if (vkCreateCommandPool(device.device(), &poolInfo, nullptr, &acquirePool) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create upload acquire command pool!");
+            }
+        }
+
+        //buffer to image copies want the offset aligned to the texel block, 16 covers every BC format
+        minCopyAlignment = std::max<VkDeviceSize>(16, device.properties.limits.optimalBufferCopyOffsetAlignment);
+
+        //coherent so staged writes never need a flush
+        device.createBuffer(
+            ringSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            ringBuffer,
+            ringAllocation);
+    }
+
+    NKUploadManager::~NKUploadManager() {
+        waitIdle();
+
+        for (auto& batch : freeBatches) {
+            vkDestroyFence(device.device(), batch.fence, nullptr);
+            if (batch.transferDone != VK_NULL_HANDLE) {
+                vkDestroySemaphore(device.device(), batch.transferDone, nullptr);
+            }
+        }
+        device.destroyBuffer(ringBuffer, ringAllocation);
+        vkDestroyCommandPool(device.device(), commandPool, nullptr);//frees every batch command buffer
+        if (acquirePool != VK_NULL_HANDLE) {
+            vkDestroyCommandPool(device.device(), acquirePool, nullptr);
+        }
+    }
+
+    bool NKUploadManager::tryAllocateRing(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset) {
+        //nothing in use, start from the front so big uploads have the whole ring
+        if (ringUsed == 0) {
+            ringHead = ringTail = 0;
+        }
+
+        VkDeviceSize aligned = alignUp(ringHead, alignment);
+        VkDeviceSize consumed = 0;
+
+        if (ringHead > ringTail || ringUsed == 0) {
+            //free space is [ringHead, ringSize) followed by [0, ringTail)
+            if (aligned + size <= ringSize) {
+                outOffset = aligned;
+                consumed = aligned + size - ringHead;
+            }
+            else if (size <= ringTail) {
+                //wrap around, the end of the ring is wasted until this batch retires
+                outOffset = 0;
+                consumed = ringSize - ringHead + size;
+            }
+            else {
+                return false;
+            }
+        }
+        else {
+            //free space is [ringHead, ringTail), or nothing when the ring is full
+            if (aligned + size > ringTail) {
+                return false;
+            }
+            outOffset = aligned;
+            consumed = aligned + size - ringHead;
+        }
+
+        ringHead = outOffset + size;
+        ringUsed += consumed;
+        currentBatch().ringBytes += consumed;
+        return true;
+    }
+
+    NKStagingSpan NKUploadManager::stage(VkDeviceSize size, VkDeviceSize alignment) {
+        alignment = std::max(alignment, minCopyAlignment);
+
+        //too big for the ring, use a one off staging buffer that lives as long as the batch
+        if (size + alignment > ringSize) {
+            std::pair<VkBuffer, NKAllocation> oversized{};
+            device.createBuffer(
+                size,
+                VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                oversized.first,
+                oversized.second);
+            currentBatch().oversizedBuffers.push_back(oversized);
+            stats.oversizedUploads++;
+            return NKStagingSpan{ oversized.second.mapped, oversized.first, 0, size };
+        }
+
+        VkDeviceSize offset = 0;
+        if (!tryAllocateRing(size, alignment, offset)) {
+            stats.ringStalls++;
+
+            //hand what we have to the gpu & wait for the oldest batch until enough space frees up
+            do {
+                submitBatch();
+                if (transferring.empty() && inFlight.empty()) {
+                    throw std::runtime_error("failed to allocate staging memory!");
+                }
+                retireBatches(true);
+            } while (!tryAllocateRing(size, alignment, offset));
+        }
+
+        return NKStagingSpan{ static_cast<char*>(ringAllocation.mapped) + offset, ringBuffer, offset, size };
+    }
+
+    void NKUploadManager::copyBuffer(const NKStagingSpan& src, VkBuffer dstBuffer, VkDeviceSize dstOffset) {
+        VkBufferCopy copyRegion{};
+        copyRegion.srcOffset = src.offset;
+        copyRegion.dstOffset = dstOffset;
+        copyRegion.size = src.size;
+        Batch& batch = currentBatch();
+        vkCmdCopyBuffer(batch.commandBuffer, src.buffer, dstBuffer, 1, &copyRegion);
+
+        //hand the written range over to the graphics family once the batch is done
+        if (dedicatedTransfer) {
+            VkBufferMemoryBarrier ownership{};
+            ownership.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+            ownership.srcQueueFamilyIndex = transferFamily;
+            ownership.dstQueueFamilyIndex = graphicsFamily;
+            ownership.buffer = dstBuffer;
+            ownership.offset = dstOffset;
+            ownership.size = src.size;
+            batch.bufferOwnership.push_back(ownership);
+        }
+
+        stats.bytesUploaded += src.size;
+        stats.copiesRecorded++;
+    }
+
+    void NKUploadManager::copyBufferToImage(
+        const NKStagingSpan& src, VkImage image, uint32_t width, uint32_t height, uint32_t mipCount, const std::vector<uint32_t>& mipSizes) {
+        Batch& batch = currentBatch();
+        VkCommandBuffer commandBuffer = batch.commandBuffer;
+
+        VkImageMemoryBarrier barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = mipCount;
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = 1;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(
+            commandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+            0,
+            0, nullptr,
+            0, nullptr,
+            1, &barrier);
+
+        // Setup buffer copy regions for each mip level
+        std::vector<VkBufferImageCopy> bufferCopyRegions{};
+        VkDeviceSize offset = src.offset;
+        uint32_t mipWidth = width;
+        uint32_t mipHeight = height;
+
+        for (uint32_t i = 0; i < mipCount; i++) {
+            bufferCopyRegions.emplace_back(
+                VkBufferImageCopy{
+                    .bufferOffset = offset
+                ,   .imageSubresource
+                    {
+                        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT
+                    ,   .mipLevel = i
+                    ,   .baseArrayLayer = 0
+                    ,   .layerCount = 1
+                    }
+                ,   .imageExtent
+                    {
+                        .width = mipWidth
+                    ,   .height = mipHeight
+                    ,   .depth = 1
+                    }
+                });
+
+            // Get ready for next mip
+            mipWidth = std::max(1u, mipWidth >> 1);
+            mipHeight = std::max(1u, mipHeight >> 1);
+            offset += mipSizes[i];
+        }
+
+        vkCmdCopyBufferToImage(commandBuffer
+            , src.buffer
+            , image
+            , VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+            , static_cast<uint32_t>(bufferCopyRegions.size())
+            , bufferCopyRegions.data());
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        if (dedicatedTransfer) {
+            //the layout change happens as part of the release/acquire pair recorded at submit
+            barrier.srcQueueFamilyIndex = transferFamily;
+            barrier.dstQueueFamilyIndex = graphicsFamily;
+            batch.imageOwnership.push_back(barrier);
+        }
+        else {
+            vkCmdPipelineBarrier(
+                commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                0,
+                0, nullptr,
+                0, nullptr,
+                1, &barrier);
+        }
+
+        stats.bytesUploaded += src.size;
+        stats.copiesRecorded++;
+    }
+
+    void NKUploadManager::uploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset) {
+        NKStagingSpan span = stage(size, 4);
+        std::memcpy(span.mapped, data, static_cast<size_t>(size));
+        copyBuffer(span, dstBuffer, dstOffset);
+    }
+
+    void NKUploadManager::flush() {
+        submitBatch();
+        retireBatches(false);
+    }
+
+    void NKUploadManager::waitIdle() {
+        submitBatch();
+        while (!transferring.empty() || !inFlight.empty()) {
+            retireBatches(true);
+        }
+    }
+
+    NKUploadManager::Batch& NKUploadManager::currentBatch() {
+        if (isRecording) {
+            lastRecordedTicket = recording.ticket;
+            return recording;
+        }
+
+        //reuse a retired batch when there is one
+        if (!freeBatches.empty()) {
+            recording = std::move(freeBatches.back());
+            freeBatches.pop_back();
+        }
+        else {
+            recording = Batch{};
+
+            VkCommandBufferAllocateInfo allocInfo{};
+            allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+            allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+            allocInfo.commandPool = commandPool;
+            allocInfo.commandBufferCount = 1;
+
+            if (vkAllocateCommandBuffers(device.device(), &allocInfo, &recording.commandBuffer) != VK_SUCCESS) {
+                throw std::runtime_error("failed to allocate upload command buffer!");
+            }
+
+            VkFenceCreateInfo fenceInfo{};
+            fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            if (vkCreateFence(device.device(), &fenceInfo, nullptr, &recording.fence) != VK_SUCCESS) {
+                throw std::runtime_error("failed to create upload fence!");
+            }
+
+            if (dedicatedTransfer) {
+                allocInfo.commandPool = acquirePool;
+                if (vkAllocateCommandBuffers(device.device(), &allocInfo, &recording.acquireCommandBuffer) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to allocate upload acquire command buffer!");
+                }
+
+                VkSemaphoreCreateInfo semaphoreInfo{};
+                semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+                if (vkCreateSemaphore(device.device(), &semaphoreInfo, nullptr, &recording.transferDone) != VK_SUCCESS) {
+                    throw std::runtime_error("failed to create upload semaphore!");
+                }
+            }
+        }
+
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(recording.commandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin recording upload command buffer!");
+        }
+
+        recording.ticket = nextTicket++;
+        lastRecordedTicket = recording.ticket;
+        isRecording = true;
+        return recording;
+    }
+
+    void NKUploadManager::submitBatch() {
+        if (!isRecording) {
+            return;
+        }
+
+        if (dedicatedTransfer) {
+            //release half of the ownership transfer, dst stage & access are ignored for a release
+            std::vector<VkBufferMemoryBarrier> bufferRelease = recording.bufferOwnership;
+            for (auto& barrier : bufferRelease) {
+                barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+                barrier.dstAccessMask = 0;
+            }
+            std::vector<VkImageMemoryBarrier> imageRelease = recording.imageOwnership;
+            for (auto& barrier : imageRelease) {
+                barrier.dstAccessMask = 0;
+            }
+
+            vkCmdPipelineBarrier(
+                recording.commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                0,
+                0, nullptr,
+                static_cast<uint32_t>(bufferRelease.size()), bufferRelease.data(),
+                static_cast<uint32_t>(imageRelease.size()), imageRelease.data());
+        }
+        else {
+            //make the copied buffers visible to anything submitted after this batch
+            VkMemoryBarrier memoryBarrier{};
+            memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            memoryBarrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+
+            vkCmdPipelineBarrier(
+                recording.commandBuffer,
+                VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                0,
+                1, &memoryBarrier,
+                0, nullptr,
+                0, nullptr);
+        }
+
+        if (vkEndCommandBuffer(recording.commandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to record upload command buffer!");
+        }
+
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &recording.commandBuffer;
+        if (dedicatedTransfer) {
+            submitInfo.signalSemaphoreCount = 1;
+            submitInfo.pSignalSemaphores = &recording.transferDone;
+        }
+
+        if (vkQueueSubmit(device.transferQueue(), 1, &submitInfo, recording.fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit upload command buffer!");
+        }
+
+        recording.ringEnd = ringHead;
+        if (dedicatedTransfer) {
+            transferring.push_back(std::move(recording));
+        }
+        else {
+            //same queue as rendering, anything submitted from now on sees the copies
+            completedTicket = recording.ticket;
+            inFlight.push_back(std::move(recording));
+        }
+        recording = Batch{};
+        isRecording = false;
+        stats.batchesSubmitted++;
+    }
+
+    void NKUploadManager::submitAcquire(Batch& batch) {
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+        if (vkBeginCommandBuffer(batch.acquireCommandBuffer, &beginInfo) != VK_SUCCESS) {
+            throw std::runtime_error("failed to begin recording upload acquire command buffer!");
+        }
+
+        //acquire half, src stage & access are ignored, the semaphore orders it after the release
+        for (auto& barrier : batch.bufferOwnership) {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        }
+        for (auto& barrier : batch.imageOwnership) {
+            barrier.srcAccessMask = 0;
+        }
+
+        vkCmdPipelineBarrier(
+            batch.acquireCommandBuffer,
+            VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+            0,
+            0, nullptr,
+            static_cast<uint32_t>(batch.bufferOwnership.size()), batch.bufferOwnership.data(),
+            static_cast<uint32_t>(batch.imageOwnership.size()), batch.imageOwnership.data());
+
+        if (vkEndCommandBuffer(batch.acquireCommandBuffer) != VK_SUCCESS) {
+            throw std::runtime_error("failed to record upload acquire command buffer!");
+        }
+
+        VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        VkSubmitInfo submitInfo{};
+        submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &batch.transferDone;
+        submitInfo.pWaitDstStageMask = &waitStage;
+        submitInfo.commandBufferCount = 1;
+        submitInfo.pCommandBuffers = &batch.acquireCommandBuffer;
+
+        vkResetFences(device.device(), 1, &batch.fence);
+        if (vkQueueSubmit(device.graphicsQueue(), 1, &submitInfo, batch.fence) != VK_SUCCESS) {
+            throw std::runtime_error("failed to submit upload acquire command buffer!");
+        }
+
+        completedTicket = batch.ticket;
+    }
+
+    void NKUploadManager::retireBatches(bool waitForOldest) {
+        //nothing left to wait on in the last stage, wait for the oldest copies instead
+        if (waitForOldest && inFlight.empty() && !transferring.empty()) {
+            vkWaitForFences(device.device(), 1, &transferring.front().fence, VK_TRUE, UINT64_MAX);
+        }
+
+        //copies that are done get acquired by graphics, the semaphore is already signalled so this never stalls rendering
+        while (!transferring.empty() && vkGetFenceStatus(device.device(), transferring.front().fence) == VK_SUCCESS) {
+            submitAcquire(transferring.front());
+            inFlight.push_back(std::move(transferring.front()));
+            transferring.pop_front();
+        }
+
+        if (waitForOldest && !inFlight.empty()) {
+            vkWaitForFences(device.device(), 1, &inFlight.front().fence, VK_TRUE, UINT64_MAX);
+        }
+
+        //batches finish in submission order, stop at the first one still running
+        while (!inFlight.empty() && vkGetFenceStatus(device.device(), inFlight.front().fence) == VK_SUCCESS) {
+            Batch& batch = inFlight.front();
+            ringTail = batch.ringEnd;
+            ringUsed -= batch.ringBytes;
+            releaseBatch(batch);
+            inFlight.pop_front();
+        }
+    }
+
+    void NKUploadManager::releaseBatch(Batch& batch) {
+        for (auto& [buffer, allocation] : batch.oversizedBuffers) {
+            device.destroyBuffer(buffer, allocation);
+        }
+
+        vkResetFences(device.device(), 1, &batch.fence);
+        vkResetCommandBuffer(batch.commandBuffer, 0);
+        if (batch.acquireCommandBuffer != VK_NULL_HANDLE) {
+            vkResetCommandBuffer(batch.acquireCommandBuffer, 0);
+        }
+
+        Batch recycled{};
+        recycled.commandBuffer = batch.commandBuffer;
+        recycled.acquireCommandBuffer = batch.acquireCommandBuffer;
+        recycled.transferDone = batch.transferDone;
+        recycled.fence = batch.fence;
+        freeBatches.push_back(std::move(recycled));
+    }
+
+}  // namespace lve
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "vk_allocator.hpp"
+#include <vulkan/vulkan.h>
+
+// std lib headers
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace nekographics {
+
+    class NKDevice;
+
+    //a piece of the staging ring, write into mapped then hand it to one of the copy functions
+    struct NKStagingSpan {
+        void* mapped = nullptr;
+        VkBuffer buffer = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+    };
+
+    struct NKUploadStats {
+        uint64_t bytesUploaded = 0;
+        uint32_t copiesRecorded = 0;
+        uint32_t batchesSubmitted = 0;
+        uint32_t ringStalls = 0;//times the ring was full & we had to wait on the gpu
+        uint32_t oversizedUploads = 0;//uploads too big for the ring, given their own staging buffer
+    };
+
+    /*
+    Batches resource uploads through one persistently mapped staging ring. Copies are recorded
+    into a shared command buffer & submitted together with a fence, ring space is recycled once
+    that fence signals, so nothing waits on the queue unless the ring runs out of space.
+
+    When the device has a dedicated transfer queue the copies run there & every resource is
+    released to the graphics family, the matching acquire is only submitted on the graphics
+    queue once the copies are done so rendering never waits on a stream. Every copy belongs to
+    a batch ticket, isComplete(ticket) tells when graphics work submitted from then on may use it.
+    NKRenderer::endFrame flushes every frame.
+    */
+    class NKUploadManager {
+    public:
+        static constexpr VkDeviceSize DEFAULT_RING_SIZE = 32ull * 1024 * 1024;
+
+        NKUploadManager(NKDevice& device, VkDeviceSize ringSize = DEFAULT_RING_SIZE);
+        ~NKUploadManager();
+
+        NKUploadManager(const NKUploadManager&) = delete;
+        NKUploadManager& operator=(const NKUploadManager&) = delete;
+
+        /**
+         * Reserves staging memory, may wait on older batches if the ring is full
+         *
+         * @param size Size in bytes
+         * @param alignment Required alignment of the offset inside the staging buffer
+         *
+         * @return NKStagingSpan to write the data into
+         */
+        NKStagingSpan stage(VkDeviceSize size, VkDeviceSize alignment = 16);
+
+        /**
+         * Records a copy from a staged span into a buffer
+         *
+         * @param dstOffset (Optional) Byte offset into the destination buffer
+         */
+        void copyBuffer(const NKStagingSpan& src, VkBuffer dstBuffer, VkDeviceSize dstOffset = 0);
+
+        /**
+         * Records the layout transitions & the copy of tightly packed mips into an image,
+         * the image ends up in SHADER_READ_ONLY_OPTIMAL
+         *
+         * @param mipSizes Byte size of every mip level in the span, biggest mip first
+         */
+        void copyBufferToImage(
+            const NKStagingSpan& src, VkImage image, uint32_t width, uint32_t height, uint32_t mipCount, const std::vector<uint32_t>& mipSizes);
+
+        /**
+         * Stages data & records the copy into a buffer in one go
+         */
+        void uploadBuffer(VkBuffer dstBuffer, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0);
+
+        //submits the recorded copies without waiting, acquires finished transfers & recycles old batches
+        void flush();
+
+        //submits & waits for every upload to finish
+        void waitIdle();
+
+        //ticket of the batch holding the most recent copy
+        uint64_t lastTicket() const { return lastRecordedTicket; }
+
+        //true once graphics work submitted from now on is ordered after the batch's copies
+        bool isComplete(uint64_t ticket) const { return ticket <= completedTicket; }
+
+        const NKUploadStats& getStats() const { return stats; }
+
+    private:
+        struct Batch {
+            uint64_t ticket = 0;
+            VkCommandBuffer commandBuffer = VK_NULL_HANDLE;//copies, recorded for the transfer queue
+            VkCommandBuffer acquireCommandBuffer = VK_NULL_HANDLE;//ownership acquire on the graphics queue
+            VkSemaphore transferDone = VK_NULL_HANDLE;//copies -> acquire
+            VkFence fence = VK_NULL_HANDLE;//signalled by the transfer submit, then reused for the acquire
+            VkDeviceSize ringEnd = 0;//ring head when the batch was submitted
+            VkDeviceSize ringBytes = 0;//ring bytes (with padding) the batch used
+            std::vector<std::pair<VkBuffer, NKAllocation>> oversizedBuffers;//freed with the batch
+            std::vector<VkBufferMemoryBarrier> bufferOwnership;//release on transfer, acquire on graphics
+            std::vector<VkImageMemoryBarrier> imageOwnership;
+        };
+
+        bool tryAllocateRing(VkDeviceSize size, VkDeviceSize alignment, VkDeviceSize& outOffset);
+        Batch& currentBatch();
+        void submitBatch();
+        void submitAcquire(Batch& batch);
+        void retireBatches(bool waitForOldest);
+        void releaseBatch(Batch& batch);
+
+        NKDevice& device;
+        bool dedicatedTransfer = false;
+        uint32_t transferFamily = 0;
+        uint32_t graphicsFamily = 0;
+        VkCommandPool commandPool = VK_NULL_HANDLE;//transfer family
+        VkCommandPool acquirePool = VK_NULL_HANDLE;//graphics family, only with a dedicated transfer queue
+        VkDeviceSize minCopyAlignment = 16;
+
+        //staging ring, [ringTail, ringHead) is in use by recording or in flight batches
+        VkBuffer ringBuffer = VK_NULL_HANDLE;
+        NKAllocation ringAllocation;
+        VkDeviceSize ringSize = 0;
+        VkDeviceSize ringHead = 0;
+        VkDeviceSize ringTail = 0;
+        VkDeviceSize ringUsed = 0;
+
+        Batch recording;//batch copies are being recorded into, commandBuffer is null until the first copy
+        bool isRecording = false;
+        std::deque<Batch> transferring;//copies submitted, waiting to be acquired by graphics, oldest first
+        std::deque<Batch> inFlight;//last submit done, waiting for the fence, oldest first
+        std::vector<Batch> freeBatches;//command buffers, semaphores & fences ready for reuse
+
+        uint64_t nextTicket = 1;
+        uint64_t lastRecordedTicket = 0;
+        uint64_t completedTicket = 0;
+
+        NKUploadStats stats;
+    };
+
+}  // namespace lve